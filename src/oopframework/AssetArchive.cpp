@@ -0,0 +1,373 @@
+#include <AssetArchive.h>
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+static char const ARCHIVE_MAGIC[4] = { 'O', 'P', 'A', 'K' };
+static unsigned const ARCHIVE_VERSION = 1;
+// the size of the fixed part of the header: magic, version, number of entries and alignment
+static unsigned const HEADER_SIZE = 16;
+
+// the codec is a byte oriented LZ77 variant: every sequence starts with a token, whose high nibble is the number of
+// literals and whose low nibble is the match length minus MIN_MATCH (15 means that more length bytes follow).
+// The literals are followed by a 16 bit offset of the match. The last sequence consists of literals only.
+static unsigned const MIN_MATCH = 4;
+static unsigned const MAX_OFFSET = 65535;
+static unsigned const HASH_BITS = 14;
+
+AssetArchive::AssetArchive() :
+	mData_(NULL),
+	mSize_(0)
+#ifdef _WIN32
+	,mFile_(INVALID_HANDLE_VALUE),
+	mMapping_(NULL)
+#endif
+{
+}
+
+bool
+AssetArchive::open( std::string const& path, std::string& error ) {
+	close();
+	mPath_ = path;
+#ifdef _WIN32
+	mFile_ = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL );
+	if( mFile_ == INVALID_HANDLE_VALUE ) {
+		error = "Could not open archive '" + path + "'.";
+		return false;
+	}
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( mFile_, &size ) || size.QuadPart < HEADER_SIZE ) {
+		error = "Archive '" + path + "' is too small.";
+		close();
+		return false;
+	}
+	mSize_ = (unsigned long long)size.QuadPart;
+	mMapping_ = CreateFileMappingA( mFile_, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mMapping_ != NULL )
+		mData_ = (unsigned char const*)MapViewOfFile( mMapping_, FILE_MAP_READ, 0, 0, 0 );
+#else
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if( fd < 0 ) {
+		error = "Could not open archive '" + path + "'.";
+		return false;
+	}
+	struct stat info;
+	if( fstat( fd, &info ) != 0 || info.st_size < (off_t)HEADER_SIZE ) {
+		error = "Archive '" + path + "' is too small.";
+		::close( fd );
+		return false;
+	}
+	mSize_ = (unsigned long long)info.st_size;
+	void* data = mmap( NULL, (size_t)mSize_, PROT_READ, MAP_SHARED, fd, 0 );
+	// the mapping keeps its own reference to the file
+	::close( fd );
+	if( data != MAP_FAILED )
+		mData_ = (unsigned char const*)data;
+#endif
+	if( mData_ == NULL ) {
+		error = "Could not map archive '" + path + "' into memory.";
+		close();
+		return false;
+	}
+
+	// parse the table of contents, the fields of the entries are not aligned
+	unsigned header[3];
+	std::memcpy( header, mData_ + 4, sizeof(header) );
+	if( std::memcmp( mData_, ARCHIVE_MAGIC, 4 ) != 0 || header[0] != ARCHIVE_VERSION ) {
+		error = "'" + path + "' is no archive or of an old version.";
+		close();
+		return false;
+	}
+	unsigned long long pos = HEADER_SIZE;
+	for( unsigned i = 0; i < header[1]; ++i ) {
+		unsigned nameLength;
+		if( pos + sizeof(nameLength) > mSize_ ) {
+			error = "The table of contents of archive '" + path + "' is truncated.";
+			close();
+			return false;
+		}
+		std::memcpy( &nameLength, mData_ + pos, sizeof(nameLength) );
+		pos += sizeof(nameLength);
+		if( pos + nameLength + 3 * sizeof(unsigned long long) + sizeof(unsigned) > mSize_ ) {
+			error = "The table of contents of archive '" + path + "' is truncated.";
+			close();
+			return false;
+		}
+		std::string name( (char const*)mData_ + pos, nameLength );
+		pos += nameLength;
+		AssetEntry entry;
+		entry.archive = this;
+		std::memcpy( &entry.offset, mData_ + pos, sizeof(entry.offset) );
+		pos += sizeof(entry.offset);
+		std::memcpy( &entry.size, mData_ + pos, sizeof(entry.size) );
+		pos += sizeof(entry.size);
+		std::memcpy( &entry.originalSize, mData_ + pos, sizeof(entry.originalSize) );
+		pos += sizeof(entry.originalSize);
+		std::memcpy( &entry.compression, mData_ + pos, sizeof(entry.compression) );
+		pos += sizeof(entry.compression);
+		if( entry.offset > mSize_ || entry.size > mSize_ - entry.offset || entry.compression > COMPRESSION_LZ ) {
+			error = "Entry '" + name + "' of archive '" + path + "' is corrupted.";
+			close();
+			return false;
+		}
+		mEntries_[name] = entry;
+	}
+	return true;
+}
+
+bool
+AssetArchive::find( std::string const& name, AssetEntry& entry ) const {
+	std::tr1::unordered_map< std::string, AssetEntry >::const_iterator it = mEntries_.find( name );
+	if( it == mEntries_.end() )
+		return false;
+	entry = it->second;
+	return true;
+}
+
+bool
+AssetArchive::read( AssetEntry const& entry, std::vector< unsigned char >& buffer, void const*& data, unsigned& size ) const {
+	if( mData_ == NULL || entry.archive != this )
+		return false;
+	if( entry.compression == COMPRESSION_NONE ) {
+		data = mData_ + entry.offset;
+		size = (unsigned)entry.size;
+		return true;
+	}
+	buffer.resize( (size_t)entry.originalSize );
+	if( !decompress( mData_ + entry.offset, entry.size, buffer ) )
+		return false;
+	data = buffer.empty() ? NULL : &buffer[0];
+	size = (unsigned)buffer.size();
+	return true;
+}
+
+std::string const&
+AssetArchive::getPath() const {
+	return mPath_;
+}
+
+unsigned
+AssetArchive::getEntryCount() const {
+	return (unsigned)mEntries_.size();
+}
+
+void
+AssetArchive::close() {
+	mEntries_.clear();
+#ifdef _WIN32
+	if( mData_ != NULL )
+		UnmapViewOfFile( mData_ );
+	if( mMapping_ != NULL )
+		CloseHandle( mMapping_ );
+	if( mFile_ != INVALID_HANDLE_VALUE )
+		CloseHandle( mFile_ );
+	mMapping_ = NULL;
+	mFile_ = INVALID_HANDLE_VALUE;
+#else
+	if( mData_ != NULL )
+		munmap( (void*)mData_, (size_t)mSize_ );
+#endif
+	mData_ = NULL;
+	mSize_ = 0;
+}
+
+bool
+AssetArchive::write( std::string const& path, std::vector< std::string > const& names,
+					 std::vector< std::vector< unsigned char > > const& files, bool compress, std::string& error ) {
+	if( names.size() != files.size() ) {
+		error = "The number of names and files differs.";
+		return false;
+	}
+	// compress the payloads first, the table of contents needs their sizes
+	std::vector< std::vector< unsigned char > > packed( files.size() );
+	// a copy of the constant, the vector takes a reference and the constant has no definition to bind it to
+	std::vector< unsigned > compression( files.size(), (unsigned)COMPRESSION_NONE );
+	if( compress ) {
+		for( unsigned i = 0; i < files.size(); ++i ) {
+			AssetArchive::compress( files[i], packed[i] );
+			if( packed[i].size() < files[i].size() - files[i].size() / 20 )
+				compression[i] = COMPRESSION_LZ;
+			else
+				packed[i].clear();
+		}
+	}
+
+	unsigned long long tocSize = HEADER_SIZE;
+	for( unsigned i = 0; i < names.size(); ++i )
+		tocSize += sizeof(unsigned) + names[i].size() + 3 * sizeof(unsigned long long) + sizeof(unsigned);
+	std::vector< unsigned long long > offsets( files.size() );
+	unsigned long long offset = tocSize;
+	for( unsigned i = 0; i < files.size(); ++i ) {
+		offset = ( offset + ALIGNMENT - 1 ) / ALIGNMENT * ALIGNMENT;
+		offsets[i] = offset;
+		offset += compression[i] == COMPRESSION_LZ ? packed[i].size() : files[i].size();
+	}
+
+	std::ofstream file( path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !file ) {
+		error = "Could not create archive '" + path + "'.";
+		return false;
+	}
+	unsigned header[3] = { ARCHIVE_VERSION, (unsigned)names.size(), ALIGNMENT };
+	file.write( ARCHIVE_MAGIC, 4 );
+	file.write( (char const*)header, sizeof(header) );
+	for( unsigned i = 0; i < names.size(); ++i ) {
+		unsigned nameLength = (unsigned)names[i].size();
+		std::vector< unsigned char > const& payload = compression[i] == COMPRESSION_LZ ? packed[i] : files[i];
+		unsigned long long sizes[3] = { offsets[i], (unsigned long long)payload.size(), (unsigned long long)files[i].size() };
+		file.write( (char const*)&nameLength, sizeof(nameLength) );
+		file.write( names[i].data(), nameLength );
+		file.write( (char const*)sizes, sizeof(sizes) );
+		file.write( (char const*)&compression[i], sizeof(compression[i]) );
+	}
+	unsigned long long pos = tocSize;
+	char const padding[ALIGNMENT] = { 0 };
+	for( unsigned i = 0; i < files.size(); ++i ) {
+		file.write( padding, (std::streamsize)( offsets[i] - pos ) );
+		std::vector< unsigned char > const& payload = compression[i] == COMPRESSION_LZ ? packed[i] : files[i];
+		if( !payload.empty() )
+			file.write( (char const*)&payload[0], payload.size() );
+		pos = offsets[i] + payload.size();
+	}
+	file.close();
+	if( !file ) {
+		error = "Could not write archive '" + path + "'.";
+		std::remove( path.c_str() );
+		return false;
+	}
+	return true;
+}
+
+/** This helper function writes a length, which doesn't fit into the nibble of a token.
+ */
+static void
+writeLength( std::vector< unsigned char >& out, unsigned length ) {
+	while( length >= 255 ) {
+		out.push_back( 255 );
+		length -= 255;
+	}
+	out.push_back( (unsigned char)length );
+}
+
+/** This helper function writes a sequence of literals followed by a match (if matchLength isn't 0).
+ */
+static void
+writeSequence( std::vector< unsigned char >& out, unsigned char const* literals, unsigned numLiterals,
+			   unsigned matchLength, unsigned offset ) {
+	unsigned litToken = numLiterals < 15 ? numLiterals : 15;
+	unsigned matchToken = 0;
+	if( matchLength != 0 )
+		matchToken = matchLength - MIN_MATCH < 15 ? matchLength - MIN_MATCH : 15;
+	out.push_back( (unsigned char)( ( litToken << 4 ) | matchToken ) );
+	if( litToken == 15 )
+		writeLength( out, numLiterals - 15 );
+	out.insert( out.end(), literals, literals + numLiterals );
+	if( matchLength == 0 )
+		return;
+	out.push_back( (unsigned char)( offset & 0xff ) );
+	out.push_back( (unsigned char)( offset >> 8 ) );
+	if( matchToken == 15 )
+		writeLength( out, matchLength - MIN_MATCH - 15 );
+}
+
+void
+AssetArchive::compress( std::vector< unsigned char > const& in, std::vector< unsigned char >& out ) {
+	out.clear();
+	out.reserve( in.size() + in.size() / 255 + 16 );
+	unsigned size = (unsigned)in.size();
+	if( size == 0 ) {
+		out.push_back( 0 );
+		return;
+	}
+	unsigned char const* src = &in[0];
+	// the last position of every hashed 4 byte sequence (greedy matching, one candidate per hash)
+	std::vector< unsigned > table( 1 << HASH_BITS, 0xffffffff );
+	unsigned anchor = 0;
+	unsigned pos = 0;
+	while( pos + MIN_MATCH <= size ) {
+		unsigned sequence;
+		std::memcpy( &sequence, src + pos, sizeof(sequence) );
+		unsigned hash = ( sequence * 2654435761u ) >> ( 32 - HASH_BITS );
+		unsigned candidate = table[hash];
+		table[hash] = pos;
+		if( candidate != 0xffffffff && pos - candidate <= MAX_OFFSET && std::memcmp( src + candidate, src + pos, MIN_MATCH ) == 0 ) {
+			unsigned length = MIN_MATCH;
+			while( pos + length < size && src[candidate + length] == src[pos + length] )
+				++length;
+			writeSequence( out, src + anchor, pos - anchor, length, pos - candidate );
+			pos += length;
+			anchor = pos;
+		}
+		else
+			++pos;
+	}
+	writeSequence( out, src + anchor, size - anchor, 0, 0 );
+}
+
+/** This helper function reads a length, which doesn't fit into the nibble of a token.
+ */
+static bool
+readLength( unsigned char const*& in, unsigned char const* end, unsigned long long& length ) {
+	unsigned char b;
+	do {
+		if( in >= end )
+			return false;
+		b = *in++;
+		length += b;
+	} while( b == 255 );
+	return true;
+}
+
+bool
+AssetArchive::decompress( unsigned char const* in, unsigned long long inSize, std::vector< unsigned char >& out ) {
+	unsigned char const* end = in + inSize;
+	unsigned long long pos = 0;
+	unsigned long long outSize = out.size();
+	while( in < end ) {
+		unsigned token = *in++;
+		unsigned long long numLiterals = token >> 4;
+		if( numLiterals == 15 && !readLength( in, end, numLiterals ) )
+			return false;
+		if( numLiterals > (unsigned long long)( end - in ) || numLiterals > outSize - pos )
+			return false;
+		if( numLiterals != 0 )
+			std::memcpy( &out[(size_t)pos], in, (size_t)numLiterals );
+		in += numLiterals;
+		pos += numLiterals;
+		// the last sequence has no match
+		if( in == end )
+			break;
+		if( end - in < 2 )
+			return false;
+		unsigned offset = in[0] | ( in[1] << 8 );
+		in += 2;
+		unsigned long long length = ( token & 15 );
+		if( length == 15 && !readLength( in, end, length ) )
+			return false;
+		length += MIN_MATCH;
+		if( offset == 0 || offset > pos || length > outSize - pos )
+			return false;
+		// the match may overlap the output, so copy byte by byte
+		unsigned char* dst = &out[(size_t)pos];
+		unsigned char const* match = dst - offset;
+		for( unsigned long long i = 0; i < length; ++i )
+			dst[i] = match[i];
+		pos += length;
+	}
+	return pos == outSize;
+}
+
+AssetArchive::~AssetArchive() {
+	close();
+}
@@ -0,0 +1,118 @@
+#ifndef ASSETARCHIVE
+#define ASSETARCHIVE
+
+#include <HashMap.h>
+
+#include <vector>
+#include <string>
+
+class AssetArchive;
+
+/** This struct describes one file stored in an AssetArchive.
+ */
+struct AssetEntry {
+	AssetArchive const* archive;	//!< The archive the entry belongs to
+	unsigned long long offset;		//!< The offset of the payload from the beginning of the archive
+	unsigned long long size;		//!< The size of the stored payload
+	unsigned long long originalSize;	//!< The size of the file before compression
+	unsigned compression;			//!< The compression method of the payload (AssetArchive::COMPRESSION_*)
+
+	AssetEntry() : archive(NULL), offset(0), size(0), originalSize(0), compression(0) {}
+};
+
+/** This class reads and writes packed asset archives.
+ * An archive is a single file with a table of contents followed by the payloads of all files, each aligned to
+ * ALIGNMENT bytes. Payloads are either stored as they are or compressed with a small LZ77 codec.
+ * For reading, the archive is memory mapped, so stored entries are handed out as pointers into the mapping without any copy.
+ * @code
+ * // file layout (all integers little endian as written by the machine)
+ * char[4]  magic "OPAK"
+ * uint32   version, number of entries, alignment
+ * entries: uint32 name length, name, uint64 offset, uint64 size, uint64 original size, uint32 compression
+ * payloads, each starting at a multiple of the alignment
+ * @endcode
+ * @brief A packed archive of assets with zero-copy reads.
+ */
+class AssetArchive {
+	public:
+		static unsigned const COMPRESSION_NONE = 0;	//!< The payload is stored as it is
+		static unsigned const COMPRESSION_LZ = 1;	//!< The payload is compressed with the LZ77 codec of compress()
+		static unsigned const ALIGNMENT = 64;		//!< The alignment of the payloads in bytes
+
+		/** Creates an archive which is not opened yet.
+		 */
+		AssetArchive();
+		/** Unmaps the archive.
+		 */
+		~AssetArchive();
+		/** This function maps an archive into memory and reads its table of contents.
+		 * @param path The path of the archive.
+		 * @param error The reason of a failure.
+		 * @return true if the archive was opened successfully.
+		 */
+		bool open( std::string const& path, std::string& error );
+		/** This function searches a file in the archive.
+		 * @param name The name of the file.
+		 * @param entry The entry to fill.
+		 * @return true if the file is part of the archive.
+		 */
+		bool find( std::string const& name, AssetEntry& entry ) const;
+		/** This function returns the content of an entry. It is safe to call it from any thread.
+		 * @param entry The entry to read.
+		 * @param buffer Is used to hold the decompressed data of compressed entries.
+		 * @param data Is set to the content: a pointer into the mapping for stored entries, into buffer else.
+		 * @param size Is set to the size of the content.
+		 * @return false if the entry is corrupted.
+		 */
+		bool read( AssetEntry const& entry, std::vector< unsigned char >& buffer, void const*& data, unsigned& size ) const;
+		/** Get the path of the archive.
+		 * @return The path given to open().
+		 */
+		std::string const& getPath() const;
+		/** Get the number of files in the archive.
+		 * @return The number of entries of the table of contents.
+		 */
+		unsigned getEntryCount() const;
+
+		/** This function writes an archive.
+		 * @param path The path of the archive to create.
+		 * @param names The names of the files in the archive.
+		 * @param files The contents of the files.
+		 * @param compress If true, every file is compressed if this saves at least 5 percent.
+		 * @param error The reason of a failure.
+		 * @return true if the archive was written successfully.
+		 */
+		static bool write( std::string const& path, std::vector< std::string > const& names,
+						   std::vector< std::vector< unsigned char > > const& files, bool compress, std::string& error );
+		/** This function compresses a buffer with the LZ77 codec of the archive.
+		 * @param in The data to compress.
+		 * @param out The compressed data.
+		 */
+		static void compress( std::vector< unsigned char > const& in, std::vector< unsigned char >& out );
+		/** This function decompresses a buffer compressed by compress().
+		 * @param in The compressed data.
+		 * @param inSize The size of the compressed data.
+		 * @param out The buffer for the decompressed data. It has to have the original size.
+		 * @return false if the data is corrupted.
+		 */
+		static bool decompress( unsigned char const* in, unsigned long long inSize, std::vector< unsigned char >& out );
+
+	private:
+		// an archive owns its mapping and can't be copied
+		AssetArchive( AssetArchive const& );
+		AssetArchive& operator=( AssetArchive const& );
+		/** This internal function unmaps the archive.
+		 */
+		void close();
+
+		std::string mPath_;			//!< The path of the archive
+		unsigned char const* mData_;	//!< The beginning of the mapping
+		unsigned long long mSize_;	//!< The size of the mapping
+#ifdef _WIN32
+		void* mFile_;				//!< The handle of the file
+		void* mMapping_;			//!< The handle of the file mapping
+#endif
+		std::tr1::unordered_map< std::string, AssetEntry > mEntries_;	//!< The table of contents
+};
+
+#endif
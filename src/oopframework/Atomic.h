@@ -0,0 +1,68 @@
+#ifndef ATOMIC
+#define ATOMIC
+
+#ifdef _WIN32
+	#include <windows.h>
+#endif
+
+/** This class wraps an integer, which is changed by several threads without a lock.
+ * The operations use the GCC __sync builtins or the Interlocked functions of win32. Every operation is a full memory barrier.
+ * @brief An integer with atomic operations.
+ */
+class Atomic {
+	public:
+		/** Creates the integer.
+		 * @param value The initial value.
+		 */
+		Atomic( long value = 0 ) : mValue_(value) {}
+		/** Get the value.
+		 * @return The current value.
+		 */
+		long get() const {
+#ifdef _WIN32
+			return InterlockedCompareExchange( const_cast< long volatile* >( &mValue_ ), 0, 0 );
+#else
+			return __sync_add_and_fetch( const_cast< long volatile* >( &mValue_ ), 0 );
+#endif
+		}
+		/** Set the value.
+		 * @param value The new value.
+		 */
+		void set( long value ) {
+#ifdef _WIN32
+			InterlockedExchange( &mValue_, value );
+#else
+			__sync_synchronize();
+			mValue_ = value;
+			__sync_synchronize();
+#endif
+		}
+		/** Adds a value.
+		 * @param value The value to add.
+		 * @return The value before the addition.
+		 */
+		long fetchAdd( long value ) {
+#ifdef _WIN32
+			return InterlockedExchangeAdd( &mValue_, value );
+#else
+			return __sync_fetch_and_add( &mValue_, value );
+#endif
+		}
+		/** Sets the value, if it has an expected value.
+		 * @param expected The value the integer must have.
+		 * @param value The new value.
+		 * @return true if the value was set.
+		 */
+		bool compareAndSwap( long expected, long value ) {
+#ifdef _WIN32
+			return InterlockedCompareExchange( &mValue_, value, expected ) == expected;
+#else
+			return __sync_bool_compare_and_swap( &mValue_, expected, value );
+#endif
+		}
+
+	private:
+		long volatile mValue_;	//!< The value
+};
+
+#endif
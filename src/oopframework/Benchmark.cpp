@@ -0,0 +1,107 @@
+#include <Benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+// the names of the phases in the report
+static char const* const PHASE_NAMES[Benchmark::PHASE_COUNT] = { "input", "update", "draw", "swap" };
+
+Benchmark::Benchmark( unsigned frames, double timestep ) :
+	mFrames_(frames),
+	mTimestep_(timestep) {
+	mFrameTimes_.reserve( frames );
+	for( unsigned i = 0; i < PHASE_COUNT; ++i )
+		mPhaseTimes_[i].reserve( frames );
+}
+
+unsigned
+Benchmark::getFrameCount() const {
+	return mFrames_;
+}
+
+double
+Benchmark::getTimestep() const {
+	return mTimestep_;
+}
+
+void
+Benchmark::addFrame( double const phases[PHASE_COUNT] ) {
+	double frameTime = 0.0;
+	for( unsigned i = 0; i < PHASE_COUNT; ++i ) {
+		mPhaseTimes_[i].push_back( phases[i] );
+		frameTime += phases[i];
+	}
+	mFrameTimes_.push_back( frameTime );
+}
+
+bool
+Benchmark::isFinished() const {
+	return mFrameTimes_.size() >= mFrames_;
+}
+
+std::string
+Benchmark::toJSON() const {
+	std::vector< double > sorted( mFrameTimes_ );
+	std::sort( sorted.begin(), sorted.end() );
+	double total = 0.0;
+	for( unsigned i = 0; i < sorted.size(); ++i )
+		total += sorted[i];
+	double mean = sorted.empty() ? 0.0 : total / sorted.size();
+
+	std::ostringstream json;
+	json.setf( std::ios::fixed );
+	json.precision( 3 );
+	json << "{\n";
+	json << "  \"frames\": " << sorted.size() << ",\n";
+	json << "  \"timestep_ms\": " << mTimestep_ * 1000.0 << ",\n";
+	json << "  \"total_s\": " << total << ",\n";
+	json << "  \"fps\": " << ( total > 0.0 ? sorted.size() / total : 0.0 ) << ",\n";
+	json << "  \"frame_ms\": { ";
+	json << "\"min\": " << ( sorted.empty() ? 0.0 : sorted.front() * 1000.0 );
+	json << ", \"mean\": " << mean * 1000.0;
+	json << ", \"p50\": " << getPercentile( sorted, 50.0 ) * 1000.0;
+	json << ", \"p95\": " << getPercentile( sorted, 95.0 ) * 1000.0;
+	json << ", \"p99\": " << getPercentile( sorted, 99.0 ) * 1000.0;
+	json << ", \"max\": " << ( sorted.empty() ? 0.0 : sorted.back() * 1000.0 ) << " },\n";
+	json << "  \"phases_ms\": {\n";
+	for( unsigned p = 0; p < PHASE_COUNT; ++p ) {
+		std::vector< double > phase( mPhaseTimes_[p] );
+		std::sort( phase.begin(), phase.end() );
+		double sum = 0.0;
+		for( unsigned i = 0; i < phase.size(); ++i )
+			sum += phase[i];
+		json << "    \"" << PHASE_NAMES[p] << "\": { ";
+		json << "\"mean\": " << ( phase.empty() ? 0.0 : sum / phase.size() * 1000.0 );
+		json << ", \"p50\": " << getPercentile( phase, 50.0 ) * 1000.0;
+		json << ", \"p95\": " << getPercentile( phase, 95.0 ) * 1000.0 << " }";
+		json << ( p + 1 < PHASE_COUNT ? ",\n" : "\n" );
+	}
+	json << "  }\n";
+	json << "}\n";
+	return json.str();
+}
+
+void
+Benchmark::getCameraPath( double time, float rot[3], float trans[3] ) {
+	// slow incommensurable sines, so the path doesn't repeat within a typical run
+	rot[0] = (float)( 12.0 * std::sin( time * 0.31 ) );
+	rot[1] = (float)( 35.0 * std::sin( time * 0.21 ) );
+	rot[2] = 0.0f;
+	// the Earth is 20 units in front of the camera, the camera comes up to 10 units closer
+	trans[0] = (float)( 3.0 * std::sin( time * 0.17 ) );
+	trans[1] = (float)( 1.5 * std::sin( time * 0.23 ) );
+	trans[2] = (float)( 5.0 - 5.0 * std::cos( time * 0.2 ) );
+}
+
+double
+Benchmark::getPercentile( std::vector< double > const& sorted, double percent ) {
+	if( sorted.empty() )
+		return 0.0;
+	// nearest rank: the smallest sample, which is not exceeded by percent of all samples
+	double rank = std::ceil( percent / 100.0 * sorted.size() );
+	unsigned index = rank < 1.0 ? 0 : (unsigned)rank - 1;
+	if( index >= sorted.size() )
+		index = (unsigned)sorted.size() - 1;
+	return sorted[index];
+}
@@ -0,0 +1,86 @@
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#include <string>
+#include <vector>
+
+/** This class collects the frame times of a benchmark run and reports their statistics as JSON.
+ * A run renders a fixed number of frames, every frame advances the animation by the same simulated timestep and the
+ * camera follows a scripted path (see getCameraPath()). Two runs on the same machine therefore render the same frames,
+ * so their numbers can be compared.
+ * Every frame is split into the phases of the render loop:
+ * - input: polling the window events (they are discarded, so they can't disturb the camera)
+ * - update: uploading the decoded textures and moving the camera
+ * - draw: issuing the OpenGL calls of the scene (CPU time only)
+ * - swap: presenting the frame, which includes waiting for the GPU
+ * @brief Statistics of a deterministic benchmark run.
+ * @code
+ * Benchmark b( 500, 1.0 / 60.0 );
+ * double start = Clock::getSeconds();
+ * // ... measure the phases of one frame
+ * b.addFrame( phases );
+ * std::cout << b.toJSON();
+ * @endcode
+ */
+class Benchmark {
+	public:
+		/** The phases of one frame.
+		 */
+		enum Phase {
+			PHASE_INPUT = 0,
+			PHASE_UPDATE,
+			PHASE_DRAW,
+			PHASE_SWAP,
+			PHASE_COUNT
+		};
+
+		/** Creates an empty run.
+		 * @param frames The number of frames of the run.
+		 * @param timestep The simulated time of one frame in seconds.
+		 */
+		Benchmark( unsigned frames, double timestep );
+		/** Get the number of frames of the run.
+		 * @return The number given to the constructor.
+		 */
+		unsigned getFrameCount() const;
+		/** Get the simulated time of one frame.
+		 * @return The timestep in seconds.
+		 */
+		double getTimestep() const;
+		/** This function adds the measured times of one frame.
+		 * @param phases The time spent in each phase in seconds, indexed by Phase.
+		 */
+		void addFrame( double const phases[PHASE_COUNT] );
+		/** This function tells whether all frames were measured.
+		 * @return true if addFrame() was called getFrameCount() times.
+		 */
+		bool isFinished() const;
+		/** This function formats the statistics as JSON.
+		 * The frame times (min, mean, p50, p95, p99, max in milliseconds), the frames per second and the mean, p50 and p95
+		 * of every phase are reported.
+		 * @return The JSON object.
+		 */
+		std::string toJSON() const;
+		/** This function returns the camera of the scripted path at a simulated time.
+		 * The camera swings around the Earth and moves towards it and back, a full cycle takes about 30 seconds.
+		 * @param time The simulated time in seconds.
+		 * @param rot The rotation of the camera around X, Y and Z in degrees.
+		 * @param trans The translation of the camera.
+		 */
+		static void getCameraPath( double time, float rot[3], float trans[3] );
+
+	private:
+		/** This internal function returns a percentile of sorted samples (nearest rank).
+		 * @param sorted The samples in ascending order.
+		 * @param percent The percentile from 0 to 100.
+		 * @return The sample or 0 if there is none.
+		 */
+		static double getPercentile( std::vector< double > const& sorted, double percent );
+
+		unsigned mFrames_;			//!< The number of frames of the run
+		double mTimestep_;			//!< The simulated time of one frame in seconds
+		std::vector< double > mFrameTimes_;	//!< The measured time of every frame in seconds
+		std::vector< double > mPhaseTimes_[PHASE_COUNT];	//!< The measured time of every phase of every frame in seconds
+};
+
+#endif
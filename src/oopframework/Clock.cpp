@@ -0,0 +1,118 @@
+#include <Clock.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+Clock::Clock( unsigned historySize, double smoothing, double maxDelta ) :
+	mHistory_( historySize > 0 ? historySize : 1, 0.0 ),
+	mHistoryNext_(0),
+	mHistoryCount_(0),
+	mSmoothing_(smoothing),
+	mMaxDelta_(maxDelta),
+	mLastTick_(0),
+	mTicks_(0),
+	mDelta_(0.0),
+	mSmoothedDelta_(0.0) {
+	if( mSmoothing_ <= 0.0 || mSmoothing_ > 1.0 )
+		mSmoothing_ = 1.0;
+}
+
+double
+Clock::tick() {
+	unsigned long long now = getNanoseconds();
+	++mTicks_;
+	if( mTicks_ == 1 ) {
+		mLastTick_ = now;
+		mDelta_ = 0.0;
+		return mDelta_;
+	}
+	mDelta_ = ( now - mLastTick_ ) / 1000000000.0;
+	mLastTick_ = now;
+	if( mDelta_ > mMaxDelta_ )
+		mDelta_ = mMaxDelta_;
+
+	mHistory_[mHistoryNext_] = mDelta_;
+	mHistoryNext_ = ( mHistoryNext_ + 1 ) % (unsigned)mHistory_.size();
+	if( mHistoryCount_ < mHistory_.size() )
+		++mHistoryCount_;
+	// the first measured frame starts the average, so it doesn't have to climb up from 0
+	if( mHistoryCount_ == 1 )
+		mSmoothedDelta_ = mDelta_;
+	else
+		mSmoothedDelta_ += mSmoothing_ * ( mDelta_ - mSmoothedDelta_ );
+	return mDelta_;
+}
+
+void
+Clock::reset() {
+	mHistoryNext_ = 0;
+	mHistoryCount_ = 0;
+	mTicks_ = 0;
+	mDelta_ = 0.0;
+	mSmoothedDelta_ = 0.0;
+}
+
+double
+Clock::getDelta() const {
+	return mDelta_;
+}
+
+double
+Clock::getSmoothedDelta() const {
+	return mSmoothedDelta_;
+}
+
+double
+Clock::getAverageDelta() const {
+	if( mHistoryCount_ == 0 )
+		return 0.0;
+	double sum = 0.0;
+	for( unsigned i = 0; i < mHistoryCount_; ++i )
+		sum += getHistory( i );
+	return sum / mHistoryCount_;
+}
+
+unsigned
+Clock::getHistoryCount() const {
+	return mHistoryCount_;
+}
+
+double
+Clock::getHistory( unsigned age ) const {
+	if( age >= mHistoryCount_ )
+		return 0.0;
+	unsigned size = (unsigned)mHistory_.size();
+	return mHistory_[( mHistoryNext_ + size - 1 - age ) % size];
+}
+
+unsigned long
+Clock::getTickCount() const {
+	return mTicks_;
+}
+
+unsigned long long
+Clock::getNanoseconds() {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = { 0 };
+	if( frequency.QuadPart == 0 )
+		QueryPerformanceFrequency( &frequency );
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	// split the division, so the multiplication doesn't overflow
+	unsigned long long seconds = counter.QuadPart / frequency.QuadPart;
+	unsigned long long rest = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000ULL + rest * 1000000000ULL / frequency.QuadPart;
+#else
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+double
+Clock::getSeconds() {
+	return getNanoseconds() / 1000000000.0;
+}
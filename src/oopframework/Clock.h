@@ -0,0 +1,83 @@
+#ifndef CLOCK
+#define CLOCK
+
+#include <vector>
+
+/** This class measures the time between frames with a monotonic high resolution clock.
+ * The timestamps come from CLOCK_MONOTONIC (QueryPerformanceCounter on Windows), so they never jump when the
+ * wall clock is adjusted (e.g. by NTP). The clock keeps a rolling history of the last frame times and a smoothed
+ * delta, an exponential moving average which hides the jitter of single frames from the animation.
+ * Deltas longer than a maximum (e.g. after a breakpoint or while the window was dragged) are clamped,
+ * so the animation doesn't jump.
+ * @brief A frame timer.
+ * @code
+ * Clock clock;
+ * while( running ) {
+ *     clock.tick();
+ *     animate( clock.getSmoothedDelta() );
+ * }
+ * @endcode
+ */
+class Clock {
+	public:
+		/** Creates a clock. The first tick() starts the measurement.
+		 * @param historySize The number of frame times kept in the history.
+		 * @param smoothing The weight of the newest frame in the smoothed delta (between 0 and 1, 1 disables the smoothing).
+		 * @param maxDelta The longest delta in seconds, longer ones are clamped.
+		 */
+		Clock( unsigned historySize = 120, double smoothing = 0.1, double maxDelta = 0.25 );
+		/** This function marks the beginning of a new frame and measures the time since the last one.
+		 * @return The (clamped) time since the last tick in seconds, 0 on the first tick.
+		 */
+		double tick();
+		/** This function forgets the history, the next tick() starts a new measurement.
+		 */
+		void reset();
+		/** Get the measured time of the last frame.
+		 * @return The (clamped) time between the last two ticks in seconds.
+		 */
+		double getDelta() const;
+		/** Get the smoothed time of a frame, which should be used to advance the animation.
+		 * @return The exponential moving average of the deltas in seconds.
+		 */
+		double getSmoothedDelta() const;
+		/** Get the mean time of the frames in the history.
+		 * @return The mean in seconds, 0 if no frame was measured yet.
+		 */
+		double getAverageDelta() const;
+		/** Get the number of frame times in the history.
+		 * @return The number of valid entries, at most the historySize given to the constructor.
+		 */
+		unsigned getHistoryCount() const;
+		/** Get a frame time of the history.
+		 * @param age 0 for the last frame, 1 for the one before, ...
+		 * @return The frame time in seconds, 0 if age is not smaller than getHistoryCount().
+		 */
+		double getHistory( unsigned age ) const;
+		/** Get the number of ticks since the construction or the last reset().
+		 * @return The number of ticks.
+		 */
+		unsigned long getTickCount() const;
+
+		/** Get a timestamp of the monotonic clock.
+		 * @return The time in nanoseconds since an arbitrary point.
+		 */
+		static unsigned long long getNanoseconds();
+		/** Get a timestamp of the monotonic clock.
+		 * @return The time in seconds since an arbitrary point.
+		 */
+		static double getSeconds();
+
+	private:
+		std::vector< double > mHistory_;	//!< The ring of the last frame times in seconds
+		unsigned mHistoryNext_;		//!< The index of the next entry of the ring
+		unsigned mHistoryCount_;	//!< The number of valid entries of the ring
+		double mSmoothing_;			//!< The weight of the newest frame in the smoothed delta
+		double mMaxDelta_;			//!< The longest delta in seconds
+		unsigned long long mLastTick_;	//!< The timestamp of the last tick in nanoseconds
+		unsigned long mTicks_;		//!< The number of ticks
+		double mDelta_;				//!< The time of the last frame in seconds
+		double mSmoothedDelta_;		//!< The exponential moving average of the deltas
+};
+
+#endif
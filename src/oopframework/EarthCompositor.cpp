@@ -0,0 +1,197 @@
+#include <EarthCompositor.h>
+#include <GLStateCache.h>
+#include <LightingShader.h>
+#include <Profiler.h>
+
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+// the unit of the cloud texture, the surface stays on unit 0 where Texture::bind() puts it
+static unsigned const CLOUD_UNIT = 1;
+
+// the lighting of LightingShader without the emission, and the direction of the vertex on the cloud sphere
+// (follows LightingShader::LIGHTING_SOURCE)
+static char const* VERTEX_SHADER =
+	"uniform vec4 block[14];\n"
+	"varying vec3 lit;\n"
+	"varying vec3 cloudDirection;\n"
+	"void main() {\n"
+	"	vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+	"	vec2 light = lightVertex( normalize( gl_NormalMatrix * gl_Normal ), eye, block[0], block[8].x );\n"
+	"	lit = block[4].rgb * block[5].rgb + block[1].rgb * block[5].rgb + light.x * block[2].rgb * block[6].rgb\n"
+	"		+ light.y * block[3].rgb * block[7].rgb;\n"
+	"	cloudDirection = vec3( dot( block[10].xyz, gl_Normal ), dot( block[11].xyz, gl_Normal ), dot( block[12].xyz, gl_Normal ) );\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+// blends the grid and the clouds over the surface, like the blended spheres did
+static char const* FRAGMENT_SHADER =
+	"#version 120\n"
+	"uniform vec4 block[14];\n"
+	"uniform sampler2D surface;\n"
+	"uniform sampler2D clouds;\n"
+	"uniform bool surfaceTextured;\n"
+	"uniform bool cloudsTextured;\n"
+	"varying vec3 lit;\n"
+	"varying vec3 cloudDirection;\n"
+	"void main() {\n"
+	"	vec3 base = clamp( lit, 0.0, 1.0 );\n"
+	"	vec3 color = surfaceTextured ? base * texture2D( surface, gl_TexCoord[0].st ).rgb : base;\n"
+	// the edges of the wireframe sphere are where the texture coordinates are multiples of 1 / detail
+	"	vec2 grid = gl_TexCoord[0].st * block[13].xy;\n"
+	"	vec2 edge = abs( fract( grid - 0.5 ) - 0.5 ) / fwidth( grid );\n"
+	"	float line = 1.0 - clamp( min( edge.x, edge.y ), 0.0, 1.0 );\n"
+	"	color = mix( color, base, line * block[13].z );\n"
+	// the texture coordinates of SphereMesh at the direction on the cloud sphere
+	"	vec3 q = normalize( cloudDirection );\n"
+	"	float u = atan( -q.x, q.y ) / 6.28318531;\n"
+	// u jumps from 1 to 0 at the seam, the wrapped copy jumps on the opposite side: take the one which is continuous
+	// within the pixel, else the derivatives select the smallest mipmap along the seam
+	"	float u0 = fract( u );\n"
+	"	float u1 = fract( u + 0.5 ) - 0.5;\n"
+	"	u = ( fwidth( u0 ) <= fwidth( u1 ) ) ? u0 : u1;\n"
+	"	vec2 st = vec2( u, 1.0 - acos( clamp( q.z, -1.0, 1.0 ) ) / 3.14159265 );\n"
+	"	vec4 cloud = vec4( clamp( lit + block[9].rgb, 0.0, 1.0 ), block[9].a );\n"
+	"	if( cloudsTextured )\n"
+	"		cloud *= texture2D( clouds, st );\n"
+	"	gl_FragColor = vec4( mix( color, cloud.rgb, cloud.a ), 1.0 );\n"
+	"}\n";
+
+EarthCompositor*
+EarthCompositor::create() {
+	std::string vertex = std::string( "#version 120\n" ) + LightingShader::LIGHTING_SOURCE + VERTEX_SHADER;
+	ShaderProgram* program = ShaderProgram::create( "EarthCompositor", vertex.c_str(), FRAGMENT_SHADER );
+	if( program == NULL )
+		return NULL;
+	return new EarthCompositor( program );
+}
+
+EarthCompositor::EarthCompositor( ShaderProgram* program ) :
+	mProgram_(program),
+	mDirty_(true),
+	mUploads_(0) {
+	mBlockUniform_ = mProgram_->getUniform( "block" );
+	mSurfaceTexturedUniform_ = mProgram_->getUniform( "surfaceTextured" );
+	mCloudsTexturedUniform_ = mProgram_->getUniform( "cloudsTextured" );
+	mProgram_->bind();
+	glUniform1i( mProgram_->getUniform( "surface" ), 0 );
+	glUniform1i( mProgram_->getUniform( "clouds" ), CLOUD_UNIT );
+	mProgram_->unbind();
+	// the defaults of OpenGL, no clouds and no grid
+	std::memset( mBlock_, 0, sizeof(mBlock_) );
+	float const position[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+	float const white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	float const sceneAmbient[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+	float const ambient[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+	float const diffuse[4] = { 0.8f, 0.8f, 0.8f, 1.0f };
+	float const black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float const none[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	setLight( position, black, white, white );
+	set( SCENE_AMBIENT, sceneAmbient );
+	setMaterial( ambient, diffuse, black, 0.0f );
+	setClouds( none, 0.0f, 0.0f, 0.0f, 1.0f );
+	setGrid( 1, 0.0f );
+}
+
+void
+EarthCompositor::set( unsigned slot, float const value[4] ) {
+	float* entry = &mBlock_[slot * 4];
+	if( std::memcmp( entry, value, 4 * sizeof(float) ) == 0 )
+		return;
+	std::memcpy( entry, value, 4 * sizeof(float) );
+	mDirty_ = true;
+}
+
+void
+EarthCompositor::setLight( float const eyePosition[4], float const ambient[4], float const diffuse[4], float const specular[4] ) {
+	set( LIGHT_POSITION, eyePosition );
+	set( LIGHT_AMBIENT, ambient );
+	set( LIGHT_DIFFUSE, diffuse );
+	set( LIGHT_SPECULAR, specular );
+}
+
+void
+EarthCompositor::setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float shininess ) {
+	set( MATERIAL_AMBIENT, ambient );
+	set( MATERIAL_DIFFUSE, diffuse );
+	set( MATERIAL_SPECULAR, specular );
+	float const exponent[4] = { shininess, 0.0f, 0.0f, 0.0f };
+	set( MATERIAL_SHININESS, exponent );
+}
+
+void
+EarthCompositor::setClouds( float const emission[4], float angle, float x, float y, float z ) {
+	set( CLOUD_EMISSION, emission );
+	// the matrix of glRotatef, the shader needs its inverse: the transposed matrix, so the rows are its columns
+	float length = std::sqrt( x * x + y * y + z * z );
+	if( length > 0.0f ) {
+		x /= length;
+		y /= length;
+		z /= length;
+	}
+	else {
+		x = 0.0f;
+		y = 0.0f;
+		z = 1.0f;
+	}
+	float radians = angle * (float)M_PI / 180.0f;
+	float c = std::cos( radians );
+	float s = std::sin( radians );
+	float t = 1.0f - c;
+	float const column0[4] = { t * x * x + c, t * x * y + s * z, t * x * z - s * y, 0.0f };
+	float const column1[4] = { t * x * y - s * z, t * y * y + c, t * y * z + s * x, 0.0f };
+	float const column2[4] = { t * x * z + s * y, t * y * z - s * x, t * z * z + c, 0.0f };
+	set( CLOUD_ROTATION, column0 );
+	set( CLOUD_ROTATION + 1, column1 );
+	set( CLOUD_ROTATION + 2, column2 );
+}
+
+void
+EarthCompositor::setGrid( unsigned detail, float opacity ) {
+	float const grid[4] = { (float)detail, (float)detail, opacity, 0.0f };
+	set( GRID, grid );
+}
+
+void
+EarthCompositor::draw( SphereMesh const* mesh, float radius, Texture* surface, Texture* clouds ) {
+	PROFILE_ZONE( "EarthCompositor::draw" );
+	mProgram_->bind();
+	if( mDirty_ ) {
+		glUniform4fv( mBlockUniform_, SLOT_COUNT, mBlock_ );
+		mDirty_ = false;
+		++mUploads_;
+	}
+	glUniform1i( mSurfaceTexturedUniform_, surface != NULL ? 1 : 0 );
+	glUniform1i( mCloudsTexturedUniform_, clouds != NULL ? 1 : 0 );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	if( clouds != NULL ) {
+		sc->activeTexture( CLOUD_UNIT );
+		clouds->bind();
+		sc->activeTexture( 0 );
+	}
+	if( surface != NULL )
+		surface->bind();
+	mesh->draw( radius );
+	if( surface != NULL )
+		surface->unbind();
+	if( clouds != NULL ) {
+		sc->activeTexture( CLOUD_UNIT );
+		clouds->unbind();
+		sc->activeTexture( 0 );
+	}
+	mProgram_->unbind();
+}
+
+unsigned long
+EarthCompositor::getUploadCount() const {
+	return mUploads_;
+}
+
+EarthCompositor::~EarthCompositor() {
+	delete mProgram_;
+}
@@ -0,0 +1,122 @@
+#ifndef EARTHCOMPOSITOR
+#define EARTHCOMPOSITOR
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+#include <ShaderProgram.h>
+#include <SphereMesh.h>
+#include <Texture.h>
+
+/** This class draws the Earth, its grid and its clouds in a single pass over the Earth sphere.
+ * Usually the grid is a wireframe sphere and the clouds are a textured sphere, both blended over the Earth, so
+ * every pixel of the Earth is shaded up to three times. The fragment shader of the compositor samples the surface
+ * and the clouds in one go and blends them itself:
+ * - The grid lines are placed at the slices and stacks of the wireframe sphere and are about a pixel wide.
+ * - The clouds are looked up by the direction of the fragment, turned by the inverse rotation of the cloud sphere.
+ *   So they move over the surface like the rotated sphere does, which a plain offset of the texture coordinates
+ *   can only do for rotations around the poles.
+ *
+ * The grid and the clouds are drawn onto the surface, the few pixels by which their larger spheres stick out over
+ * the silhouette of the Earth are missing. The lighting is the one of LightingShader: light 0, per vertex, with one
+ * material for all layers. The clouds only add their emission and their opacity. The uniforms are kept in one block
+ * of vec4s, which is uploaded only if it changed.
+ * @brief Single pass Earth with clouds and grid.
+ * @code
+ * EarthCompositor* compositor = EarthCompositor::create();
+ * compositor->setLight( eyePosition, ambient, diffuse, specular );
+ * compositor->setMaterial( ambient, diffuse, specular, 100.0f );
+ * compositor->setClouds( emission, angle, 0.3f, 0.6f, 0.4f );
+ * compositor->setGrid( 50, 0.3f );
+ * compositor->draw( SphereMesh::getSphere( 100, 100 ), 5.0f, earthTexture, cloudTexture );
+ * @endcode
+ */
+class EarthCompositor {
+	public:
+		/** The vec4 entries of the uniform block.
+		 */
+		enum Slot {
+			LIGHT_POSITION,		//!< The position of the light in eye coordinates (w = 0 for a directional light)
+			LIGHT_AMBIENT,		//!< The ambient color of the light
+			LIGHT_DIFFUSE,		//!< The diffuse color of the light
+			LIGHT_SPECULAR,		//!< The specular color of the light
+			SCENE_AMBIENT,		//!< The ambient color of the scene (GL_LIGHT_MODEL_AMBIENT)
+			MATERIAL_AMBIENT,	//!< The ambient color of the material
+			MATERIAL_DIFFUSE,	//!< The diffuse color of the material
+			MATERIAL_SPECULAR,	//!< The specular color of the material
+			MATERIAL_SHININESS,	//!< The specular exponent in x
+			CLOUD_EMISSION,		//!< The emission of the clouds, their opacity in w
+			CLOUD_ROTATION,		//!< The first of three rows which turn a direction on the Earth onto the cloud sphere
+			GRID = CLOUD_ROTATION + 3,	//!< The slices and stacks of the grid in x and y, its opacity in z
+			SLOT_COUNT
+		};
+
+		/** This function builds the program.
+		 * @return The compositor or NULL if GLSL is not supported or the program doesn't build.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		static EarthCompositor* create();
+		/** Deletes the program. The OpenGL context has to be current.
+		 */
+		~EarthCompositor();
+		/** This function sets the light.
+		 * @param eyePosition The position in eye coordinates.
+		 * @param ambient The ambient color.
+		 * @param diffuse The diffuse color.
+		 * @param specular The specular color.
+		 */
+		void setLight( float const eyePosition[4], float const ambient[4], float const diffuse[4], float const specular[4] );
+		/** This function sets the material of the surface, the grid and the clouds.
+		 * @param ambient The ambient color.
+		 * @param diffuse The diffuse color.
+		 * @param specular The specular color.
+		 * @param shininess The specular exponent.
+		 */
+		void setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float shininess );
+		/** This function sets the clouds.
+		 * @param emission The light the clouds emit, the w component is their opacity.
+		 * @param angle The rotation of the cloud sphere relative to the Earth in degrees, like glRotatef().
+		 * @param x The x component of the rotation axis.
+		 * @param y The y component of the rotation axis.
+		 * @param z The z component of the rotation axis.
+		 */
+		void setClouds( float const emission[4], float angle, float x, float y, float z );
+		/** This function sets the grid.
+		 * @param detail The slices and stacks of the wireframe sphere the grid replaces.
+		 * @param opacity The opacity of the lines, 0 hides the grid.
+		 */
+		void setGrid( unsigned detail, float opacity );
+		/** This function draws the Earth with its grid and clouds.
+		 * @param mesh The sphere of the Earth.
+		 * @param radius The radius of the Earth.
+		 * @param surface The texture of the surface, NULL for none.
+		 * @param clouds The texture of the clouds, NULL for none.
+		 */
+		void draw( SphereMesh const* mesh, float radius, Texture* surface, Texture* clouds );
+		/** Get the number of uploads of the uniform block.
+		 * @return The number of glUniform4fv calls since the creation.
+		 */
+		unsigned long getUploadCount() const;
+
+	private:
+		/** Creates the compositor around a linked program.
+		 */
+		EarthCompositor( ShaderProgram* program );
+		// the program can't be shared by copies
+		EarthCompositor( EarthCompositor const& );
+		EarthCompositor& operator=( EarthCompositor const& );
+		/** This function sets an entry of the uniform block.
+		 */
+		void set( unsigned slot, float const value[4] );
+
+		ShaderProgram* mProgram_;			//!< The linked program
+		GLint mBlockUniform_;				//!< The location of the uniform block
+		GLint mSurfaceTexturedUniform_;		//!< The location of the switch for the surface texture
+		GLint mCloudsTexturedUniform_;		//!< The location of the switch for the cloud texture
+		float mBlock_[SLOT_COUNT * 4];		//!< The uniform block
+		bool mDirty_;						//!< If true, mBlock_ changed since the last upload
+		unsigned long mUploads_;			//!< The number of uploads of the block
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef EXTENSIONSTRING
+#define EXTENSIONSTRING
+
+#include <cstring>
+
+/** This class searches the space separated extension strings of OpenGL, GLX, WGL and EGL.
+ * A plain strstr() also finds a name which is only the prefix of another extension (GLX_EXT_swap_control in
+ * GLX_EXT_swap_control_tear), so a match has to be delimited by spaces or the ends of the string.
+ * @brief Lookup in extension strings.
+ */
+class ExtensionString {
+	public:
+		/** This function tests whether an extension string contains an extension.
+		 * @param extensions The space separated extension string, NULL counts as empty.
+		 * @param name The name of the extension.
+		 * @return true if the string contains the extension.
+		 */
+		static bool contains( char const* extensions, char const* name ) {
+			if( extensions == NULL )
+				return false;
+			size_t length = std::strlen( name );
+			for( char const* p = std::strstr( extensions, name ); p != NULL; p = std::strstr( p + length, name ) ) {
+				if( ( p == extensions || p[-1] == ' ' ) && ( p[length] == ' ' || p[length] == '\0' ) )
+					return true;
+			}
+			return false;
+		}
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include <FrameLimiter.h>
+#include <Clock.h>
+#include <ExtensionString.h>
+
+#include <GL/glew.h>
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <mmsystem.h>
+#else
+	#include <GL/glx.h>
+#endif
+
+// the remaining time which is spun instead of slept, it covers the oversleeping of the scheduler
+static unsigned long long const SPIN_TIME = 2000000ULL;
+
+FrameLimiter::FrameLimiter( double targetFPS ) :
+	mPeriod_(0),
+	mNextFrame_(0),
+	mFineTimer_(false) {
+	setTargetFPS( targetFPS );
+}
+
+void
+FrameLimiter::setTargetFPS( double targetFPS ) {
+	mPeriod_ = ( targetFPS > 0.0 ) ? (unsigned long long)( 1000000000.0 / targetFPS ) : 0;
+	mNextFrame_ = 0;
+#ifdef _WIN32
+	// the default timer of Windows ticks every 15.6 ms, which is far too coarse for sleeping until a frame is due
+	if( mPeriod_ != 0 && !mFineTimer_ )
+		mFineTimer_ = ( timeBeginPeriod( 1 ) == TIMERR_NOERROR );
+	else if( mPeriod_ == 0 && mFineTimer_ ) {
+		timeEndPeriod( 1 );
+		mFineTimer_ = false;
+	}
+#endif
+}
+
+double
+FrameLimiter::getTargetFPS() const {
+	return ( mPeriod_ != 0 ) ? 1000000000.0 / mPeriod_ : 0.0;
+}
+
+void
+FrameLimiter::wait() {
+	if( mPeriod_ == 0 )
+		return;
+	unsigned long long now = Clock::getNanoseconds();
+	if( mNextFrame_ == 0 || now >= mNextFrame_ + mPeriod_ ) {
+		// the first frame, or more than a frame late: start a new schedule instead of catching up
+		mNextFrame_ = now + mPeriod_;
+		return;
+	}
+	while( now < mNextFrame_ ) {
+		unsigned long long remaining = mNextFrame_ - now;
+		if( remaining > SPIN_TIME )
+			SDL_Delay( (Uint32)( ( remaining - SPIN_TIME ) / 1000000ULL ) );
+		now = Clock::getNanoseconds();
+	}
+	mNextFrame_ += mPeriod_;
+}
+
+void
+FrameLimiter::reset() {
+	mNextFrame_ = 0;
+}
+
+bool
+FrameLimiter::setSwapInterval( int interval ) {
+#ifdef _WIN32
+	typedef BOOL (WINAPI *SwapIntervalProc)( int );
+	typedef char const* (WINAPI *ExtensionsStringProc)( void );
+	ExtensionsStringProc getExtensions = (ExtensionsStringProc)wglGetProcAddress( "wglGetExtensionsStringEXT" );
+	char const* extensions = ( getExtensions != NULL ) ? getExtensions() : NULL;
+	if( interval < 0 && !ExtensionString::contains( extensions, "WGL_EXT_swap_control_tear" ) ) {
+		LOG_WARNING( RENDER, "FrameLimiter: Adaptive vsync is not supported, using vsync instead." );
+		interval = 1;
+	}
+	SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress( "wglSwapIntervalEXT" );
+	if( swapInterval != NULL && swapInterval( interval ) ) {
+		LOG_INFO( RENDER, "FrameLimiter: Swap interval set to " << interval << "." );
+		return true;
+	}
+#else
+	typedef void (*SwapIntervalEXTProc)( Display*, GLXDrawable, int );
+	typedef int (*SwapIntervalMESAProc)( unsigned );
+	typedef int (*SwapIntervalSGIProc)( int );
+	Display* display = glXGetCurrentDisplay();
+	GLXDrawable drawable = glXGetCurrentDrawable();
+	if( display == NULL || drawable == 0 ) {
+		LOG_WARNING( RENDER, "FrameLimiter: There is no GLX window, the swap interval can't be set." );
+		return false;
+	}
+	char const* extensions = glXQueryExtensionsString( display, DefaultScreen( display ) );
+	if( interval < 0 && !ExtensionString::contains( extensions, "GLX_EXT_swap_control_tear" ) ) {
+		LOG_WARNING( RENDER, "FrameLimiter: Adaptive vsync is not supported, using vsync instead." );
+		interval = 1;
+	}
+	if( ExtensionString::contains( extensions, "GLX_EXT_swap_control" ) ) {
+		SwapIntervalEXTProc swapInterval = (SwapIntervalEXTProc)glXGetProcAddressARB( (GLubyte const*)"glXSwapIntervalEXT" );
+		if( swapInterval != NULL ) {
+			swapInterval( display, drawable, interval );
+			LOG_INFO( RENDER, "FrameLimiter: Swap interval set to " << interval << "." );
+			return true;
+		}
+	}
+	// the older extensions know neither adaptive vsync nor (SGI) an interval of 0
+	if( ExtensionString::contains( extensions, "GLX_MESA_swap_control" ) ) {
+		SwapIntervalMESAProc swapInterval = (SwapIntervalMESAProc)glXGetProcAddressARB( (GLubyte const*)"glXSwapIntervalMESA" );
+		if( swapInterval != NULL && swapInterval( (unsigned)interval ) == 0 ) {
+			LOG_INFO( RENDER, "FrameLimiter: Swap interval set to " << interval << "." );
+			return true;
+		}
+	}
+	if( interval > 0 && ExtensionString::contains( extensions, "GLX_SGI_swap_control" ) ) {
+		SwapIntervalSGIProc swapInterval = (SwapIntervalSGIProc)glXGetProcAddressARB( (GLubyte const*)"glXSwapIntervalSGI" );
+		if( swapInterval != NULL && swapInterval( interval ) == 0 ) {
+			LOG_INFO( RENDER, "FrameLimiter: Swap interval set to " << interval << "." );
+			return true;
+		}
+	}
+#endif
+	LOG_WARNING( RENDER, "FrameLimiter: The swap interval " << interval << " is not supported by the driver." );
+	return false;
+}
+
+FrameLimiter::~FrameLimiter() {
+#ifdef _WIN32
+	if( mFineTimer_ )
+		timeEndPeriod( 1 );
+#endif
+}
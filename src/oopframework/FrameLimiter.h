@@ -0,0 +1,60 @@
+#ifndef FRAMELIMITER
+#define FRAMELIMITER
+
+#include <LogManager.h>
+
+/** This class limits the frame rate of the render loop.
+ * After a frame was presented, wait() blocks until the next frame is due. The thread sleeps for the largest part of the
+ * time and spins only for the last milliseconds, because the scheduler wakes a sleeping thread up too late by up to a
+ * millisecond or two. If a frame was late by more than a whole period, the schedule starts anew instead of rendering
+ * a burst of frames to catch up.
+ * The class also controls the swap interval (vsync) of the window, including the adaptive vsync of
+ * GLX_EXT_swap_control_tear / WGL_EXT_swap_control_tear, which only waits for the vertical blank if the frame is in time.
+ * @brief Frame pacing and vsync control.
+ * @code
+ * FrameLimiter limiter( 30.0 );
+ * while( running ) {
+ *     render();
+ *     SDL_GL_SwapBuffers();
+ *     limiter.wait();
+ * }
+ * @endcode
+ */
+class FrameLimiter {
+	public:
+		/** Creates a limiter.
+		 * @param targetFPS The maximum number of frames per second, 0 for no limit.
+		 */
+		FrameLimiter( double targetFPS = 0.0 );
+		/** Releases the timer resolution requested on Windows.
+		 */
+		~FrameLimiter();
+		/** This function changes the maximum frame rate.
+		 * @param targetFPS The maximum number of frames per second, 0 for no limit.
+		 */
+		void setTargetFPS( double targetFPS );
+		/** Get the maximum frame rate.
+		 * @return The maximum number of frames per second, 0 if there is no limit.
+		 */
+		double getTargetFPS() const;
+		/** This function waits until the next frame is due. Call it once per frame, after the frame was presented.
+		 */
+		void wait();
+		/** This function starts a new schedule, e.g. after the render loop paused. The next wait() returns immediately.
+		 */
+		void reset();
+		/** This function sets the swap interval of the current OpenGL context of the window.
+		 * @param interval 0 disables vsync, 1 waits for every vertical blank, -1 enables adaptive vsync
+		 * (falls back to 1, if the driver doesn't support it).
+		 * @return true if the interval was set.
+		 * @note There is no swap interval without a window, e.g. in headless mode.
+		 */
+		static bool setSwapInterval( int interval );
+
+	private:
+		unsigned long long mPeriod_;	//!< The time of one frame in nanoseconds, 0 for no limit
+		unsigned long long mNextFrame_;	//!< The time the next frame is due in nanoseconds, 0 if no schedule was started
+		bool mFineTimer_;				//!< true if the resolution of the system timer was raised
+};
+
+#endif
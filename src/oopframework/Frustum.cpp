@@ -0,0 +1,115 @@
+#include <Frustum.h>
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+	#define FRUSTUM_SSE
+	#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+	#define FRUSTUM_AVX
+	#include <immintrin.h>
+#endif
+
+Frustum::Frustum() {
+	// planes which every point lies in front of
+	for( unsigned p = 0; p < 6; ++p ) {
+		mA_[p] = mB_[p] = mC_[p] = 0.0f;
+		mD_[p] = 1.0f;
+	}
+}
+
+void
+Frustum::extract( float const projection[16], float const modelview[16] ) {
+	// the clip matrix maps the coordinates of the modelview matrix into clip space
+	float clip[16];
+	for( unsigned c = 0; c < 4; ++c )
+		for( unsigned r = 0; r < 4; ++r )
+			clip[c * 4 + r] = projection[r] * modelview[c * 4] + projection[4 + r] * modelview[c * 4 + 1] +
+							  projection[8 + r] * modelview[c * 4 + 2] + projection[12 + r] * modelview[c * 4 + 3];
+	// a point is inside if -w <= x,y,z <= w, every inequality is a plane of the rows of the clip matrix
+	// (left, right, bottom, top, near, far)
+	for( unsigned p = 0; p < 6; ++p ) {
+		unsigned row = p / 2;
+		float sign = ( p % 2 == 0 ) ? 1.0f : -1.0f;
+		float a = clip[3] + sign * clip[row];
+		float b = clip[7] + sign * clip[4 + row];
+		float c = clip[11] + sign * clip[8 + row];
+		float d = clip[15] + sign * clip[12 + row];
+		// normalized, so the plane equation gives the distance, which can be compared with the radius
+		float length = std::sqrt( a * a + b * b + c * c );
+		if( length > 0.0f ) {
+			a /= length;
+			b /= length;
+			c /= length;
+			d /= length;
+		}
+		mA_[p] = a;
+		mB_[p] = b;
+		mC_[p] = c;
+		mD_[p] = d;
+	}
+}
+
+bool
+Frustum::isVisible( float const center[3], float radius ) const {
+	for( unsigned p = 0; p < 6; ++p )
+		if( mA_[p] * center[0] + mB_[p] * center[1] + mC_[p] * center[2] + mD_[p] < -radius )
+			return false;
+	return true;
+}
+
+unsigned
+Frustum::cullSpheres( float const* x, float const* y, float const* z, float const* radius, unsigned count,
+					  unsigned char* visible ) const {
+	unsigned i = 0;
+	unsigned visibleCount = 0;
+#ifdef FRUSTUM_AVX
+	for( ; i + 8 <= count; i += 8 ) {
+		__m256 vx = _mm256_loadu_ps( x + i );
+		__m256 vy = _mm256_loadu_ps( y + i );
+		__m256 vz = _mm256_loadu_ps( z + i );
+		__m256 negRadius = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( radius + i ) );
+		__m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+		for( unsigned p = 0; p < 6; ++p ) {
+			__m256 distance = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( mA_[p] ), vx ),
+															 _mm256_mul_ps( _mm256_set1_ps( mB_[p] ), vy ) ),
+											  _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( mC_[p] ), vz ),
+															 _mm256_set1_ps( mD_[p] ) ) );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( distance, negRadius, _CMP_GE_OQ ) );
+		}
+		int mask = _mm256_movemask_ps( inside );
+		for( unsigned k = 0; k < 8; ++k ) {
+			visible[i + k] = (unsigned char)( ( mask >> k ) & 1 );
+			visibleCount += visible[i + k];
+		}
+	}
+#endif
+#ifdef FRUSTUM_SSE
+	for( ; i + 4 <= count; i += 4 ) {
+		__m128 vx = _mm_loadu_ps( x + i );
+		__m128 vy = _mm_loadu_ps( y + i );
+		__m128 vz = _mm_loadu_ps( z + i );
+		__m128 negRadius = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( radius + i ) );
+		__m128 inside = _mm_cmpeq_ps( vx, vx ); // all bits set, SSE has no integer constants
+		for( unsigned p = 0; p < 6; ++p ) {
+			__m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( mA_[p] ), vx ),
+													  _mm_mul_ps( _mm_set1_ps( mB_[p] ), vy ) ),
+										  _mm_add_ps( _mm_mul_ps( _mm_set1_ps( mC_[p] ), vz ),
+													  _mm_set1_ps( mD_[p] ) ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( distance, negRadius ) );
+		}
+		int mask = _mm_movemask_ps( inside );
+		for( unsigned k = 0; k < 4; ++k ) {
+			visible[i + k] = (unsigned char)( ( mask >> k ) & 1 );
+			visibleCount += visible[i + k];
+		}
+	}
+#endif
+	for( ; i < count; ++i ) {
+		float center[3] = { x[i], y[i], z[i] };
+		visible[i] = isVisible( center, radius[i] ) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
@@ -0,0 +1,57 @@
+#ifndef FRUSTUM
+#define FRUSTUM
+
+/** This class holds the six planes of the view frustum and tests bounding spheres against them.
+ * The planes are extracted from the product of the projection and the modelview matrix, so they are given in the
+ * coordinates of the modelview matrix (e.g. the world coordinates of a scene, if only the camera is applied).
+ * A sphere is culled if it lies completely behind one of the planes. The test is conservative: a sphere near a
+ * corner of the frustum may be kept although it is outside, but a visible sphere is never culled.
+ * cullSpheres() tests the spheres in batches of 4 with SSE (8 with AVX, if the compiler targets it, see the Makefile),
+ * which is why the spheres are given as separate arrays of their coordinates.
+ * @brief View frustum culling of bounding spheres.
+ * @code
+ * GLfloat projection[16], modelview[16];
+ * glGetFloatv( GL_PROJECTION_MATRIX, projection );
+ * glGetFloatv( GL_MODELVIEW_MATRIX, modelview );
+ * Frustum frustum;
+ * frustum.extract( projection, modelview );
+ * frustum.cullSpheres( x, y, z, radius, count, visible );
+ * @endcode
+ */
+class Frustum {
+	public:
+		/** Creates a frustum which contains everything.
+		 */
+		Frustum();
+		/** This function extracts the planes of the frustum.
+		 * @param projection The column major projection matrix.
+		 * @param modelview The column major modelview matrix.
+		 */
+		void extract( float const projection[16], float const modelview[16] );
+		/** This function tests a single sphere.
+		 * @param center The center of the sphere.
+		 * @param radius The radius of the sphere.
+		 * @return false if the sphere is completely outside.
+		 */
+		bool isVisible( float const center[3], float radius ) const;
+		/** This function tests many spheres.
+		 * @param x The x coordinates of the centers.
+		 * @param y The y coordinates of the centers.
+		 * @param z The z coordinates of the centers.
+		 * @param radius The radii.
+		 * @param count The number of spheres.
+		 * @param visible Receives 1 for every sphere which may be visible, 0 for every culled one.
+		 * @return The number of spheres which may be visible.
+		 */
+		unsigned cullSpheres( float const* x, float const* y, float const* z, float const* radius, unsigned count,
+							  unsigned char* visible ) const;
+
+	private:
+		// the planes a * x + b * y + c * z + d = 0 with the normal (a,b,c) pointing inwards, one array per coefficient
+		float mA_[6];	//!< The x components of the normals
+		float mB_[6];	//!< The y components of the normals
+		float mC_[6];	//!< The z components of the normals
+		float mD_[6];	//!< The distances from the origin
+};
+
+#endif
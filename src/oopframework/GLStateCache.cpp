@@ -0,0 +1,257 @@
+#include <GLStateCache.h>
+
+#include <cstring>
+
+// SINGLETON
+GLStateCache* GLStateCache::mInstance_ = NULL;
+
+GLStateCache&
+GLStateCache::getSingleton( ) {
+  if( !mInstance_ )
+    mInstance_ = new GLStateCache();
+  return *mInstance_;
+}
+
+GLStateCache*
+GLStateCache::getSingletonPtr( ) {
+  if( !mInstance_ )
+    mInstance_ = new GLStateCache();
+  return mInstance_;
+}
+
+GLStateCache::GLStateCache() :
+	mActiveUnit_(0),
+	mActiveUnitKnown_(false),
+	mIssued_(0),
+	mFiltered_(0),
+	mQueries_(0) {
+}
+
+void
+GLStateCache::enable( GLenum cap ) {
+	unsigned long key = getEnableKey( cap );
+	EnableMap::iterator it = mEnabled_.find( key );
+	if( it != mEnabled_.end() && it->second ) {
+		++mFiltered_;
+		return;
+	}
+	glEnable( cap );
+	mEnabled_[key] = true;
+	++mIssued_;
+}
+
+void
+GLStateCache::disable( GLenum cap ) {
+	unsigned long key = getEnableKey( cap );
+	EnableMap::iterator it = mEnabled_.find( key );
+	if( it != mEnabled_.end() && !it->second ) {
+		++mFiltered_;
+		return;
+	}
+	glDisable( cap );
+	mEnabled_[key] = false;
+	++mIssued_;
+}
+
+bool
+GLStateCache::isEnabled( GLenum cap ) {
+	unsigned long key = getEnableKey( cap );
+	EnableMap::iterator it = mEnabled_.find( key );
+	if( it != mEnabled_.end() )
+		return it->second;
+	bool enabled = ( glIsEnabled( cap ) == GL_TRUE );
+	mEnabled_[key] = enabled;
+	++mQueries_;
+	return enabled;
+}
+
+void
+GLStateCache::activeTexture( unsigned unit ) {
+	if( mActiveUnitKnown_ && mActiveUnit_ == unit ) {
+		++mFiltered_;
+		return;
+	}
+	// without multitexturing there is only unit 0
+	if( GLEW_VERSION_1_3 )
+		glActiveTexture( GL_TEXTURE0 + unit );
+	mActiveUnit_ = unit;
+	mActiveUnitKnown_ = true;
+	++mIssued_;
+}
+
+void
+GLStateCache::bindTexture( GLenum target, GLuint texture ) {
+	unsigned unit = getActiveUnit();
+	if( unit >= mBindings_.size() )
+		mBindings_.resize( unit + 1 );
+	BindingMap& bindings = mBindings_[unit];
+	BindingMap::iterator it = bindings.find( target );
+	if( it != bindings.end() && it->second == texture ) {
+		++mFiltered_;
+		return;
+	}
+	glBindTexture( target, texture );
+	bindings[target] = texture;
+	++mIssued_;
+}
+
+void
+GLStateCache::deleteTextures( GLsizei n, GLuint const* textures ) {
+	glDeleteTextures( n, textures );
+	// a deleted texture is unbound from every unit - the ID may be reused by the next glGenTextures()
+	for( unsigned unit = 0; unit < mBindings_.size(); ++unit ) {
+		for( BindingMap::iterator it = mBindings_[unit].begin(); it != mBindings_[unit].end(); ++it ) {
+			for( GLsizei i = 0; i < n; ++i ) {
+				if( textures[i] != 0 && it->second == textures[i] )
+					it->second = 0;
+			}
+		}
+	}
+}
+
+void
+GLStateCache::material( GLenum face, GLenum pname, GLfloat const* params ) {
+	if( pname == GL_AMBIENT_AND_DIFFUSE ) {
+		material( face, GL_AMBIENT, params );
+		material( face, GL_DIFFUSE, params );
+		return;
+	}
+	unsigned count = getParameterCount( pname );
+	if( count == 0 || ( face != GL_FRONT && face != GL_BACK && face != GL_FRONT_AND_BACK ) ) {
+		glMaterialfv( face, pname, params );
+		++mIssued_;
+		return;
+	}
+	// both sides are compared, so a call for GL_FRONT_AND_BACK is only filtered if none of them changes
+	bool changed = false;
+	if( face != GL_BACK )
+		changed |= updateParameter( mMaterial_, ( (unsigned long)GL_FRONT << 16 ) | pname, params, count );
+	if( face != GL_FRONT )
+		changed |= updateParameter( mMaterial_, ( (unsigned long)GL_BACK << 16 ) | pname, params, count );
+	if( !changed ) {
+		++mFiltered_;
+		return;
+	}
+	glMaterialfv( face, pname, params );
+	++mIssued_;
+}
+
+void
+GLStateCache::material( GLenum face, GLenum pname, GLfloat param ) {
+	material( face, pname, &param );
+}
+
+void
+GLStateCache::light( GLenum light, GLenum pname, GLfloat const* params ) {
+	// the position and the direction are stored in eye coordinates, they depend on the current modelview matrix
+	unsigned count = ( pname == GL_POSITION || pname == GL_SPOT_DIRECTION ) ? 0 : getParameterCount( pname );
+	if( count != 0 && !updateParameter( mLights_, ( (unsigned long)light << 16 ) | pname, params, count ) ) {
+		++mFiltered_;
+		return;
+	}
+	glLightfv( light, pname, params );
+	++mIssued_;
+}
+
+void
+GLStateCache::invalidate() {
+	mEnabled_.clear();
+	mBindings_.clear();
+	mActiveUnitKnown_ = false;
+	mMaterial_.clear();
+	mLights_.clear();
+}
+
+unsigned long
+GLStateCache::getIssuedCount() const {
+	return mIssued_;
+}
+
+unsigned long
+GLStateCache::getFilteredCount() const {
+	return mFiltered_;
+}
+
+unsigned long
+GLStateCache::getQueryCount() const {
+	return mQueries_;
+}
+
+void
+GLStateCache::resetCounters() {
+	mIssued_ = 0;
+	mFiltered_ = 0;
+	mQueries_ = 0;
+}
+
+unsigned long
+GLStateCache::getEnableKey( GLenum cap ) {
+	switch( cap ) {
+		case GL_TEXTURE_1D:
+		case GL_TEXTURE_2D:
+		case GL_TEXTURE_3D:
+		case GL_TEXTURE_CUBE_MAP:
+		case GL_TEXTURE_GEN_S:
+		case GL_TEXTURE_GEN_T:
+		case GL_TEXTURE_GEN_R:
+		case GL_TEXTURE_GEN_Q:
+			return ( (unsigned long)( getActiveUnit() + 1 ) << 16 ) | cap;
+		default:
+			return cap;
+	}
+}
+
+unsigned
+GLStateCache::getActiveUnit() {
+	if( !mActiveUnitKnown_ ) {
+		GLint unit = GL_TEXTURE0;
+		if( GLEW_VERSION_1_3 ) {
+			glGetIntegerv( GL_ACTIVE_TEXTURE, &unit );
+			++mQueries_;
+		}
+		mActiveUnit_ = (unsigned)( unit - GL_TEXTURE0 );
+		mActiveUnitKnown_ = true;
+	}
+	return mActiveUnit_;
+}
+
+bool
+GLStateCache::updateParameter( ParameterMap& map, unsigned long key, GLfloat const* params, unsigned count ) {
+	std::pair< ParameterMap::iterator, bool > res = map.insert( ParameterMap::value_type( key, Parameter() ) );
+	Parameter& p = res.first->second;
+	if( !res.second && std::memcmp( p.values, params, count * sizeof(GLfloat) ) == 0 )
+		return false;
+	std::memset( p.values, 0, sizeof(p.values) );
+	std::memcpy( p.values, params, count * sizeof(GLfloat) );
+	return true;
+}
+
+unsigned
+GLStateCache::getParameterCount( GLenum pname ) {
+	switch( pname ) {
+		case GL_AMBIENT:
+		case GL_DIFFUSE:
+		case GL_SPECULAR:
+		case GL_EMISSION:
+			return 4;
+		case GL_SHININESS:
+		case GL_SPOT_EXPONENT:
+		case GL_SPOT_CUTOFF:
+		case GL_CONSTANT_ATTENUATION:
+		case GL_LINEAR_ATTENUATION:
+		case GL_QUADRATIC_ATTENUATION:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+void
+GLStateCache::destroy() {
+  if( mInstance_ )
+    delete mInstance_;
+  mInstance_ = NULL;
+}
+
+GLStateCache::~GLStateCache() {
+}
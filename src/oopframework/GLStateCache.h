@@ -0,0 +1,154 @@
+#ifndef GLSTATECACHE
+#define GLSTATECACHE
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <HashMap.h>
+
+#include <vector>
+
+/** This class shadows a part of the OpenGL state and only forwards calls to the driver which change it.
+ * It keeps the enable bits (the texture targets per texture unit), the bound textures per unit, the material
+ * and the light parameters. Every call counts as either issued or filtered, so the effect can be measured.
+ * State which is not known yet (e.g. after invalidate()) is always forwarded once.
+ * @note All OpenGL state changes of the covered kind have to go through the cache. Code which changes the state
+ * directly (e.g. glPopAttrib()) has to call invalidate() afterwards.
+ * @note The light positions and spot directions are transformed by the current modelview matrix, so they are always forwarded.
+ * @brief A filter for redundant OpenGL state changes.
+ * @code
+ * GLStateCache* sc = GLStateCache::getSingletonPtr();
+ * sc->enable( GL_TEXTURE_2D );
+ * sc->bindTexture( GL_TEXTURE_2D, id );	// no driver call if id is already bound
+ * @endcode
+ */
+class GLStateCache {
+	public:
+		/** Get a reference to one single instance.
+		 * @return A reference of one single instance.
+		 */
+		static GLStateCache& getSingleton( );
+		/** Get a pointer to one single instance.
+		 * @return A pointer of one single instance.
+		 */
+		static GLStateCache* getSingletonPtr( );
+		/** Destroys the one single instance.
+		 */
+		static void destroy();
+
+		/** This function enables a capability (glEnable).
+		 * @param cap The capability, e.g. GL_LIGHTING or GL_TEXTURE_2D (for the active texture unit).
+		 */
+		void enable( GLenum cap );
+		/** This function disables a capability (glDisable).
+		 * @param cap The capability.
+		 */
+		void disable( GLenum cap );
+		/** This function returns the state of a capability. OpenGL is only asked for capabilities which are not known yet.
+		 * @param cap The capability.
+		 * @return true if the capability is enabled.
+		 */
+		bool isEnabled( GLenum cap );
+		/** This function selects the active texture unit (glActiveTexture).
+		 * @param unit The number of the unit, starting with 0 (not GL_TEXTURE0).
+		 */
+		void activeTexture( unsigned unit );
+		/** This function binds a texture to the active texture unit (glBindTexture).
+		 * @param target The texture type, e.g. GL_TEXTURE_2D.
+		 * @param texture The GL-ID of the texture.
+		 */
+		void bindTexture( GLenum target, GLuint texture );
+		/** This function deletes textures (glDeleteTextures). The units they were bound to fall back to texture 0.
+		 * @param n The number of textures.
+		 * @param textures The GL-IDs of the textures.
+		 */
+		void deleteTextures( GLsizei n, GLuint const* textures );
+		/** This function sets a material parameter (glMaterialfv).
+		 * @param face GL_FRONT, GL_BACK or GL_FRONT_AND_BACK.
+		 * @param pname The parameter, e.g. GL_DIFFUSE.
+		 * @param params The values of the parameter.
+		 */
+		void material( GLenum face, GLenum pname, GLfloat const* params );
+		/** This function sets a material parameter with a single value (glMaterialf), e.g. GL_SHININESS.
+		 * @param face GL_FRONT, GL_BACK or GL_FRONT_AND_BACK.
+		 * @param pname The parameter.
+		 * @param param The value of the parameter.
+		 */
+		void material( GLenum face, GLenum pname, GLfloat param );
+		/** This function sets a light parameter (glLightfv).
+		 * @param light The light, e.g. GL_LIGHT0.
+		 * @param pname The parameter, e.g. GL_DIFFUSE.
+		 * @param params The values of the parameter.
+		 */
+		void light( GLenum light, GLenum pname, GLfloat const* params );
+		/** This function forgets the whole shadowed state. Call it after the state was changed without the cache.
+		 */
+		void invalidate();
+
+		/** Get the number of calls which were forwarded to OpenGL.
+		 * @return The number of issued calls since the last resetCounters().
+		 */
+		unsigned long getIssuedCount() const;
+		/** Get the number of calls which were dropped, because they would not have changed anything.
+		 * @return The number of filtered calls since the last resetCounters().
+		 */
+		unsigned long getFilteredCount() const;
+		/** Get the number of state queries (glIsEnabled, glGetIntegerv) which were sent to OpenGL.
+		 * @return The number of queries since the last resetCounters().
+		 */
+		unsigned long getQueryCount() const;
+		/** Sets all counters to zero.
+		 */
+		void resetCounters();
+
+	private:
+		/** The values of a material or light parameter.
+		 */
+		struct Parameter {
+			GLfloat values[4];	//!< The values, unused ones are 0
+		};
+		typedef std::tr1::unordered_map< unsigned long, bool > EnableMap;
+		typedef std::tr1::unordered_map< GLenum, GLuint > BindingMap;
+		typedef std::tr1::unordered_map< unsigned long, Parameter > ParameterMap;
+
+		static GLStateCache* mInstance_; //!< the one single instance
+		GLStateCache(); //!< constructor
+		~GLStateCache(); //!< destructor
+
+		/** This internal function returns the key of a capability in mEnabled_.
+		 * The texture targets are enabled per texture unit, so the active unit is part of their key.
+		 * @param cap The capability.
+		 * @return The key.
+		 */
+		unsigned long getEnableKey( GLenum cap );
+		/** This internal function returns the active texture unit and asks OpenGL if it is not known.
+		 * @return The number of the active unit.
+		 */
+		unsigned getActiveUnit();
+		/** This internal function compares a parameter with the shadowed value and stores it if it differs.
+		 * @param map The shadowed parameters.
+		 * @param key The key of the parameter.
+		 * @param params The new values.
+		 * @param count The number of values.
+		 * @return true if the parameter changed and has to be forwarded.
+		 */
+		bool updateParameter( ParameterMap& map, unsigned long key, GLfloat const* params, unsigned count );
+		/** This internal function returns the number of values of a material or light parameter.
+		 * @param pname The parameter.
+		 * @return The number of values, 0 if the parameter is not shadowed.
+		 */
+		static unsigned getParameterCount( GLenum pname );
+
+		EnableMap mEnabled_;				//!< The known enable bits
+		std::vector< BindingMap > mBindings_;	//!< The bound textures of every texture unit
+		unsigned mActiveUnit_;				//!< The active texture unit
+		bool mActiveUnitKnown_;				//!< false if the active unit has to be queried
+		ParameterMap mMaterial_;			//!< The material parameters of the front and the back faces
+		ParameterMap mLights_;				//!< The parameters of the lights
+
+		unsigned long mIssued_;				//!< The number of forwarded calls
+		unsigned long mFiltered_;			//!< The number of dropped calls
+		unsigned long mQueries_;			//!< The number of state queries
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <GPUTimer.h>
+
+#include <algorithm>
+
+GPUTimer::GPUTimer() :
+	mAvailable_(false),
+	mSlot_(0),
+	mActive_(-1) {
+}
+
+unsigned
+GPUTimer::addPass( std::string const& name ) {
+	Pass pass;
+	pass.name = name;
+	for( unsigned i = 0; i < LATENCY; ++i ) {
+		pass.queries[i] = 0;
+		pass.issued[i] = false;
+	}
+	pass.count = 0;
+	pass.dropped = 0;
+	pass.total = 0.0;
+	pass.longest = 0.0;
+	pass.last = 0.0;
+	mPasses_.push_back( pass );
+	return (unsigned)mPasses_.size() - 1;
+}
+
+bool
+GPUTimer::init() {
+	// the query objects themselves are part of OpenGL 1.5
+	if( !GLEW_EXT_timer_query || !GLEW_VERSION_1_5 ) {
+		LOG_WARNING( RENDER, "GPUTimer: GL_EXT_timer_query is not supported, the GPU times are unavailable." );
+		return false;
+	}
+	for( unsigned i = 0; i < mPasses_.size(); ++i )
+		glGenQueries( LATENCY, mPasses_[i].queries );
+	mAvailable_ = true;
+	LOG_INFO( RENDER, "GPUTimer: Measuring " << mPasses_.size() << " passes with a latency of " << LATENCY << " frames." );
+	return true;
+}
+
+bool
+GPUTimer::isAvailable() const {
+	return mAvailable_;
+}
+
+void
+GPUTimer::beginFrame() {
+	if( !mAvailable_ )
+		return;
+	mSlot_ = ( mSlot_ + 1 ) % LATENCY;
+	// the queries of this slot were issued LATENCY frames ago
+	collect( mSlot_ );
+}
+
+void
+GPUTimer::begin( unsigned pass ) {
+	if( !mAvailable_ || mActive_ >= 0 || pass >= mPasses_.size() )
+		return;
+	glBeginQuery( GL_TIME_ELAPSED_EXT, mPasses_[pass].queries[mSlot_] );
+	mActive_ = (int)pass;
+}
+
+void
+GPUTimer::end() {
+	if( mActive_ < 0 )
+		return;
+	glEndQuery( GL_TIME_ELAPSED_EXT );
+	mPasses_[mActive_].issued[mSlot_] = true;
+	mActive_ = -1;
+}
+
+void
+GPUTimer::collect( unsigned slot ) {
+	for( unsigned i = 0; i < mPasses_.size(); ++i ) {
+		Pass& pass = mPasses_[i];
+		if( !pass.issued[slot] )
+			continue;
+		pass.issued[slot] = false;
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv( pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available );
+		// waiting for the result would stall the pipeline
+		if( available == GL_FALSE ) {
+			++pass.dropped;
+			continue;
+		}
+		GLuint64EXT elapsed = 0;
+		glGetQueryObjectui64vEXT( pass.queries[slot], GL_QUERY_RESULT, &elapsed );
+		pass.last = elapsed / 1000000.0;
+		pass.total += pass.last;
+		pass.longest = std::max( pass.longest, pass.last );
+		++pass.count;
+	}
+}
+
+double
+GPUTimer::getLastTime( unsigned pass ) const {
+	return ( pass < mPasses_.size() ) ? mPasses_[pass].last : 0.0;
+}
+
+double
+GPUTimer::getMeanTime( unsigned pass ) const {
+	if( pass >= mPasses_.size() || mPasses_[pass].count == 0 )
+		return 0.0;
+	return mPasses_[pass].total / mPasses_[pass].count;
+}
+
+void
+GPUTimer::logSummary() const {
+	if( !mAvailable_ ) {
+		LOG_INFO( RENDER, "GPUTimer: GPU times unavailable." );
+		return;
+	}
+	LOG_INFO( RENDER, "GPUTimer: GPU time per pass (mean / longest):" );
+	for( unsigned i = 0; i < mPasses_.size(); ++i ) {
+		Pass const& pass = mPasses_[i];
+		LOG_INFO( RENDER, "GPUTimer:   " << pass.name << ": " << getMeanTime( i ) << " ms / " << pass.longest << " ms ("
+						  << pass.count << " frames, " << pass.dropped << " results not ready in time)" );
+	}
+}
+
+GPUTimer::~GPUTimer() {
+	if( !mAvailable_ )
+		return;
+	for( unsigned i = 0; i < mPasses_.size(); ++i )
+		glDeleteQueries( LATENCY, mPasses_[i].queries );
+}
@@ -0,0 +1,131 @@
+#ifndef GPUTIMER
+#define GPUTIMER
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+
+#include <string>
+#include <vector>
+
+/** This class measures the time the GPU spends on the passes of a frame with GL_EXT_timer_query.
+ * The CPU only records the commands, so the time of a pass on the CPU (see Profiler) says nothing about the time
+ * the GPU needs to execute them. A timer query is wrapped around every pass instead. Reading a result right after
+ * the frame would stall the CPU until the GPU caught up, so the queries of a frame are kept in a ring of LATENCY
+ * frames and read when their slot is used again. Results which are still not available then are dropped instead
+ * of waited for.
+ * Without GL_EXT_timer_query the timer is unavailable: begin() and end() do nothing and the report says so.
+ * The time elapsed queries can't be nested, only one pass can be measured at a time.
+ * @brief Per pass GPU timing.
+ * @code
+ * GPUTimer timer;
+ * unsigned earth = timer.addPass( "earth" );
+ * timer.init();	// needs the OpenGL context
+ * while( running ) {
+ *     timer.beginFrame();
+ *     timer.begin( earth );
+ *     drawEarth();
+ *     timer.end();
+ *     SDL_GL_SwapBuffers();
+ * }
+ * timer.logSummary();
+ * @endcode
+ */
+class GPUTimer {
+	public:
+		static unsigned const LATENCY = 4;	//!< The number of frames a query may take until it is read
+
+		/** Creates a timer without any passes.
+		 */
+		GPUTimer();
+		/** Deletes the queries. The OpenGL context has to be current.
+		 */
+		~GPUTimer();
+		/** This function adds a pass. All passes have to be added before init().
+		 * @param name The name of the pass in the report.
+		 * @return The number of the pass, which is given to begin().
+		 */
+		unsigned addPass( std::string const& name );
+		/** This function creates the queries of all passes.
+		 * @return true if the driver supports timer queries.
+		 */
+		bool init();
+		/** This function tells whether the GPU times are measured.
+		 * @return true if init() succeeded.
+		 */
+		bool isAvailable() const;
+		/** This function starts a new frame and collects the results of the frame which used its queries before.
+		 */
+		void beginFrame();
+		/** This function starts the measurement of a pass.
+		 * @param pass The number of the pass (see addPass()).
+		 */
+		void begin( unsigned pass );
+		/** This function ends the measurement of the pass started last.
+		 */
+		void end();
+		/** Get the last collected time of a pass.
+		 * @param pass The number of the pass.
+		 * @return The GPU time in milliseconds, 0 if none was collected yet.
+		 */
+		double getLastTime( unsigned pass ) const;
+		/** Get the mean time of a pass.
+		 * @param pass The number of the pass.
+		 * @return The mean GPU time of all collected frames in milliseconds.
+		 */
+		double getMeanTime( unsigned pass ) const;
+		/** This function logs the mean and the maximum GPU time of every pass, or that the timer is unavailable.
+		 */
+		void logSummary() const;
+
+	private:
+		/** The measurements of one pass.
+		 */
+		struct Pass {
+			std::string name;				//!< The name of the pass
+			GLuint queries[LATENCY];		//!< One query per frame of the ring
+			bool issued[LATENCY];			//!< true if the query of the slot was issued and not read yet
+			unsigned long count;			//!< The number of collected times
+			unsigned long dropped;			//!< The number of times which weren't available in time
+			double total;					//!< The sum of the collected times in milliseconds
+			double longest;					//!< The longest collected time in milliseconds
+			double last;					//!< The last collected time in milliseconds
+		};
+
+		/** This function reads the results of the queries of a slot.
+		 * @param slot The slot of the ring.
+		 */
+		void collect( unsigned slot );
+
+		std::vector< Pass > mPasses_;	//!< The passes
+		bool mAvailable_;				//!< true if the queries were created
+		unsigned mSlot_;				//!< The slot of the ring used by the current frame
+		int mActive_;					//!< The pass which is measured right now, -1 if none is
+};
+
+/** This class measures a pass for the lifetime of a scope.
+ * @brief A scoped pass of the GPUTimer.
+ */
+class GPUZone {
+	public:
+		/** Starts the measurement.
+		 * @param timer The timer, NULL if nothing is measured.
+		 * @param pass The number of the pass.
+		 */
+		GPUZone( GPUTimer* timer, unsigned pass ) :
+			mTimer_(timer) {
+			if( mTimer_ != NULL )
+				mTimer_->begin( pass );
+		}
+		/** Ends the measurement.
+		 */
+		~GPUZone() {
+			if( mTimer_ != NULL )
+				mTimer_->end();
+		}
+	private:
+		GPUTimer* mTimer_;	//!< The timer, NULL if nothing is measured
+};
+
+#endif
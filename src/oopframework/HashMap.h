@@ -0,0 +1,15 @@
+#ifndef HASHMAP
+#define HASHMAP
+
+/* The hash containers of TR1 are available in Visual Studio 2008 (SP1) and in the GNU libstdc++,
+ * so they are used instead of the C++11 ones. Include this header to get std::tr1::unordered_map and std::tr1::unordered_set.
+ */
+#ifdef _MSC_VER
+	#include <unordered_map>
+	#include <unordered_set>
+#else
+	#include <tr1/unordered_map>
+	#include <tr1/unordered_set>
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+#include <HeadlessContext.h>
+#include <ExtensionString.h>
+
+#ifdef RENDERENGINE_EGL
+	// keep the X11 headers (and their macros like None or Status) out
+	#define EGL_NO_X11
+	#define MESA_EGL_NO_X11_HEADERS
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+
+	#ifndef EGL_PLATFORM_SURFACELESS_MESA
+		#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+	#endif
+#endif
+
+HeadlessContext::HeadlessContext() :
+	mWidth_(0),
+	mHeight_(0),
+	mDisplay_(NULL),
+	mContext_(NULL),
+	mSurface_(NULL),
+	mFramebuffer_(0),
+	mColorBuffer_(0),
+	mDepthBuffer_(0) {
+}
+
+bool
+HeadlessContext::create( unsigned width, unsigned height, std::string& error ) {
+	mWidth_ = width;
+	mHeight_ = height;
+#ifdef RENDERENGINE_EGL
+	EGLDisplay display = EGL_NO_DISPLAY;
+	bool surfaceless = false;
+	// the surfaceless platform of Mesa works without any display server
+	char const* clientExtensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+	if( ExtensionString::contains( clientExtensions, "EGL_MESA_platform_surfaceless" ) ) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+		if( getPlatformDisplay != NULL ) {
+			display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+			surfaceless = ( display != EGL_NO_DISPLAY );
+		}
+	}
+	if( display == EGL_NO_DISPLAY )
+		display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+	EGLint major = 0, minor = 0;
+	if( display == EGL_NO_DISPLAY || !eglInitialize( display, &major, &minor ) ) {
+		error = "Could not initialize an EGL display.";
+		return false;
+	}
+	mDisplay_ = display;
+	// without surfaceless contexts a pbuffer is needed to make the context current
+	surfaceless = surfaceless && ExtensionString::contains( eglQueryString( display, EGL_EXTENSIONS ), "EGL_KHR_surfaceless_context" );
+	if( !eglBindAPI( EGL_OPENGL_API ) ) {
+		error = "The EGL display does not support desktop OpenGL.";
+		return false;
+	}
+
+	EGLint const configAttribs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? EGL_DONT_CARE : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if( !eglChooseConfig( display, configAttribs, &config, 1, &numConfigs ) || numConfigs == 0 ) {
+		error = "No EGL config for desktop OpenGL was found.";
+		return false;
+	}
+	// the default context is a compatibility context, so the fixed function pipeline is available
+	EGLContext context = eglCreateContext( display, config, EGL_NO_CONTEXT, NULL );
+	if( context == EGL_NO_CONTEXT ) {
+		error = "Could not create an EGL context.";
+		return false;
+	}
+	mContext_ = context;
+	EGLSurface surface = EGL_NO_SURFACE;
+	if( !surfaceless ) {
+		EGLint const pbufferAttribs[] = { EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE };
+		surface = eglCreatePbufferSurface( display, config, pbufferAttribs );
+		if( surface == EGL_NO_SURFACE ) {
+			error = "Could not create an EGL pbuffer.";
+			return false;
+		}
+		mSurface_ = surface;
+	}
+	if( !eglMakeCurrent( display, surface, surface, context ) ) {
+		error = "Could not make the EGL context current.";
+		return false;
+	}
+	LOG_INFO( RENDER, "HeadlessContext: EGL " << major << "." << minor << ( surfaceless ? " surfaceless" : " with a pbuffer" ) << ", "
+					  << glGetString( GL_RENDERER ) );
+	return true;
+#else
+	error = "The headless mode is not compiled in (build with RENDERENGINE_EGL).";
+	return false;
+#endif
+}
+
+bool
+HeadlessContext::createFramebuffer( std::string& error ) {
+	if( !GLEW_EXT_framebuffer_object ) {
+		error = "Framebuffer objects are not supported.";
+		return false;
+	}
+	glGenRenderbuffersEXT( 1, &mColorBuffer_ );
+	glBindRenderbufferEXT( GL_RENDERBUFFER_EXT, mColorBuffer_ );
+	glRenderbufferStorageEXT( GL_RENDERBUFFER_EXT, GL_RGBA8, mWidth_, mHeight_ );
+	glGenRenderbuffersEXT( 1, &mDepthBuffer_ );
+	glBindRenderbufferEXT( GL_RENDERBUFFER_EXT, mDepthBuffer_ );
+	glRenderbufferStorageEXT( GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT24, mWidth_, mHeight_ );
+	glBindRenderbufferEXT( GL_RENDERBUFFER_EXT, 0 );
+
+	glGenFramebuffersEXT( 1, &mFramebuffer_ );
+	glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, mFramebuffer_ );
+	glFramebufferRenderbufferEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, mColorBuffer_ );
+	glFramebufferRenderbufferEXT( GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, mDepthBuffer_ );
+	GLenum status = glCheckFramebufferStatusEXT( GL_FRAMEBUFFER_EXT );
+	if( status != GL_FRAMEBUFFER_COMPLETE_EXT ) {
+		error = "The framebuffer object is not complete.";
+		return false;
+	}
+	// the framebuffer stays bound, so it is the target of the drawing and of glReadPixels()
+	glDrawBuffer( GL_COLOR_ATTACHMENT0_EXT );
+	glReadBuffer( GL_COLOR_ATTACHMENT0_EXT );
+	return true;
+}
+
+bool
+HeadlessContext::isSupported() {
+#ifdef RENDERENGINE_EGL
+	return true;
+#else
+	return false;
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+	if( mFramebuffer_ != 0 ) {
+		glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+		glDeleteFramebuffersEXT( 1, &mFramebuffer_ );
+	}
+	if( mColorBuffer_ != 0 )
+		glDeleteRenderbuffersEXT( 1, &mColorBuffer_ );
+	if( mDepthBuffer_ != 0 )
+		glDeleteRenderbuffersEXT( 1, &mDepthBuffer_ );
+#ifdef RENDERENGINE_EGL
+	if( mDisplay_ != NULL ) {
+		eglMakeCurrent( (EGLDisplay)mDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+		if( mSurface_ != NULL )
+			eglDestroySurface( (EGLDisplay)mDisplay_, (EGLSurface)mSurface_ );
+		if( mContext_ != NULL )
+			eglDestroyContext( (EGLDisplay)mDisplay_, (EGLContext)mContext_ );
+		eglTerminate( (EGLDisplay)mDisplay_ );
+	}
+#endif
+}
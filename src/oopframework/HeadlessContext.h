@@ -0,0 +1,65 @@
+#ifndef HEADLESSCONTEXT
+#define HEADLESSCONTEXT
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+
+#include <string>
+
+/** This class creates an OpenGL context without any window and a framebuffer object to render into.
+ * The context is created with EGL. Mesa's surfaceless platform is preferred, it needs neither a display server
+ * nor a GPU (it runs on llvmpipe). If it is not available, the default display with a small pbuffer is used.
+ * The EGL backend is only compiled in with RENDERENGINE_EGL defined (see the Makefile), else create() fails.
+ * @brief A windowless OpenGL context with an offscreen framebuffer.
+ * @note GLEW has to be able to resolve the functions of an EGL context: GLEW 2.x built for EGL, or a libGL of glvnd.
+ * @code
+ * HeadlessContext ctx;
+ * std::string error;
+ * if( ctx.create( 1024, 768, error ) && glewInit() == GLEW_OK && ctx.createFramebuffer( error ) )
+ *     ; // everything rendered now ends up in the framebuffer object
+ * @endcode
+ */
+class HeadlessContext {
+	public:
+		/** Creates an object without a context.
+		 */
+		HeadlessContext();
+		/** Deletes the framebuffer object and the context.
+		 */
+		~HeadlessContext();
+		/** This function creates the context and makes it current for the calling thread.
+		 * @param width The width of the framebuffer.
+		 * @param height The height of the framebuffer.
+		 * @param error The reason of a failure.
+		 * @return true if the context was created.
+		 */
+		bool create( unsigned width, unsigned height, std::string& error );
+		/** This function creates the framebuffer object with a color and a depth buffer and binds it.
+		 * It has to be called after create() and after GLEW was initialized.
+		 * @param error The reason of a failure.
+		 * @return true if the framebuffer is complete.
+		 */
+		bool createFramebuffer( std::string& error );
+		/** Tells whether the EGL backend was compiled in.
+		 * @return true if create() can succeed.
+		 */
+		static bool isSupported();
+
+	private:
+		// the context can't be shared by copies
+		HeadlessContext( HeadlessContext const& );
+		HeadlessContext& operator=( HeadlessContext const& );
+
+		unsigned mWidth_;			//!< The width of the framebuffer
+		unsigned mHeight_;			//!< The height of the framebuffer
+		void* mDisplay_;			//!< The EGLDisplay
+		void* mContext_;			//!< The EGLContext
+		void* mSurface_;			//!< The EGLSurface of the pbuffer, NULL on the surfaceless platform
+		GLuint mFramebuffer_;		//!< The framebuffer object
+		GLuint mColorBuffer_;		//!< The renderbuffer of the colors
+		GLuint mDepthBuffer_;		//!< The renderbuffer of the depth
+};
+
+#endif
@@ -0,0 +1,402 @@
+#include <ImageFilter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+	#define IMAGEFILTER_SSE2
+	#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+	#define IMAGEFILTER_AVX2
+	#include <immintrin.h>
+#endif
+
+/** Adds two rows of bytes into a row of 16 bit sums.
+ * @param a The first row.
+ * @param b The second row.
+ * @param sum The sums of a[i] + b[i].
+ * @param count The number of bytes per row.
+ */
+static void
+addRows( unsigned char const* a, unsigned char const* b, unsigned short* sum, unsigned count ) {
+	unsigned i = 0;
+#ifdef IMAGEFILTER_AVX2
+	for( ; i + 32 <= count; i += 32 ) {
+		__m128i a0 = _mm_loadu_si128( (__m128i const*)(a + i) );
+		__m128i a1 = _mm_loadu_si128( (__m128i const*)(a + i + 16) );
+		__m128i b0 = _mm_loadu_si128( (__m128i const*)(b + i) );
+		__m128i b1 = _mm_loadu_si128( (__m128i const*)(b + i + 16) );
+		__m256i lo = _mm256_add_epi16( _mm256_cvtepu8_epi16( a0 ), _mm256_cvtepu8_epi16( b0 ) );
+		__m256i hi = _mm256_add_epi16( _mm256_cvtepu8_epi16( a1 ), _mm256_cvtepu8_epi16( b1 ) );
+		_mm256_storeu_si256( (__m256i*)(sum + i), lo );
+		_mm256_storeu_si256( (__m256i*)(sum + i + 16), hi );
+	}
+#endif
+#ifdef IMAGEFILTER_SSE2
+	__m128i const zero = _mm_setzero_si128();
+	for( ; i + 16 <= count; i += 16 ) {
+		__m128i va = _mm_loadu_si128( (__m128i const*)(a + i) );
+		__m128i vb = _mm_loadu_si128( (__m128i const*)(b + i) );
+		__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( va, zero ), _mm_unpacklo_epi8( vb, zero ) );
+		__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( va, zero ), _mm_unpackhi_epi8( vb, zero ) );
+		_mm_storeu_si128( (__m128i*)(sum + i), lo );
+		_mm_storeu_si128( (__m128i*)(sum + i + 8), hi );
+	}
+#endif
+	for( ; i < count; ++i )
+		sum[i] = (unsigned short)( a[i] + b[i] );
+}
+
+void
+ImageFilter::downsample2x2( ImageData const& src, ImageData& dst ) {
+	unsigned c = src.components;
+	dst.width = std::max( 1u, src.width / 2 );
+	dst.height = std::max( 1u, src.height / 2 );
+	dst.components = c;
+	dst.format = src.format;
+	dst.pixels.resize( dst.width * dst.height * c );
+
+	unsigned srcPitch = src.width * c;
+	unsigned dstPitch = dst.width * c;
+	// the source columns of the last output pixel (equal if the source has a width of 1)
+	unsigned pairBytes = ( src.width > 1 ) ? 2 * c : c;
+	std::vector< unsigned short > sum( srcPitch + 16 );
+	for( unsigned y = 0; y < dst.height; ++y ) {
+		unsigned y0 = std::min( 2 * y, src.height - 1 );
+		unsigned y1 = std::min( 2 * y + 1, src.height - 1 );
+		unsigned char const* row0 = &src.pixels[y0 * srcPitch];
+		unsigned char const* row1 = &src.pixels[y1 * srcPitch];
+		unsigned char* out = &dst.pixels[y * dstPitch];
+		// vertical pass - independent of the pixel format
+		addRows( row0, row1, &sum[0], dst.width * pairBytes );
+		// horizontal pass
+		unsigned x = 0;
+#ifdef IMAGEFILTER_SSE2
+		if( c == 4 && src.width > 1 ) {
+			// two output pixels per iteration: add the neighbouring 16 bit pixels and round
+			__m128i const round = _mm_set1_epi16( 2 );
+			for( ; x + 2 <= dst.width; x += 2 ) {
+				__m128i v = _mm_loadu_si128( (__m128i const*)&sum[x * 8] );	// two source pixels (8 channel sums)
+				__m128i h = _mm_add_epi16( v, _mm_srli_si128( v, 8 ) );		// p0+p1 in the low half
+				__m128i w = _mm_loadu_si128( (__m128i const*)&sum[x * 8 + 8] );
+				__m128i k = _mm_add_epi16( w, _mm_srli_si128( w, 8 ) );		// p2+p3 in the low half
+				__m128i r = _mm_srli_epi16( _mm_add_epi16( _mm_unpacklo_epi64( h, k ), round ), 2 );
+				_mm_storel_epi64( (__m128i*)(out + x * 4), _mm_packus_epi16( r, r ) );
+			}
+		}
+#endif
+		for( ; x < dst.width; ++x ) {
+			unsigned short const* s = &sum[x * pairBytes];
+			unsigned second = pairBytes - c;
+			for( unsigned i = 0; i < c; ++i )
+				out[x * c + i] = (unsigned char)( ( s[i] + s[i + second] + 2 ) >> 2 );
+		}
+	}
+}
+
+/** The lookup tables for the conversion between sRGB and linear 16 bit values.
+ */
+struct GammaTables {
+	unsigned short toLinear[256];	//!< sRGB byte to linear value in [0, 65535]
+	unsigned char  toSRGB[4096];	//!< linear value >> 4 to sRGB byte
+
+	GammaTables() {
+		for( unsigned i = 0; i < 256; ++i ) {
+			double c = i / 255.0;
+			double l = ( c <= 0.04045 ) ? c / 12.92 : std::pow( ( c + 0.055 ) / 1.055, 2.4 );
+			toLinear[i] = (unsigned short)( l * 65535.0 + 0.5 );
+		}
+		for( unsigned i = 0; i < 4096; ++i ) {
+			double l = ( i + 0.5 ) / 4096.0;
+			double c = ( l <= 0.0031308 ) ? l * 12.92 : 1.055 * std::pow( l, 1.0 / 2.4 ) - 0.055;
+			toSRGB[i] = (unsigned char)std::min( 255.0, c * 255.0 + 0.5 );
+		}
+	}
+};
+// built at startup, so the decode workers never race on the initialization
+static GammaTables const tables;
+
+void
+ImageFilter::downsample2x2Gamma( ImageData const& src, ImageData& dst ) {
+	unsigned c = src.components;
+	dst.width = std::max( 1u, src.width / 2 );
+	dst.height = std::max( 1u, src.height / 2 );
+	dst.components = c;
+	dst.format = src.format;
+	dst.pixels.resize( dst.width * dst.height * c );
+	// the alpha channel is not gamma encoded
+	unsigned alpha = ( c == 4 || c == 2 ) ? c - 1 : c;
+	for( unsigned y = 0; y < dst.height; ++y ) {
+		unsigned y0 = std::min( 2 * y, src.height - 1 );
+		unsigned y1 = std::min( 2 * y + 1, src.height - 1 );
+		for( unsigned x = 0; x < dst.width; ++x ) {
+			unsigned x0 = std::min( 2 * x, src.width - 1 );
+			unsigned x1 = std::min( 2 * x + 1, src.width - 1 );
+			unsigned char const* p00 = &src.pixels[( y0 * src.width + x0 ) * c];
+			unsigned char const* p01 = &src.pixels[( y0 * src.width + x1 ) * c];
+			unsigned char const* p10 = &src.pixels[( y1 * src.width + x0 ) * c];
+			unsigned char const* p11 = &src.pixels[( y1 * src.width + x1 ) * c];
+			unsigned char* out = &dst.pixels[( y * dst.width + x ) * c];
+			for( unsigned i = 0; i < c; ++i ) {
+				if( i == alpha )
+					out[i] = (unsigned char)( ( p00[i] + p01[i] + p10[i] + p11[i] + 2 ) >> 2 );
+				else {
+					unsigned l = ( tables.toLinear[p00[i]] + tables.toLinear[p01[i]] +
+								   tables.toLinear[p10[i]] + tables.toLinear[p11[i]] + 2 ) >> 2;
+					out[i] = tables.toSRGB[l >> 4];
+				}
+			}
+		}
+	}
+}
+
+void
+ImageFilter::buildMipChain( ImageData const& base, std::vector< ImageData >& levels, bool gammaCorrect ) {
+	levels.clear();
+	ImageData const* prev = &base;
+	// reserve first, so the pointer to the previous level stays valid
+	unsigned count = 0;
+	for( unsigned w = base.width, h = base.height; w > 1 || h > 1; w = std::max( 1u, w / 2 ), h = std::max( 1u, h / 2 ) )
+		++count;
+	levels.reserve( count );
+	while( prev->width > 1 || prev->height > 1 ) {
+		levels.push_back( ImageData() );
+		if( gammaCorrect )
+			downsample2x2Gamma( *prev, levels.back() );
+		else
+			downsample2x2( *prev, levels.back() );
+		prev = &levels.back();
+	}
+}
+
+/** One output sample of a 1D box filter: the first source sample and the weights of the covered samples.
+ */
+struct BoxSpan {
+	unsigned first;
+	std::vector< float > weights;
+};
+
+/** Computes the spans of a 1D box filter from srcSize samples to dstSize samples.
+ */
+static void
+computeSpans( unsigned srcSize, unsigned dstSize, std::vector< BoxSpan >& spans ) {
+	spans.resize( dstSize );
+	double scale = (double)srcSize / (double)dstSize;
+	for( unsigned i = 0; i < dstSize; ++i ) {
+		double begin = i * scale;
+		double end = std::min( (double)srcSize, ( i + 1 ) * scale );
+		unsigned first = (unsigned)begin;
+		spans[i].first = first;
+		spans[i].weights.clear();
+		for( unsigned s = first; s < srcSize && s < end; ++s ) {
+			// the part of the source sample covered by the output sample
+			double w = std::min( end, s + 1.0 ) - std::max( begin, (double)s );
+			spans[i].weights.push_back( (float)( w / scale ) );
+		}
+	}
+}
+
+/** Filters a row of bytes horizontally with the spans of a box filter.
+ * @param in The source row.
+ * @param columns The spans of the output pixels.
+ * @param c The number of bytes per pixel.
+ * @param out The filtered row, one float per byte.
+ */
+static void
+filterRow( unsigned char const* in, std::vector< BoxSpan > const& columns, unsigned c, float* out ) {
+	unsigned width = (unsigned)columns.size();
+#ifdef IMAGEFILTER_SSE2
+	if( c == 4 ) {
+		// the four channels of a pixel fill a register
+		__m128i const zero = _mm_setzero_si128();
+		for( unsigned x = 0; x < width; ++x ) {
+			BoxSpan const& span = columns[x];
+			unsigned char const* p = in + span.first * 4;
+			__m128 sum = _mm_setzero_ps();
+			for( unsigned k = 0; k < span.weights.size(); ++k, p += 4 ) {
+				int pixel;
+				std::memcpy( &pixel, p, 4 );
+				__m128i v = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( pixel ), zero ), zero );
+				sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( span.weights[k] ), _mm_cvtepi32_ps( v ) ) );
+			}
+			_mm_storeu_ps( out + x * 4, sum );
+		}
+		return;
+	}
+#endif
+	for( unsigned x = 0; x < width; ++x ) {
+		BoxSpan const& span = columns[x];
+		for( unsigned i = 0; i < c; ++i )
+			out[x * c + i] = 0.0f;
+		for( unsigned k = 0; k < span.weights.size(); ++k ) {
+			unsigned char const* p = in + ( span.first + k ) * c;
+			for( unsigned i = 0; i < c; ++i )
+				out[x * c + i] += span.weights[k] * p[i];
+		}
+	}
+}
+
+/** Adds a weighted row of floats to a row of sums.
+ * @param in The row to add.
+ * @param weight The weight of the row.
+ * @param acc The sums of acc[i] + weight * in[i].
+ * @param count The number of floats per row.
+ */
+static void
+accumulateRow( float const* in, float weight, float* acc, unsigned count ) {
+	unsigned i = 0;
+#ifdef IMAGEFILTER_SSE2
+	__m128 const w = _mm_set1_ps( weight );
+	for( ; i + 4 <= count; i += 4 )
+		_mm_storeu_ps( acc + i, _mm_add_ps( _mm_loadu_ps( acc + i ), _mm_mul_ps( w, _mm_loadu_ps( in + i ) ) ) );
+#endif
+	for( ; i < count; ++i )
+		acc[i] += weight * in[i];
+}
+
+/** Rounds a row of floats in [0, 255] to bytes.
+ * @param acc The row to round.
+ * @param out The rounded row.
+ * @param count The number of values per row.
+ */
+static void
+storeRow( float const* acc, unsigned char* out, unsigned count ) {
+	unsigned i = 0;
+#ifdef IMAGEFILTER_SSE2
+	__m128 const half = _mm_set1_ps( 0.5f );
+	for( ; i + 16 <= count; i += 16 ) {
+		// truncate like the cast below, the packs saturate at 255
+		__m128i a = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( acc + i ), half ) );
+		__m128i b = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( acc + i + 4 ), half ) );
+		__m128i c = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( acc + i + 8 ), half ) );
+		__m128i d = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( acc + i + 12 ), half ) );
+		_mm_storeu_si128( (__m128i*)(out + i), _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		out[i] = (unsigned char)std::min( 255.0f, acc[i] + 0.5f );
+}
+
+void
+ImageFilter::resample( ImageData const& src, unsigned width, unsigned height, ImageData& dst ) {
+	unsigned c = src.components;
+	std::vector< BoxSpan > columns, rows;
+	computeSpans( src.width, width, columns );
+	computeSpans( src.height, height, rows );
+
+	// horizontal pass into a float image
+	std::vector< float > tmp( width * src.height * c );
+	for( unsigned y = 0; y < src.height; ++y )
+		filterRow( &src.pixels[y * src.width * c], columns, c, &tmp[y * width * c] );
+
+	// vertical pass
+	dst.width = width;
+	dst.height = height;
+	dst.components = c;
+	dst.format = src.format;
+	dst.pixels.resize( width * height * c );
+	unsigned pitch = width * c;
+	std::vector< float > acc( pitch );
+	for( unsigned y = 0; y < height; ++y ) {
+		BoxSpan const& span = rows[y];
+		std::fill( acc.begin(), acc.end(), 0.0f );
+		for( unsigned k = 0; k < span.weights.size(); ++k )
+			accumulateRow( &tmp[( span.first + k ) * pitch], span.weights[k], &acc[0], pitch );
+		storeRow( &acc[0], &dst.pixels[y * pitch], pitch );
+	}
+}
+
+bool
+ImageFilter::fitToSize( ImageData& image, unsigned maxSize ) {
+	if( maxSize == 0 || ( image.width <= maxSize && image.height <= maxSize ) )
+		return false;
+	double scale = (double)maxSize / (double)std::max( image.width, image.height );
+	unsigned width = floorPowerOfTwo( (unsigned)( image.width * scale ) );
+	unsigned height = floorPowerOfTwo( (unsigned)( image.height * scale ) );
+
+	// halve with the fast box filter as long as the result is exact
+	while( image.width % 2 == 0 && image.height % 2 == 0 &&
+		   image.width / 2 >= width && image.height / 2 >= height ) {
+		ImageData half;
+		downsample2x2( image, half );
+		image.width = half.width;
+		image.height = half.height;
+		image.pixels.swap( half.pixels );
+	}
+	if( image.width != width || image.height != height ) {
+		ImageData scaled;
+		resample( image, width, height, scaled );
+		image.width = scaled.width;
+		image.height = scaled.height;
+		image.pixels.swap( scaled.pixels );
+	}
+	return true;
+}
+
+void
+ImageFilter::equirectToCube( ImageData const& src, unsigned maxSize, std::vector< ImageData >& faces ) {
+	double const pi = 3.14159265358979323846;
+	unsigned c = src.components;
+	unsigned faceSize = floorPowerOfTwo( src.width / 4 );
+	if( maxSize != 0 )
+		faceSize = std::min( faceSize, maxSize );
+	faces.resize( 6 );
+	for( unsigned face = 0; face < 6; ++face ) {
+		ImageData& dst = faces[face];
+		dst.width = faceSize;
+		dst.height = faceSize;
+		dst.components = c;
+		dst.format = src.format;
+		dst.pixels.resize( faceSize * faceSize * c );
+		for( unsigned y = 0; y < faceSize; ++y ) {
+			double tc = 2.0 * ( y + 0.5 ) / faceSize - 1.0;
+			for( unsigned x = 0; x < faceSize; ++x ) {
+				double sc = 2.0 * ( x + 0.5 ) / faceSize - 1.0;
+				// the direction of the texel (table 3.19 of the OpenGL 2.1 specification, inverted)
+				double dir[3];
+				switch( face ) {
+					case 0:  dir[0] =  1.0; dir[1] = -tc;  dir[2] = -sc;  break;
+					case 1:  dir[0] = -1.0; dir[1] = -tc;  dir[2] =  sc;  break;
+					case 2:  dir[0] =  sc;  dir[1] =  1.0; dir[2] =  tc;  break;
+					case 3:  dir[0] =  sc;  dir[1] = -1.0; dir[2] = -tc;  break;
+					case 4:  dir[0] =  sc;  dir[1] = -tc;  dir[2] =  1.0; break;
+					default: dir[0] = -sc;  dir[1] = -tc;  dir[2] = -1.0; break;
+				}
+				double len = std::sqrt( dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2] );
+				// longitude and latitude of the direction as texel coordinates of the panorama
+				double u = ( 0.5 + std::atan2( dir[0], -dir[2] ) / ( 2.0 * pi ) ) * src.width - 0.5;
+				double v = std::acos( dir[1] / len ) / pi * src.height - 0.5;
+				v = std::max( 0.0, std::min( v, src.height - 1.0 ) );
+				int u0 = (int)std::floor( u );
+				int v0 = (int)v;
+				float fu = (float)( u - u0 );
+				float fv = (float)( v - v0 );
+				// the longitude wraps around, the latitude is clamped at the poles
+				unsigned x0 = (unsigned)( ( u0 % (int)src.width + (int)src.width ) % (int)src.width );
+				unsigned x1 = ( x0 + 1 ) % src.width;
+				unsigned y0 = (unsigned)v0;
+				unsigned y1 = std::min( y0 + 1, src.height - 1 );
+				unsigned char const* p00 = &src.pixels[( y0 * src.width + x0 ) * c];
+				unsigned char const* p01 = &src.pixels[( y0 * src.width + x1 ) * c];
+				unsigned char const* p10 = &src.pixels[( y1 * src.width + x0 ) * c];
+				unsigned char const* p11 = &src.pixels[( y1 * src.width + x1 ) * c];
+				unsigned char* out = &dst.pixels[( y * faceSize + x ) * c];
+				for( unsigned i = 0; i < c; ++i ) {
+					float top = p00[i] + fu * ( p01[i] - p00[i] );
+					float bottom = p10[i] + fu * ( p11[i] - p10[i] );
+					out[i] = (unsigned char)( top + fv * ( bottom - top ) + 0.5f );
+				}
+			}
+		}
+	}
+}
+
+unsigned
+ImageFilter::floorPowerOfTwo( unsigned v ) {
+	unsigned p = 1;
+	while( p <= v / 2 )
+		p *= 2;
+	return p;
+}
@@ -0,0 +1,63 @@
+#ifndef IMAGEFILTER
+#define IMAGEFILTER
+
+#include <TextureDecoder.h>
+
+/** This class provides filters which work on decoded images in client memory.
+ * The filters are independent of the pixel format, every byte of a pixel is filtered as a channel of its own.
+ * The 2x2 box filter uses SSE2 if the compiler targets it (always the case on x86-64) and AVX2 if it is enabled (-mavx2).
+ * The area filter of resample() uses SSE2 as well, for its vertical pass and for the horizontal pass of RGBA images.
+ * @brief Resampling of decoded images.
+ */
+class ImageFilter {
+	public:
+		/** This function halves the size of an image with a 2x2 box filter.
+		 * An odd width or height is rounded down, a dimension of 1 stays 1 (like the levels of a mip chain).
+		 * @param src The image to filter.
+		 * @param dst The image to store the result in.
+		 */
+		static void downsample2x2( ImageData const& src, ImageData& dst );
+		/** This function halves the size of an image with a 2x2 box filter, which averages in linear space.
+		 * The color channels are treated as sRGB, the alpha channel (of RGBA and luminance alpha images) stays linear.
+		 * @param src The image to filter.
+		 * @param dst The image to store the result in.
+		 */
+		static void downsample2x2Gamma( ImageData const& src, ImageData& dst );
+		/** This function builds the complete mip chain of an image down to 1x1.
+		 * @param base The base level of the chain.
+		 * @param levels The levels 1 to n are stored in here.
+		 * @param gammaCorrect If true, the levels are averaged in linear space (see downsample2x2Gamma()).
+		 */
+		static void buildMipChain( ImageData const& base, std::vector< ImageData >& levels, bool gammaCorrect );
+		/** This function scales an image to an arbitrary size with a box (area averaging) filter.
+		 * Enlarging works as well, every output texel then covers a part of one or two source texels.
+		 * @param src The image to filter.
+		 * @param width The new width.
+		 * @param height The new height.
+		 * @param dst The image to store the result in.
+		 */
+		static void resample( ImageData const& src, unsigned width, unsigned height, ImageData& dst );
+		/** This function scales an image down, until it fits into a maximum size.
+		 * The larger dimension is scaled to maxSize and both dimensions are rounded down to a power of two.
+		 * Images which already fit are not touched.
+		 * @param image The image to scale.
+		 * @param maxSize The maximum width and height (usually GL_MAX_TEXTURE_SIZE).
+		 * @return true if the image was scaled.
+		 */
+		static bool fitToSize( ImageData& image, unsigned maxSize );
+		/** This function converts an equirectangular (latitude/longitude) panorama into the six faces of a cube map.
+		 * The texels are sampled bilinearly. Row 0 of the panorama is its top (the north pole), like the decoded images.
+		 * A face covers 90 degrees, so it gets a quarter of the width of the panorama (rounded down to a power of two).
+		 * @param src The panorama, usually twice as wide as high.
+		 * @param maxSize The maximum size of the faces (usually GL_MAX_CUBE_MAP_TEXTURE_SIZE, 0 means no limit).
+		 * @param faces The faces in the order of the OpenGL targets (+X, -X, +Y, -Y, +Z, -Z).
+		 */
+		static void equirectToCube( ImageData const& src, unsigned maxSize, std::vector< ImageData >& faces );
+		/** This function rounds down to a power of two.
+		 * @param v The value to round.
+		 * @return The largest power of two which is not bigger than v (1 for 0).
+		 */
+		static unsigned floorPowerOfTwo( unsigned v );
+};
+
+#endif
@@ -26,11 +26,12 @@ InputManager::InputManager() {
 	mCameraMovement_.transX = mCameraMovement_.transY = mCameraMovement_.transZ = 0.0f;
 	mCameraMovement_.firstMouseMotionCaptured = false;
 	mLMBDown_ = false;
+	mAnimationPaused_ = false;
 }
 
 bool
 InputManager::keyDown( SDL_Event const& e ) {
-	//LogManager::getSingletonPtr()->logMessage("InputManager: Key-Down Event occured");
+	LOG_DEBUG( INPUT, "InputManager: Key-Down Event occured" );
 	if( e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_w )
 		mCameraMovement_.moveForward = true;
 	if( e.key.keysym.sym == SDLK_DOWN || e.key.keysym.sym == SDLK_s )
@@ -40,6 +41,9 @@ InputManager::keyDown( SDL_Event const& e ) {
 	if( e.key.keysym.sym == SDLK_RIGHT || e.key.keysym.sym == SDLK_d )
 		mCameraMovement_.moveRight = true;
 
+	if( e.key.keysym.sym == SDLK_p )
+		mAnimationPaused_ = !mAnimationPaused_;
+
 	if( e.key.keysym.sym == SDLK_ESCAPE )
 		return false;
 	return true;
@@ -47,7 +51,7 @@ InputManager::keyDown( SDL_Event const& e ) {
 
 bool
 InputManager::keyUp( SDL_Event const& e ) {
-	//LogManager::getSingletonPtr()->logMessage("InputManager: Key-Up Event occured");
+	LOG_DEBUG( INPUT, "InputManager: Key-Up Event occured" );
 	if( e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_w )
 		mCameraMovement_.moveForward = false;
 	if( e.key.keysym.sym == SDLK_DOWN || e.key.keysym.sym == SDLK_s )
@@ -61,7 +65,7 @@ InputManager::keyUp( SDL_Event const& e ) {
 
 bool
 InputManager::mouseDown( SDL_Event const& e ) {
-	//LogManager::getSingletonPtr()->logMessage("InputManager: Mouse-Down Event occured");
+	LOG_DEBUG( INPUT, "InputManager: Mouse-Down Event occured" );
 	if( e.button.button == SDL_BUTTON_LEFT )
 		mLMBDown_ = true;
 	return true;
@@ -69,7 +73,7 @@ InputManager::mouseDown( SDL_Event const& e ) {
 
 bool
 InputManager::mouseUp( SDL_Event const& e ) {
-	//LogManager::getSingletonPtr()->logMessage("InputManager: Mouse-Up Event occured");
+	LOG_DEBUG( INPUT, "InputManager: Mouse-Up Event occured" );
 	if( e.button.button == SDL_BUTTON_LEFT )
 		mLMBDown_ = false;
 	return true;
@@ -77,7 +81,7 @@ InputManager::mouseUp( SDL_Event const& e ) {
 
 bool
 InputManager::mouseMoved( SDL_Event const& e ) {
-	//LogManager::getSingletonPtr()->logMessage("InputManager: Mouse-Moved Event occured");
+	LOG_DEBUG( INPUT, "InputManager: Mouse-Moved Event occured" );
 	if( mLMBDown_ ) {
 		float maxXAngle = 70.0f;
 		mCameraMovement_.rotY += e.motion.xrel/1.0f; // yaw
@@ -134,5 +138,26 @@ InputManager::updateCameraMovements( double timeSinceLastFrame ) {
 
 }
 
+void
+InputManager::setCamera( float const rot[3], float const trans[3] ) {
+	mCameraMovement_.rotX = rot[0];
+	mCameraMovement_.rotY = rot[1];
+	mCameraMovement_.rotZ = rot[2];
+	mCameraMovement_.transX = trans[0];
+	mCameraMovement_.transY = trans[1];
+	mCameraMovement_.transZ = trans[2];
+}
+
+bool
+InputManager::isAnimationPaused() const {
+	return mAnimationPaused_;
+}
+
+bool
+InputManager::isCameraMoving() const {
+	return mCameraMovement_.moveForward || mCameraMovement_.moveBackward ||
+		   mCameraMovement_.moveLeft || mCameraMovement_.moveRight;
+}
+
 InputManager::~InputManager() {
 }
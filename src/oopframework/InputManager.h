@@ -82,6 +82,19 @@ class InputManager {
 		 * @param timeSinceLastFrame The elapsed time since the rendering of the last Frame in seconds.
 		 */
 		void updateCameraMovements( double timeSinceLastFrame );
+		/** This function places the Camera directly, e.g. to follow a scripted path.
+		 * @param rot The rotation around the X, Y and Z axis in degrees.
+		 * @param trans The translation of the Camera.
+		 */
+		void setCamera( float const rot[3], float const trans[3] );
+		/** This function tells whether the animation of the scene was paused with the P key.
+		 * @return true if the animation is paused.
+		 */
+		bool isAnimationPaused() const;
+		/** This function tells whether the Camera is moving, because a movement key is held down.
+		 * @return true if the Camera moves.
+		 */
+		bool isCameraMoving() const;
 
 
 	private:
@@ -91,6 +104,7 @@ class InputManager {
 
 		movement mCameraMovement_; //!< the Camera movement
 		bool	 mLMBDown_;			//!< Indicates whether the left mouse button is down or not
+		bool	 mAnimationPaused_;	//!< Indicates whether the animation is paused (toggled with P)
 };
 
 #endif
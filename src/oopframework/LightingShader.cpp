@@ -0,0 +1,128 @@
+#include <LightingShader.h>
+
+#include <cstring>
+
+// the diffuse and specular factor of a light like the fixed function pipeline, with an infinite viewer
+// (GL_LIGHT_MODEL_LOCAL_VIEWER off): the half vector doesn't depend on the vertex
+char const* const LightingShader::LIGHTING_SOURCE =
+	"vec2 lightVertex( vec3 n, vec4 eye, vec4 lightPosition, float shininess ) {\n"
+	"	vec3 l = normalize( lightPosition.xyz - eye.xyz * lightPosition.w );\n"
+	"	float diffuse = max( dot( n, l ), 0.0 );\n"
+	"	float specular = 0.0;\n"
+	"	if( diffuse > 0.0 )\n"
+	"		specular = pow( max( dot( n, normalize( l + vec3( 0.0, 0.0, 1.0 ) ) ), 0.0 ), shininess );\n"
+	"	return vec2( diffuse, specular );\n"
+	"}\n";
+
+// the lighting equation of the fixed function pipeline for light 0, per vertex (follows LIGHTING_SOURCE)
+static char const* VERTEX_SHADER =
+	"uniform vec4 block[10];\n"
+	"varying vec4 color;\n"
+	"void main() {\n"
+	"	vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+	"	vec2 light = lightVertex( normalize( gl_NormalMatrix * gl_Normal ), eye, block[0], block[9].x );\n"
+	"	color = block[8] + block[4] * block[5] + block[1] * block[5] + light.x * block[2] * block[6] + light.y * block[3] * block[7];\n"
+	"	color = clamp( vec4( color.rgb, block[6].a ), 0.0, 1.0 );\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+// GL_MODULATE
+static char const* FRAGMENT_SHADER =
+	"#version 120\n"
+	"uniform sampler2D surface;\n"
+	"uniform bool textured;\n"
+	"varying vec4 color;\n"
+	"void main() {\n"
+	"	gl_FragColor = textured ? color * texture2D( surface, gl_TexCoord[0].st ) : color;\n"
+	"}\n";
+
+LightingShader*
+LightingShader::create() {
+	std::string vertex = std::string( "#version 120\n" ) + LIGHTING_SOURCE + VERTEX_SHADER;
+	ShaderProgram* program = ShaderProgram::create( "LightingShader", vertex.c_str(), FRAGMENT_SHADER );
+	if( program == NULL )
+		return NULL;
+	return new LightingShader( program );
+}
+
+LightingShader::LightingShader( ShaderProgram* program ) :
+	mProgram_(program),
+	mDirty_(true),
+	mTextured_(-1),
+	mUploads_(0) {
+	mBlockUniform_ = mProgram_->getUniform( "block" );
+	mTexturedUniform_ = mProgram_->getUniform( "textured" );
+	mProgram_->bind();
+	glUniform1i( mProgram_->getUniform( "surface" ), 0 );
+	mProgram_->unbind();
+	// the defaults of OpenGL
+	std::memset( mBlock_, 0, sizeof(mBlock_) );
+	float const position[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+	float const white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	float const sceneAmbient[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+	float const ambient[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+	float const diffuse[4] = { 0.8f, 0.8f, 0.8f, 1.0f };
+	float const black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	set( LIGHT_POSITION, position );
+	set( LIGHT_AMBIENT, black );
+	set( LIGHT_DIFFUSE, white );
+	set( LIGHT_SPECULAR, white );
+	set( SCENE_AMBIENT, sceneAmbient );
+	setMaterial( ambient, diffuse, black, black, 0.0f );
+}
+
+void
+LightingShader::set( Slot slot, float const value[4] ) {
+	float* entry = &mBlock_[slot * 4];
+	if( std::memcmp( entry, value, 4 * sizeof(float) ) == 0 )
+		return;
+	std::memcpy( entry, value, 4 * sizeof(float) );
+	mDirty_ = true;
+}
+
+void
+LightingShader::setLight( float const eyePosition[4], float const ambient[4], float const diffuse[4], float const specular[4] ) {
+	set( LIGHT_POSITION, eyePosition );
+	set( LIGHT_AMBIENT, ambient );
+	set( LIGHT_DIFFUSE, diffuse );
+	set( LIGHT_SPECULAR, specular );
+}
+
+void
+LightingShader::setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float const emission[4], float shininess ) {
+	set( MATERIAL_AMBIENT, ambient );
+	set( MATERIAL_DIFFUSE, diffuse );
+	set( MATERIAL_SPECULAR, specular );
+	set( MATERIAL_EMISSION, emission );
+	float const exponent[4] = { shininess, 0.0f, 0.0f, 0.0f };
+	set( MATERIAL_SHININESS, exponent );
+}
+
+void
+LightingShader::bind( bool textured ) {
+	mProgram_->bind();
+	if( mDirty_ ) {
+		glUniform4fv( mBlockUniform_, SLOT_COUNT, mBlock_ );
+		mDirty_ = false;
+		++mUploads_;
+	}
+	if( mTextured_ != ( textured ? 1 : 0 ) ) {
+		mTextured_ = textured ? 1 : 0;
+		glUniform1i( mTexturedUniform_, mTextured_ );
+	}
+}
+
+void
+LightingShader::unbind() {
+	mProgram_->unbind();
+}
+
+unsigned long
+LightingShader::getUploadCount() const {
+	return mUploads_;
+}
+
+LightingShader::~LightingShader() {
+	delete mProgram_;
+}
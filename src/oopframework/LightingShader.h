@@ -0,0 +1,110 @@
+#ifndef LIGHTINGSHADER
+#define LIGHTINGSHADER
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+#include <ShaderProgram.h>
+
+/** This class replaces the fixed function lighting (one light, one material, GL_MODULATE texturing) by a GLSL program.
+ * The light and the material are kept in one block of vec4 uniforms instead of the glLight and glMaterial state:
+ * the block is uploaded with a single glUniform4fv call when the program is bound, and only if it changed since
+ * the last upload. The lighting is evaluated per vertex like the fixed function pipeline with an infinite viewer,
+ * but the normals are normalized by the shader, so GL_NORMALIZE and GL_RESCALE_NORMAL cost nothing on drivers which
+ * emulate them.
+ * The light position has to be given in eye coordinates, like the one glLight transforms with the modelview matrix.
+ * @brief Fixed function lighting as a shader.
+ * @code
+ * LightingShader* shader = LightingShader::create();
+ * shader->setLight( eyePosition, ambient, diffuse, specular );
+ * shader->setMaterial( ambient, diffuse, specular, emission, 100.0f );
+ * shader->bind( true );
+ * texture->bind();
+ * sphere->draw( 5.0f );
+ * shader->unbind();
+ * @endcode
+ */
+class LightingShader {
+	public:
+		/** The GLSL function which lights a vertex, shared by all shaders which light like this one.
+		 * vec2 lightVertex( vec3 n, vec4 eye, vec4 lightPosition, float shininess ) returns the diffuse factor in x and
+		 * the specular factor in y for the normalized eye space normal n, the eye space vertex and the eye space light.
+		 * The vertex shaders insert it after their #version and #extension lines.
+		 */
+		static char const* const LIGHTING_SOURCE;
+		/** The vec4 entries of the uniform block.
+		 */
+		enum Slot {
+			LIGHT_POSITION,		//!< The position of the light in eye coordinates (w = 0 for a directional light)
+			LIGHT_AMBIENT,		//!< The ambient color of the light
+			LIGHT_DIFFUSE,		//!< The diffuse color of the light
+			LIGHT_SPECULAR,		//!< The specular color of the light
+			SCENE_AMBIENT,		//!< The ambient color of the scene (GL_LIGHT_MODEL_AMBIENT)
+			MATERIAL_AMBIENT,	//!< The ambient color of the material
+			MATERIAL_DIFFUSE,	//!< The diffuse color of the material, its alpha is the alpha of the lit color
+			MATERIAL_SPECULAR,	//!< The specular color of the material
+			MATERIAL_EMISSION,	//!< The emission of the material
+			MATERIAL_SHININESS,	//!< The specular exponent in x
+			SLOT_COUNT
+		};
+
+		/** This function builds the program.
+		 * @return The shader or NULL if GLSL is not supported or the program doesn't build.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		static LightingShader* create();
+		/** Deletes the program. The OpenGL context has to be current.
+		 */
+		~LightingShader();
+		/** This function sets an entry of the uniform block.
+		 * @param slot The entry.
+		 * @param value The four components.
+		 */
+		void set( Slot slot, float const value[4] );
+		/** This function sets the light.
+		 * @param eyePosition The position in eye coordinates.
+		 * @param ambient The ambient color.
+		 * @param diffuse The diffuse color.
+		 * @param specular The specular color.
+		 */
+		void setLight( float const eyePosition[4], float const ambient[4], float const diffuse[4], float const specular[4] );
+		/** This function sets the material.
+		 * @param ambient The ambient color.
+		 * @param diffuse The diffuse color.
+		 * @param specular The specular color.
+		 * @param emission The emission.
+		 * @param shininess The specular exponent.
+		 */
+		void setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float const emission[4], float shininess );
+		/** This function binds the program and uploads the uniform block if it changed.
+		 * The block may be changed while the program is bound, bind() has to be called again to upload it.
+		 * @param textured If true, the lit color is modulated with the texture of unit 0.
+		 */
+		void bind( bool textured );
+		/** This function returns to the fixed function pipeline.
+		 */
+		void unbind();
+		/** Get the number of uploads of the uniform block.
+		 * @return The number of glUniform4fv calls since the creation.
+		 */
+		unsigned long getUploadCount() const;
+
+	private:
+		/** Creates the shader around a linked program.
+		 */
+		LightingShader( ShaderProgram* program );
+		// the program can't be shared by copies
+		LightingShader( LightingShader const& );
+		LightingShader& operator=( LightingShader const& );
+
+		ShaderProgram* mProgram_;		//!< The linked program
+		GLint mBlockUniform_;			//!< The location of the uniform block
+		GLint mTexturedUniform_;		//!< The location of the texture switch
+		float mBlock_[SLOT_COUNT * 4];	//!< The uniform block
+		bool mDirty_;					//!< If true, mBlock_ changed since the last upload
+		int mTextured_;					//!< The uploaded texture switch, -1 before the first bind()
+		unsigned long mUploads_;		//!< The number of uploads of the block
+};
+
+#endif
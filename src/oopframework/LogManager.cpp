@@ -1,5 +1,15 @@
 #include "LogManager.h"
 
+#include <SDL/SDL_timer.h>
+
+// the number of messages the queue can hold before messages are dropped
+static unsigned const QUEUE_SIZE = 4096;
+// the time the writer thread sleeps if the queue is empty (in ms)
+static Uint32 const WRITER_INTERVAL = 10;
+// the names of the levels and categories written in front of the messages
+static char const* const LEVEL_NAMES[] = { "Debug", "Info", "Warning", "Error" };
+static char const* const CATEGORY_NAMES[] = { "General", "SDL", "Texture", "Resource", "Input", "Render" };
+
 // SINGLETON
 LogManager* LogManager::mInstance_ = NULL;
 
@@ -26,15 +36,25 @@ LogManager::getSingleton( ) {
 }
 
 LogManager::LogManager( std::string logFileName ) :
-  mCounter_(0) {
+  mCounter_(0),
+  mQueue_(QUEUE_SIZE),
+  mWriter_(NULL) {
     mFile_.open(logFileName.c_str(), std::ios::out);
+    // the debug messages have to be enabled explicitly, even if they are compiled in
+    setLevel( LOG_MIN_LEVEL > LEVEL_INFO ? (Level)LOG_MIN_LEVEL : LEVEL_INFO );
+    // if the thread can't be created, the messages are written by the caller
+    mWriter_ = SDL_CreateThread( &LogManager::writerMain, this );
 }
 
 void
 LogManager::logMessage( std::string const& m ) {
-  ++mCounter_;
-  mFile_ << " [" << mCounter_ << "] : " << m << std::endl;
-  std::cout << " [" << mCounter_ << "] : " << m << std::endl;
+  std::string record( m );
+  if( !mQueue_.push( record ) ) {
+    mDropped_.fetchAdd( 1 );
+    return;
+  }
+  if( mWriter_ == NULL )
+    flush();
 }
 
 void
@@ -42,7 +62,80 @@ LogManager::logMessage( std::stringstream const& m ) {
   logMessage( m.str() );
 }
 
+void
+LogManager::logMessage( Level level, Category category, std::string const& m ) {
+  if( !isEnabled( level, category ) || level >= LEVEL_NONE )
+    return;
+  logMessage( std::string( "[" ) + CATEGORY_NAMES[category] + " " + LEVEL_NAMES[level] + "] " + m );
+}
+
+void
+LogManager::setLevel( Level level ) {
+  for( unsigned i = 0; i < CAT_COUNT; ++i )
+    mLevels_[i] = level;
+}
+
+void
+LogManager::setLevel( Category category, Level level ) {
+  mLevels_[category] = level;
+}
+
+void
+LogManager::flush() {
+  // wait until the writer thread finished its batch, then write the rest
+  while( !mDraining_.compareAndSwap( 0, 1 ) )
+    SDL_Delay( 0 );
+  drain();
+  mDraining_.set( 0 );
+}
+
+bool
+LogManager::tryDrain() {
+  if( !mDraining_.compareAndSwap( 0, 1 ) )
+    return false;
+  bool written = drain();
+  mDraining_.set( 0 );
+  return written;
+}
+
+bool
+LogManager::drain() {
+  std::stringstream batch;
+  long dropped = mDropped_.get();
+  if( dropped != 0 ) {
+    mDropped_.fetchAdd( -dropped );
+    batch << " [" << ++mCounter_ << "] : LogManager Warning: " << dropped << " messages were dropped, because the queue was full.\n";
+  }
+  std::string record;
+  while( mQueue_.pop( record ) )
+    batch << " [" << ++mCounter_ << "] : " << record << '\n';
+  std::string const& text = batch.str();
+  if( text.empty() )
+    return false;
+  // one write and one flush per batch instead of two per message
+  mFile_ << text;
+  mFile_.flush();
+  std::cout << text;
+  std::cout.flush();
+  return true;
+}
+
+int SDLCALL
+LogManager::writerMain( void* data ) {
+  LogManager* lm = static_cast< LogManager* >( data );
+  while( lm->mQuit_.get() == 0 ) {
+    if( !lm->tryDrain() )
+      SDL_Delay( WRITER_INTERVAL );
+  }
+  return 0;
+}
+
 LogManager::~LogManager() {
+    mQuit_.set( 1 );
+    if( mWriter_ != NULL )
+      SDL_WaitThread( mWriter_, NULL );
+    mWriter_ = NULL;
+    flush();
     mFile_.close();
 }
 
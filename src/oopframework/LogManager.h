@@ -6,7 +6,24 @@
 #include <string>
 #include <sstream>
 
+#include <SDL/SDL_thread.h>
+
+#include <RingBuffer.h>
+
+/* The minimum level of the messages which are compiled in (0 = debug, 1 = info, 2 = warning, 3 = error, 4 = none).
+ * The LOG_* macros of the levels below are discarded at compile time, so those messages cost nothing - not even the formatting.
+ * The Release build of the Makefile sets it to 2 (warnings only).
+ */
+#ifndef LOG_MIN_LEVEL
+	#define LOG_MIN_LEVEL 0
+#endif
+
 /** This class provides a simple mechanism to log messages by writing them on the terminal and into a file.
+* The messages are appended to a lock-free queue and written by a background thread in batches, so logging never blocks the caller.
+* If the queue is full, messages are dropped and the number of dropped messages is logged instead.
+* The queue is flushed when the LogManager is destroyed. A crash loses the messages queued since the last batch (the
+* writer thread drains the queue every 10 ms). They are not flushed by a signal handler: formatting and writing a batch
+* allocates memory, which isn't async-signal-safe and deadlocks if the crash happened inside malloc.
 * @brief Simply log messages on the terminal and into a Logfile.
 * @code
 * LogManager* l = LogManager::getSingletonPtr();
@@ -17,11 +34,33 @@
 * log << "This is the first message";
 * log << " and this is the second";
 * l->logMessage( log );
+* // log with a level and a category - the message is only formatted if it is enabled
+* LOG_WARNING( TEXTURE, "The texture " << name << " is too big" );
 * @endcode
 * @author Andy Reimann andy.reimann@uni-weimar.de
 */
 class LogManager {
 	public:
+		/** The severity of a message.
+		*/
+		enum Level {
+			LEVEL_DEBUG = 0,	//!< Details which are only of interest while debugging
+			LEVEL_INFO = 1,		//!< Routine information about the progress
+			LEVEL_WARNING = 2,	//!< Something went wrong, but the program can handle it
+			LEVEL_ERROR = 3,	//!< Something failed
+			LEVEL_NONE = 4		//!< Used as threshold to disable all messages
+		};
+		/** The subsystem a message belongs to.
+		*/
+		enum Category {
+			CAT_GENERAL = 0,	//!< Messages logged without a category
+			CAT_SDL,			//!< The window and the SDL setup
+			CAT_TEXTURE,		//!< The TextureManager and its decoder
+			CAT_RESOURCE,		//!< The RessourceManager and the archives
+			CAT_INPUT,			//!< The InputManager
+			CAT_RENDER,			//!< The RenderEngine and the meshes
+			CAT_COUNT			//!< The number of categories
+		};
 		/** Get a pointer to one single instance.
 		* @param logFileName the name of the logfile to use.
 		* @note this function only works correctly when it is called before an instance of the LogManager exists.
@@ -47,6 +86,31 @@ class LogManager {
 		* @param m the message to write.
 		*/
 		void logMessage( std::stringstream const& m );
+		/** this function writes a message with a level and a category into the logfile.
+		* Use the LOG_* macros instead, they don't even format the message if it is disabled.
+		* @param level the severity of the message.
+		* @param category the subsystem the message belongs to.
+		* @param m the message to write.
+		*/
+		void logMessage( Level level, Category category, std::string const& m );
+		/** this function sets the threshold of all categories.
+		* @param level messages below this level are discarded.
+		*/
+		void setLevel( Level level );
+		/** this function sets the threshold of one category.
+		* @param category the category to set the threshold of.
+		* @param level messages of the category below this level are discarded.
+		*/
+		void setLevel( Category category, Level level );
+		/** this function tests whether messages of a level and a category are written.
+		* @param level the severity of the message.
+		* @param category the subsystem the message belongs to.
+		* @return true if the message would be written.
+		*/
+		bool isEnabled( Level level, Category category ) const { return level >= mLevels_[category]; }
+		/** this function writes all queued messages into the logfile and on the terminal before it returns.
+		*/
+		void flush();
 	private:
 		static LogManager* mInstance_;; //!< the one single instance
 		/** Constructs a LogManager object
@@ -54,8 +118,26 @@ class LogManager {
 		*/
 		LogManager( std::string logFileName );
 		~LogManager(); //! destructor
+		/** this internal function writes the queued messages as one batch.
+		* @return false if there was nothing to write.
+		*/
+		bool drain();
+		/** this internal function drains the queue if no other thread does it right now.
+		* @return false if there was nothing to write or another thread is draining.
+		*/
+		bool tryDrain();
+		/** the entry point of the writer thread.
+		* @param data a pointer to the LogManager.
+		*/
+		static int SDLCALL writerMain( void* data );
 		std::fstream mFile_; //!< the filestream we're going to write in
 		long int	mCounter_;  //!< counter for the log entries
+		RingBuffer< std::string > mQueue_; //!< the messages which were not written yet
+		Atomic		mDropped_; //!< the number of messages dropped since the last batch, because the queue was full
+		Atomic		mDraining_; //!< 1 while a thread writes a batch - only one thread may drain the queue at a time
+		Atomic		mQuit_; //!< if 1 the writer thread stops
+		SDL_Thread* mWriter_; //!< the writer thread or NULL if the messages are written by the caller
+		Level		mLevels_[CAT_COUNT]; //!< the threshold of every category
 };
 
 /** This function shifts the content of a string into the LogManager.
@@ -69,6 +151,55 @@ LogManager& operator<<(LogManager& lm, std::string s);
 */
 LogManager& operator<<(LogManager& lm, std::stringstream& s);
 
+/** This macro logs a message, if its level and category are enabled.
+* @param level the LogManager::Level of the message.
+* @param category the LogManager::Category of the message.
+* @param message the parts of the message, joined by << (e.g. "Loaded " << name).
+*/
+#define LOG_MESSAGE( level, category, message ) \
+	do { \
+		if( LogManager::getSingletonPtr()->isEnabled( (level), (category) ) ) { \
+			std::stringstream logStream_; \
+			logStream_ << message; \
+			LogManager::getSingletonPtr()->logMessage( (level), (category), logStream_.str() ); \
+		} \
+	} while( false )
+
+/** This macro swallows a message which is below LOG_MIN_LEVEL.
+* The message is still compiled (so it can't rot and its variables count as used), but the branch is removed by the optimizer.
+*/
+#define LOG_DISCARD( message ) \
+	do { \
+		if( false ) { \
+			std::stringstream logStream_; \
+			logStream_ << message; \
+		} \
+	} while( false )
+
+/* The macros of the levels take the category without the CAT_ prefix (e.g. TEXTURE).
+ * It is pasted right away, so include guards with the same name don't get in the way.
+ */
+#if LOG_MIN_LEVEL <= 0
+	#define LOG_DEBUG( category, message ) LOG_MESSAGE( LogManager::LEVEL_DEBUG, LogManager::CAT_##category, message )
+#else
+	#define LOG_DEBUG( category, message ) LOG_DISCARD( message )
+#endif
+#if LOG_MIN_LEVEL <= 1
+	#define LOG_INFO( category, message ) LOG_MESSAGE( LogManager::LEVEL_INFO, LogManager::CAT_##category, message )
+#else
+	#define LOG_INFO( category, message ) LOG_DISCARD( message )
+#endif
+#if LOG_MIN_LEVEL <= 2
+	#define LOG_WARNING( category, message ) LOG_MESSAGE( LogManager::LEVEL_WARNING, LogManager::CAT_##category, message )
+#else
+	#define LOG_WARNING( category, message ) LOG_DISCARD( message )
+#endif
+#if LOG_MIN_LEVEL <= 3
+	#define LOG_ERROR( category, message ) LOG_MESSAGE( LogManager::LEVEL_ERROR, LogManager::CAT_##category, message )
+#else
+	#define LOG_ERROR( category, message ) LOG_DISCARD( message )
+#endif
+
 
 
 #endif
@@ -0,0 +1,225 @@
+#include <Profiler.h>
+#include <Atomic.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_thread.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+	#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+	#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+/** One recorded zone.
+ */
+struct ZoneRecord {
+	char const* name;			//!< The name of the zone
+	unsigned long long begin;	//!< The beginning in nanoseconds
+	unsigned long long end;		//!< The end in nanoseconds
+	long frame;					//!< The frame the zone belongs to
+};
+
+/** The zones of one thread. Only the thread itself writes into its ring.
+ */
+struct ThreadBuffer {
+	unsigned id;					//!< The number of the thread in the trace
+	char const* name;				//!< The name of the thread in the trace
+	std::vector< ZoneRecord > ring;	//!< The last zones, allocated on the first record
+	Atomic written;					//!< The number of zones written since the start of the recording
+};
+
+static Atomic sRecording( 0 );		// 1 while recording
+static Atomic sFrame( 0 );			// the current frame
+static unsigned long long sStartTime = 0;	// the timestamp of start()
+static SDL_mutex* sMutex = NULL;				// guards sBuffers, created by init()
+static std::vector< ThreadBuffer* > sBuffers;	// the buffers of all threads
+static PROFILER_THREAD_LOCAL ThreadBuffer* tBuffer = NULL;	// the buffer of the calling thread
+
+/** This helper returns the buffer of the calling thread and registers it on the first call.
+ */
+static ThreadBuffer* getThreadBuffer() {
+	if( tBuffer == NULL ) {
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->name = NULL;
+		SDL_LockMutex( sMutex );
+		sBuffers.push_back( buffer );
+		buffer->id = (unsigned)sBuffers.size();
+		SDL_UnlockMutex( sMutex );
+		tBuffer = buffer;
+	}
+	return tBuffer;
+}
+
+/** This helper writes a string as a JSON string.
+ */
+static void writeJSONString( std::ostream& out, char const* s ) {
+	out << '"';
+	for( ; *s != '\0'; ++s ) {
+		if( *s == '"' || *s == '\\' )
+			out << '\\';
+		out << *s;
+	}
+	out << '"';
+}
+
+void
+Profiler::init() {
+	if( sMutex == NULL )
+		sMutex = SDL_CreateMutex();
+}
+
+void
+Profiler::start() {
+	SDL_LockMutex( sMutex );
+	for( unsigned i = 0; i < sBuffers.size(); ++i )
+		sBuffers[i]->written.set( 0 );
+	SDL_UnlockMutex( sMutex );
+	sFrame.set( 0 );
+	sStartTime = Clock::getNanoseconds();
+	sRecording.set( 1 );
+}
+
+void
+Profiler::stop() {
+	sRecording.set( 0 );
+}
+
+bool
+Profiler::isRecording() {
+	return sRecording.get() != 0;
+}
+
+void
+Profiler::frameMark() {
+	sFrame.fetchAdd( 1 );
+}
+
+void
+Profiler::setThreadName( char const* name ) {
+	getThreadBuffer()->name = name;
+}
+
+void
+Profiler::record( char const* name, unsigned long long begin, unsigned long long end ) {
+	// a zone which ends after stop() is dropped, the buffers may be read already
+	if( !isRecording() )
+		return;
+	ThreadBuffer* buffer = getThreadBuffer();
+	if( buffer->ring.empty() )
+		buffer->ring.resize( RING_SIZE );
+	long written = buffer->written.get();
+	ZoneRecord& r = buffer->ring[(unsigned long)written % RING_SIZE];
+	r.name = name;
+	r.begin = begin;
+	r.end = end;
+	r.frame = sFrame.get();
+	// publishes the record to the thread exporting the trace
+	buffer->written.fetchAdd( 1 );
+}
+
+bool
+Profiler::exportChromeTrace( std::string const& path, std::string& error ) {
+	std::ofstream file( path.c_str() );
+	if( !file ) {
+		error = "Could not open '" + path + "' for writing.";
+		return false;
+	}
+	file.setf( std::ios::fixed );
+	file.precision( 3 );
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	SDL_LockMutex( sMutex );
+	for( unsigned b = 0; b < sBuffers.size(); ++b ) {
+		ThreadBuffer const* buffer = sBuffers[b];
+		if( buffer->name != NULL ) {
+			file << ( first ? "" : ",\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+			writeJSONString( file, buffer->name );
+			file << "}}";
+			first = false;
+		}
+		unsigned long written = (unsigned long)buffer->written.get();
+		unsigned long begin = ( written > RING_SIZE ) ? written - RING_SIZE : 0;
+		for( unsigned long i = begin; i < written; ++i ) {
+			ZoneRecord const& r = buffer->ring[i % RING_SIZE];
+			// the timestamps of the trace are microseconds since the start of the recording
+			file << ( first ? "" : ",\n" ) << "{\"name\":";
+			writeJSONString( file, r.name );
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+				 << ",\"ts\":" << ( r.begin - sStartTime ) / 1000.0
+				 << ",\"dur\":" << ( r.end - r.begin ) / 1000.0
+				 << ",\"args\":{\"frame\":" << r.frame << "}}";
+			first = false;
+		}
+	}
+	SDL_UnlockMutex( sMutex );
+	file << "\n]}\n";
+	if( !file ) {
+		error = "Could not write '" + path + "'.";
+		return false;
+	}
+	return true;
+}
+
+/** The summary of one zone.
+ */
+struct ZoneSummary {
+	std::string name;			//!< The name of the zone
+	unsigned long count;		//!< The number of calls
+	unsigned long long total;	//!< The summed time in nanoseconds
+	unsigned long long longest;	//!< The longest call in nanoseconds
+
+	ZoneSummary() : count(0), total(0), longest(0) {}
+	bool operator<( ZoneSummary const& rhs ) const { return total > rhs.total; }
+};
+
+void
+Profiler::logSummary() {
+	std::map< std::string, ZoneSummary > zones;
+	SDL_LockMutex( sMutex );
+	for( unsigned b = 0; b < sBuffers.size(); ++b ) {
+		ThreadBuffer const* buffer = sBuffers[b];
+		unsigned long written = (unsigned long)buffer->written.get();
+		unsigned long begin = ( written > RING_SIZE ) ? written - RING_SIZE : 0;
+		for( unsigned long i = begin; i < written; ++i ) {
+			ZoneRecord const& r = buffer->ring[i % RING_SIZE];
+			ZoneSummary& z = zones[r.name];
+			z.name = r.name;
+			++z.count;
+			z.total += r.end - r.begin;
+			z.longest = std::max( z.longest, r.end - r.begin );
+		}
+	}
+	SDL_UnlockMutex( sMutex );
+
+	std::vector< ZoneSummary > sorted;
+	for( std::map< std::string, ZoneSummary >::const_iterator it = zones.begin(); it != zones.end(); ++it )
+		sorted.push_back( it->second );
+	std::sort( sorted.begin(), sorted.end() );
+	long frames = std::max( sFrame.get(), 1L );
+	LOG_INFO( RENDER, "Profiler: " << sorted.size() << " zones in " << frames << " frames (per frame mean / longest call):" );
+	for( unsigned i = 0; i < sorted.size(); ++i ) {
+		ZoneSummary const& z = sorted[i];
+		LOG_INFO( RENDER, "Profiler:   " << z.name << ": " << z.total / 1000000.0 / frames << " ms / "
+						  << z.longest / 1000000.0 << " ms (" << z.count << " calls)" );
+	}
+}
+
+void
+Profiler::shutdown() {
+	sRecording.set( 0 );
+	SDL_LockMutex( sMutex );
+	for( unsigned i = 0; i < sBuffers.size(); ++i )
+		delete sBuffers[i];
+	sBuffers.clear();
+	SDL_UnlockMutex( sMutex );
+	tBuffer = NULL;
+	if( sMutex != NULL ) {
+		SDL_DestroyMutex( sMutex );
+		sMutex = NULL;
+	}
+}
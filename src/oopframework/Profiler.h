@@ -0,0 +1,111 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include <LogManager.h>
+#include <Clock.h>
+
+#include <string>
+
+/** This class records the time spent in named zones of the code.
+ * A zone is a scope marked with PROFILE_ZONE( "name" ). While the profiler records, the beginning and the end of
+ * every zone are stored in a ring buffer of the thread which executes it, so the threads never wait for each other.
+ * Every record is tagged with the current frame (see frameMark()). When the recording stops, the zones can be
+ * exported as a Chrome trace (open it in chrome://tracing or https://ui.perfetto.dev) and summarized in the log.
+ * Outside of a recording a zone costs a single check of a flag.
+ * Compiling with PROFILER_DISABLE removes all zones.
+ * @brief A scoped CPU profiler.
+ * @code
+ * void SphereMesh::build() {
+ *     PROFILE_ZONE( "SphereMesh::build" );	// the name has to be a string literal, only the pointer is stored
+ *     ...
+ * }
+ * Profiler::init();	// once, before the threads start
+ * Profiler::start();
+ * // ... render some frames, calling Profiler::frameMark() after each
+ * Profiler::stop();
+ * Profiler::exportChromeTrace( "trace.json", error );
+ * @endcode
+ * @note Each thread keeps the last RING_SIZE zones of a recording, older ones are overwritten.
+ */
+class Profiler {
+	public:
+		static unsigned const RING_SIZE = 65536;	//!< The number of zones kept per thread
+
+		/** This function creates the lock of the thread list. It has to be called before any thread names itself or
+		 * records, shutdown() destroys the lock again.
+		 */
+		static void init();
+		/** This function starts a new recording. The zones of the last recording are dropped.
+		 */
+		static void start();
+		/** This function stops the recording.
+		 */
+		static void stop();
+		/** This function tells whether the profiler records.
+		 * @return true between start() and stop().
+		 */
+		static bool isRecording();
+		/** This function marks the end of a frame. The following zones belong to the next frame.
+		 */
+		static void frameMark();
+		/** This function names the calling thread in the exported trace.
+		 * @param name The name of the thread. It has to be a string literal.
+		 */
+		static void setThreadName( char const* name );
+		/** This function stores a zone of the calling thread. It is used by ProfileZone.
+		 * @param name The name of the zone.
+		 * @param begin The timestamp of the beginning in nanoseconds (see Clock::getNanoseconds()).
+		 * @param end The timestamp of the end in nanoseconds.
+		 */
+		static void record( char const* name, unsigned long long begin, unsigned long long end );
+		/** This function writes the zones of the last recording as a Chrome trace (JSON trace event format).
+		 * @param path The path of the file.
+		 * @param error The reason of a failure.
+		 * @return true if the file was written.
+		 */
+		static bool exportChromeTrace( std::string const& path, std::string& error );
+		/** This function logs the mean and the maximum time per frame of every zone of the last recording.
+		 */
+		static void logSummary();
+		/** This function frees the buffers of all threads and the lock of init().
+		 * It may only be called when no other thread records anymore.
+		 */
+		static void shutdown();
+};
+
+/** This class measures the lifetime of a scope, use it through PROFILE_ZONE.
+ * @brief A zone of the Profiler.
+ */
+class ProfileZone {
+	public:
+		/** Starts the zone.
+		 * @param name The name of the zone, a string literal.
+		 */
+		ProfileZone( char const* name ) :
+			mName_(name),
+			mBegin_( Profiler::isRecording() ? Clock::getNanoseconds() : 0 ) {
+		}
+		/** Ends the zone and records it.
+		 */
+		~ProfileZone() {
+			if( mBegin_ != 0 )
+				Profiler::record( mName_, mBegin_, Clock::getNanoseconds() );
+		}
+	private:
+		char const* mName_;				//!< The name of the zone
+		unsigned long long mBegin_;		//!< The beginning of the zone, 0 if the profiler didn't record
+};
+
+#define PROFILE_CONCAT_( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_( a, b )
+
+#ifndef PROFILER_DISABLE
+	/** Measures the time until the end of the current scope.
+	 * @param name The name of the zone, a string literal.
+	 */
+	#define PROFILE_ZONE( name ) ProfileZone PROFILE_CONCAT( profileZone, __LINE__ )( name )
+#else
+	#define PROFILE_ZONE( name ) (void)0
+#endif
+
+#endif
@@ -1,21 +1,37 @@
 #include "RenderEngine.h"
-#include <time.h>
-
-#ifndef WIN32
-#include <sys/time.h>
-static double unixLastTime = -1.0;
-#else 
-#include <windows.h>
-#include <mmsystem.h>
-static double win32LastTime = -1.0;
-#endif
+#include <fstream>
+#include <iostream>
+
+// the emission of the clouds and their opacity in w, for the single pass and for the blended cloud sphere
+static float const CLOUD_EMISSION[4] = { 0.7f, 0.7f, 0.7f, 0.3f };
 
 
-RenderEngine::RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, unsigned sdlFlags, std::string const& title ) :
+RenderEngine::RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, unsigned sdlFlags, std::string const& title, bool headless, bool compressTextures ) :
 	mValid_(false),
+	mHeadless_(headless),
+	mCompressTextures_(compressTextures),
+	mHeadlessContext_(NULL),
+	mFrameLimit_(0),
+	mDumpFrame_(0),
+	mBenchmark_(NULL),
+	mIdleMode_(false),
 	mEarthTexture_(NULL),
 	mEarthCloudTexture_(NULL),
-	mStarMap_(NULL) {
+	mStarMap_(NULL),
+	mSkybox_(NULL),
+	mGPUTimer_(NULL),
+	mLightingShader_(NULL),
+	mCompositor_(NULL),
+	mScene_(NULL),
+	mSceneTime_(0.0),
+	mEarthLOD_(NULL),
+	mGridLOD_(NULL),
+	mCloudLOD_(NULL),
+	mEarthLevel_(0),
+	mGridLevel_(0),
+	mCloudLevel_(0),
+	mPixelScale_(1.0f),
+	mTriangleCount_(0) {
 	// Initialize the LogManager with a logfilename (only on startup)
   LogManager::getSingletonPtr("runtime.log");
 	
@@ -31,12 +47,19 @@ RenderEngine::RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, un
 		mWindow_.aaSampels = 1; 
 	mWindow_.flags = sdlFlags;
 	mWindow_.title = title;
-	std::stringstream log;
 	
-	if( initWindow() ) // everything is ok
+	if( mHeadless_ ? initHeadless() : initWindow() ) // everything is ok
 		mValid_ = true;
 
 	initManagers();
+	// the framebuffer object needs the extensions loaded by GLEW
+	if( mValid_ && mHeadless_ ) {
+		std::string error;
+		if( !mHeadlessContext_->createFramebuffer( error ) ) {
+			LOG_ERROR( RENDER, "RenderEngine: " << error );
+			mValid_ = false;
+		}
+	}
 	initProperties();
 	initProjection();
 	initScene();
@@ -44,24 +67,15 @@ RenderEngine::RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, un
 
 bool
 RenderEngine::initWindow() {
-	LogManager* l = LogManager::getSingletonPtr();
-	std::stringstream log;
-	log << "SDL: Init Window with SDL...";
-	l->logMessage( log );
-	log.str("");
-	log << "SDL: WindowX=" << mWindow_.x << " WindowY=" << mWindow_.y << " AASamples=" << mWindow_.aaSampels << " Title=" << mWindow_.title;
-	l->logMessage( log );
-	log.str("");
+	LOG_INFO( SDL, "SDL: Init Window with SDL..." );
+	LOG_INFO( SDL, "SDL: WindowX=" << mWindow_.x << " WindowY=" << mWindow_.y << " AASamples=" << mWindow_.aaSampels << " Title=" << mWindow_.title );
 	// Initialize SDL for video output 
 	if ( SDL_Init(SDL_INIT_VIDEO) < 0 ) {
-		log << "SDL: Unable to initialize SDL with the following error: " << SDL_GetError();
-		l->logMessage(log);
+		LOG_ERROR( SDL, "SDL: Unable to initialize SDL with the following error: " << SDL_GetError() );
 		return false;
 	}
 	else {
-		log << "SDL: done. Init SDL-VideoMode...";
-		l->logMessage( log );
-		log.str("");
+		LOG_INFO( SDL, "SDL: done. Init SDL-VideoMode..." );
 
 		// Fetch the video info
 		SDL_VideoInfo const* videoInfo = SDL_GetVideoInfo( );
@@ -71,8 +85,7 @@ RenderEngine::initWindow() {
 			mWindow_.flags |= SDL_HWACCEL;
 
 		if ( !videoInfo ) {
-			log << "SDL: Video query failed with the following error: " << SDL_GetError();
-			l->logMessage( log );
+			LOG_ERROR( SDL, "SDL: Video query failed with the following error: " << SDL_GetError() );
 			return false;
 		}
 
@@ -93,15 +106,13 @@ RenderEngine::initWindow() {
 #else
 		if( SDL_SetVideoMode(mWindow_.x, mWindow_.y, 32, mWindow_.flags) == NULL ) {
 #endif
-		  log << "SDL: Unable to create OpenGL screen with the following reason: " << SDL_GetError();
-		  l->logMessage(log);
+		  LOG_ERROR( SDL, "SDL: Unable to create OpenGL screen with the following reason: " << SDL_GetError() );
 		  SDL_Quit();
 		  return false;
 		}
 		else {
 		  // create the RenderWindow containing all informations about the creation 
-		  log << "done";
-		  l->logMessage(log);
+		  LOG_INFO( SDL, "done" );
 		  // Set the title bar in environments that support it
 		  SDL_WM_SetCaption(mWindow_.title.c_str(), NULL);
 #ifdef WIN32
@@ -114,14 +125,41 @@ RenderEngine::initWindow() {
 	}
 }
 
+bool
+RenderEngine::initHeadless() {
+	LOG_INFO( RENDER, "RenderEngine: Init headless context with X=" << mWindow_.x << " Y=" << mWindow_.y << "..." );
+	// SDL is only needed for the timer and the threads
+	if( SDL_Init( SDL_INIT_TIMER ) < 0 ) {
+		LOG_ERROR( SDL, "SDL: Unable to initialize SDL with the following error: " << SDL_GetError() );
+		return false;
+	}
+	mHeadlessContext_ = new HeadlessContext();
+	std::string error;
+	if( !mHeadlessContext_->create( mWindow_.x, mWindow_.y, error ) ) {
+		LOG_ERROR( RENDER, "RenderEngine: " << error );
+		return false;
+	}
+	return true;
+}
+
 void
 RenderEngine::initManagers() {
 	// add here any of your additional Ressourcelocations like shader directories and so on
+	// the packed media (built with `make pack`) is preferred over the loose files, if it exists
+	RessourceManager::getSingletonPtr()->addArchiveLocation("../media/media.pak");
 	RessourceManager::getSingletonPtr()->addRessourceLocation("../media/");
 	RessourceManager::getSingletonPtr()->addRessourceLocation("../media/images/");
 	
 	InputManager::getSingleton();
+	// load the OpenGL extensions (needed for the Vertex Buffer Objects of the SphereMesh)
+	GLenum glewError = glewInit();
+	if( glewError != GLEW_OK )
+		LOG_WARNING( RENDER, "RenderEngine: Could not initialize GLEW: " << glewGetErrorString( glewError ) );
+	else
+		LOG_INFO( RENDER, "RenderEngine: Using GLEW " << glewGetString( GLEW_VERSION ) << " with OpenGL " << glGetString( GL_VERSION ) );
 	ilInit();
+	// the decoder threads of the TextureManager register with the profiler
+	Profiler::init();
 	TextureManager::getSingleton();
 }
 
@@ -131,22 +169,25 @@ RenderEngine::initProperties() {
 	glClearDepth(1.0f);
 	glClearColor( 1.0f, 1.0f, 1.0f, 1.0f );
 
-	glEnable( GL_DEPTH_TEST );
+	// the capabilities are enabled through the state cache, so it knows them without asking OpenGL
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+
+	sc->enable( GL_DEPTH_TEST );
 	glDepthFunc(GL_LESS);
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CW);
-	glEnable(GL_POLYGON_OFFSET_FILL);
-	glEnable(GL_RESCALE_NORMAL);
-	glEnable( GL_NORMALIZE );
+	sc->enable( GL_POLYGON_OFFSET_FILL );
+	sc->enable( GL_RESCALE_NORMAL );
+	sc->enable( GL_NORMALIZE );
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable( GL_BLEND );
-	glEnable( GL_POINT_SMOOTH );
+	sc->enable( GL_BLEND );
+	sc->enable( GL_POINT_SMOOTH );
 	glHint(GL_POINT_SMOOTH_HINT, GL_NICEST );
 	glShadeModel( GL_SMOOTH );
 	glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
 	glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST );      
 	glHint(GL_FOG_HINT, GL_NICEST);
-	glEnable( GL_POLYGON_SMOOTH );
+	sc->enable( GL_POLYGON_SMOOTH );
 	initLight();
 }
 
@@ -157,7 +198,12 @@ RenderEngine::initProjection() {
 	glViewport(0,0,mWindow_.x, mWindow_.y);
 	float ratio = (float)mWindow_.x/(float)mWindow_.y;
 	gluPerspective(60.0f,ratio,1.0f,4000.0f);
-	SDL_SetVideoMode(mWindow_.x, mWindow_.y, 32, mWindow_.flags);
+	// the level of detail of the spheres depends on their size in pixels
+	GLfloat projection[16];
+	glGetFloatv( GL_PROJECTION_MATRIX, projection );
+	mPixelScale_ = SphereLOD::getPixelScale( projection, mWindow_.y );
+	if( !mHeadless_ )
+		SDL_SetVideoMode(mWindow_.x, mWindow_.y, 32, mWindow_.flags);
 }
 
 void
@@ -167,17 +213,30 @@ RenderEngine::initScene() {
 	// you only have to be sure that the Directory is available in the RessourceManager
 	// The RessourceManager will give a Warning if the Texture will not be found.
 
-	mEarthTexture_ = TextureManager::getSingletonPtr()->loadTexture("earthmap4k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
-	if( mEarthTexture_ == NULL ) // load a lower version if size of texture isn't supported
-		mEarthTexture_ = TextureManager::getSingletonPtr()->loadTexture("earthmap1k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
-
-	mEarthCloudTexture_ = TextureManager::getSingletonPtr()->loadTexture("earth_clouds_4k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
-	if( mEarthCloudTexture_ == NULL ) // load a lower version if size of texture isn't supported
-		mEarthCloudTexture_ = TextureManager::getSingletonPtr()->loadTexture("earth_clouds_1k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
-
-	mStarMap_ = TextureManager::getSingletonPtr()->loadTexture("starmap_4k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
-	if( mStarMap_ == NULL ) // load a lower version if size of texture isn't supported
-		mStarMap_ = TextureManager::getSingletonPtr()->loadTexture("starmap_1k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+	// The textures are decoded in the background, until then a placeholder is bound.
+	// Images which are too big for the machine are scaled down by the TextureManager.
+	TextureManager* tm = TextureManager::getSingletonPtr();
+	// compress the textures with S3TC and keep the compressed versions next to the images for the next start
+	if( mCompressTextures_ )
+		tm->setTextureCompression( true );
+
+	mEarthTexture_ = tm->loadTextureAsync("earthmap4k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+	if( mEarthTexture_ == NULL ) // load a lower version if the texture isn't available
+		mEarthTexture_ = tm->loadTextureAsync("earthmap1k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+
+	mEarthCloudTexture_ = tm->loadTextureAsync("earth_clouds_4k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+	if( mEarthCloudTexture_ == NULL ) // load a lower version if the texture isn't available
+		mEarthCloudTexture_ = tm->loadTextureAsync("earth_clouds_1k.jpg", GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+
+	// the star map is a panorama, which is converted into the faces of a cube map while it is decoded
+	mStarMap_ = tm->loadTextureAsync("starmap_4k.jpg", GL_TEXTURE_CUBE_MAP, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+	if( mStarMap_ == NULL ) // load a lower version if the texture isn't available
+		mStarMap_ = tm->loadTextureAsync("starmap_1k.jpg", GL_TEXTURE_CUBE_MAP, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+	mSkybox_ = new Skybox();
+	// the finest levels are the tessellations the Earth was always drawn with
+	mEarthLOD_ = new SphereLOD( 100 );
+	mGridLOD_ = new SphereLOD( 50 );
+	mCloudLOD_ = new SphereLOD( 120 );
 	
 	mSphereRot_ = 0.0f;
 }	
@@ -185,27 +244,76 @@ RenderEngine::initScene() {
 void 
 RenderEngine::initLight() {
 	// create one light
-	glEnable( GL_LIGHTING );
-	glEnable( GL_LIGHT0 );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	sc->enable( GL_LIGHTING );
+	sc->enable( GL_LIGHT0 );
 	setLight();
 }	
 
 void 
 RenderEngine::setLight() {
 	// set position
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
 	float pos[4] =		{ 20.0f , 20.0f , 0.0f, 1.0f};
 	float ambient[4] =  {  0.18f,  0.18f, 0.1f, 1.0f};
 	float diffuse[4] =  {  1.0f ,  1.0f , 0.7f, 1.0f};
 	float specular[4] = {  1.0f ,  1.0f , 0.7f, 1.0f};
-	glLightfv(GL_LIGHT0, GL_POSITION, pos );
-	// set the color of the Light
-	glLightfv(GL_LIGHT0, GL_AMBIENT,  ambient );
-	glLightfv(GL_LIGHT0, GL_DIFFUSE,  diffuse );
-	glLightfv(GL_LIGHT0, GL_SPECULAR, specular );
+	sc->light(GL_LIGHT0, GL_POSITION, pos );
+	// set the color of the Light (it never changes, so the cache filters these calls after the first frame)
+	sc->light(GL_LIGHT0, GL_AMBIENT,  ambient );
+	sc->light(GL_LIGHT0, GL_DIFFUSE,  diffuse );
+	sc->light(GL_LIGHT0, GL_SPECULAR, specular );
+	if( mLightingShader_ != NULL || mCompositor_ != NULL ) {
+		// glLight transforms the position with the current modelview matrix, the shaders get it transformed
+		GLfloat view[16];
+		glGetFloatv( GL_MODELVIEW_MATRIX, view );
+		float eyePos[4];
+		for( unsigned r = 0; r < 4; ++r )
+			eyePos[r] = view[r] * pos[0] + view[4 + r] * pos[1] + view[8 + r] * pos[2] + view[12 + r] * pos[3];
+		if( mLightingShader_ != NULL )
+			mLightingShader_->setLight( eyePos, ambient, diffuse, specular );
+		if( mCompositor_ != NULL )
+			mCompositor_->setLight( eyePos, ambient, diffuse, specular );
+	}
+}
+
+void
+RenderEngine::setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float const emission[4], float shininess ) {
+	if( mLightingShader_ != NULL ) {
+		mLightingShader_->setMaterial( ambient, diffuse, specular, emission, shininess );
+		return;
+	}
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	sc->material( GL_FRONT, GL_AMBIENT, ambient );
+	sc->material( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
+	sc->material( GL_FRONT, GL_SPECULAR, specular );
+	sc->material( GL_FRONT_AND_BACK, GL_EMISSION, emission );
+	sc->material( GL_FRONT, GL_SHININESS, shininess );
+}
+
+void
+RenderEngine::beginShading( bool textured ) {
+	if( mLightingShader_ != NULL )
+		mLightingShader_->bind( textured );
+}
+
+void
+RenderEngine::endShading() {
+	if( mLightingShader_ != NULL )
+		mLightingShader_->unbind();
+}
+
+void
+RenderEngine::applyEarthTransform() {
+	glTranslatef( 0.0f,0.0f,-20.0f );
+	glRotatef(mSphereRot_,0.0f,1.0f,0.0f);
+	glRotatef(23.44f,0.0f,0.0f,1.0f);
+	glRotatef(90.0f,1.0f,0.0f,0.0f);
 }
 
 bool
 RenderEngine::display( double timeSinceLastFrame ) {
+	PROFILE_ZONE( "RenderEngine::display" );
 	// render something 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glMatrixMode( GL_MODELVIEW );
@@ -215,6 +323,9 @@ RenderEngine::display( double timeSinceLastFrame ) {
 	InputManager::getSingletonPtr()->updateCameraMovements( timeSinceLastFrame );
 	// do the cameras movement in OpenGL calls
 	InputManager::getSingletonPtr()->doGLCameraMovement();
+	mTriangleCount_ = 0;
+	if( mScene_ != NULL )
+		return displayScene( timeSinceLastFrame );
 	
 
 	glPushMatrix();
@@ -226,182 +337,170 @@ RenderEngine::display( double timeSinceLastFrame ) {
 	float specular[4] = { 1.0f , 1.0f , 0.9f , 0.3f};
 	float emmisive[4] = { 0.0f , 0.0f , 0.0f , 0.3f};
 	float shininess = 100;
-	glMaterialfv( GL_FRONT, GL_AMBIENT, ambient );
-	glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
-	glMaterialfv( GL_FRONT, GL_SPECULAR, specular );
-	glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, emmisive );
-	glMaterialf( GL_FRONT, GL_SHININESS, shininess );
+	// the colors are set per object below, before anything is drawn
 
 	
-	//// draw the starmap
-	glDisable( GL_LIGHTING );
-
-	glColor3f(1.0f,1.0f,1.0f);
+	glMatrixMode( GL_MODELVIEW );
 
-	float size = 2000.0f;
-	float txMax = 1.0f;
-	if( mStarMap_ != NULL )
-		mStarMap_->bind();
 	glPushMatrix();
-	glRotatef(mSphereRot_ / 5.0f, 0.2f, 0.7f, 0.4f);
-	glBegin(GL_QUADS);	
-		// top plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(-size,size, -size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( size,size, -size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( size,size, size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(-size,size, size);				// Bottom Left
-		// botom plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(-size,-size, -size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( size,-size, -size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( size,-size, size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(-size,-size, size);				// Bottom Left
-		// back plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(-size,-size, -size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( size,-size, -size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( size,size, -size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(-size,size, -size);				// Bottom Left
-		// front plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(-size,-size, size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( size,-size, size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( size,size, size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(-size,size, size);				// Bottom Left
-		// left plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(-size,-size, -size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( -size,-size, size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( -size,size, size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(-size,size, -size);				// Bottom Left
-		// right plane
-		glTexCoord2f(0.0f,txMax);
-		glVertex3f(size,-size, -size);				// Top Left
-		glTexCoord2f(txMax, txMax);
-		glVertex3f( size,-size, size);				// Top Right
-		glTexCoord2f(txMax,0.0f);
-		glVertex3f( size,size, size);				// Bottom Right
-		glTexCoord2f(0.0f,0.0f);
-		glVertex3f(size,size, -size);				// Bottom Left
-	glEnd();							
-	if( mStarMap_ != NULL )
-		mStarMap_->unbind();
-	glPopMatrix();
-	
-	glEnable( GL_LIGHTING );
-
-	glMatrixMode( GL_MODELVIEW );
+	applyEarthTransform();
 
-	glTranslatef( 0.0f,0.0f,-20.0f );
-	glRotatef(mSphereRot_,0.0f,1.0f,0.0f);
-	glRotatef(23.44f,0.0f,0.0f,1.0f);
-	glRotatef(90.0f,1.0f,0.0f,0.0f);
+	// the size of the Earth on the screen selects the tessellation of its spheres (the cloud rotation doesn't move the center)
+	GLfloat earthView[16];
+	glGetFloatv( GL_MODELVIEW_MATRIX, earthView );
+	float const center[3] = { 0.0f, 0.0f, 0.0f };
+	mEarthLevel_ = mEarthLOD_->selectLevel( SphereLOD::getProjectedRadius( earthView, center, 5.0f, mPixelScale_ ), mEarthLevel_ );
+	mGridLevel_ = mGridLOD_->selectLevel( SphereLOD::getProjectedRadius( earthView, center, 5.1f, mPixelScale_ ), mGridLevel_ );
+	mCloudLevel_ = mCloudLOD_->selectLevel( SphereLOD::getProjectedRadius( earthView, center, 5.4f, mPixelScale_ ), mCloudLevel_ );
 
 	// set material settings
 	ambient[3] = 1.0f;
 	diffuse[3] = 1.0f;
 	specular[3] = 1.0f;
 	emmisive[3] = 1.0f;
-	glMaterialfv( GL_FRONT, GL_AMBIENT, ambient );
-	glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
-	glMaterialfv( GL_FRONT, GL_SPECULAR, specular );
-	glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, emmisive );
-
+	setMaterial( ambient, diffuse, specular, emmisive, shininess );
+
+	if( mCompositor_ != NULL ) {
+		PROFILE_ZONE( "RenderEngine::earth" );
+		GPUZone gpuZone( mGPUTimer_, PASS_EARTH );
+		// the grid and the clouds are blended over the surface by the shader, with the colors they are drawn with below
+		mCompositor_->setMaterial( ambient, diffuse, specular, shininess );
+		mCompositor_->setClouds( CLOUD_EMISSION, mSphereRot_ / 2.0f, 0.3f, 0.6f, 0.4f );
+		mCompositor_->setGrid( mGridLOD_->getDetail( mGridLevel_ ), 0.3f );
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		SphereMesh* earth = mEarthLOD_->getMesh( mEarthLevel_ );
+		mCompositor_->draw( earth, 5.0f, mEarthTexture_, mEarthCloudTexture_ );
+		mTriangleCount_ += earth->getTriangleCount();
+	}
+	else {
+		PROFILE_ZONE( "RenderEngine::earth" );
+		GPUZone gpuZone( mGPUTimer_, PASS_EARTH );
 		// Draw a Textured Sphere
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		// Draw the Earth
 		if( mEarthTexture_ != NULL )
 			mEarthTexture_->bind();
 		glColor4f(1.0f,1.0f,1.0f, 1.0f);
-		GLUquadric* qobj = gluNewQuadric();
-			gluQuadricTexture(qobj,GL_TRUE);
-			gluQuadricOrientation(qobj, GLU_INSIDE);
-			gluQuadricDrawStyle(qobj, GLU_FILL);
-			gluQuadricNormals( qobj, GLU_SMOOTH);
-			gluQuadricOrientation( qobj, GLU_OUTSIDE);
-			gluSphere(qobj,5.0f,100,100);
-		gluDeleteQuadric(qobj);
+		beginShading( mEarthTexture_ != NULL );
+		SphereMesh* earth = mEarthLOD_->getMesh( mEarthLevel_ );
+		earth->draw( 5.0f );
+		mTriangleCount_ += earth->getTriangleCount();
+		endShading();
 		if( mEarthTexture_ != NULL )
 			mEarthTexture_->unbind();
+	}
+	glPopMatrix();
 
-		// draw the grid of the Earth
-		// set material settings
-		ambient[3] = 0.3f;
-		diffuse[3] = 0.3f;
-		specular[3] = 0.3f;
-		emmisive[3] = 0.3f;
-		glMaterialfv( GL_FRONT, GL_AMBIENT, ambient );
-		glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
-		glMaterialfv( GL_FRONT, GL_SPECULAR, specular );
-		glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, emmisive );
-		glColor4f(1.0f,1.0f,1.0f, 0.3f);
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		qobj = gluNewQuadric();
-			gluQuadricTexture(qobj,GL_FALSE);
-			gluQuadricOrientation(qobj, GLU_INSIDE);
-			gluQuadricDrawStyle(qobj, GLU_FILL);
-			gluQuadricNormals( qobj, GLU_SMOOTH);
-			gluQuadricOrientation( qobj, GLU_OUTSIDE);
-			gluSphere(qobj,5.1f,50,50);
-		gluDeleteQuadric(qobj);
-
-		// draw the Axis of the Earth
-		glBegin( GL_LINES );
-			glColor3f(1.0f,1.0f,0.0f);
-			glVertex3f(0.0f, 0.0, -10.0f);
-			glVertex3f(0.0f, 0.0, 10.0f);
-		glEnd();
+	// draw the starmap after the opaque earth (the pixels covered by it are rejected by the depth test)
+	// and before the translucent grid and clouds, which are blended over it
+	glPushMatrix();
+	glRotatef(mSphereRot_ / 5.0f, 0.2f, 0.7f, 0.4f);
+	if( mSkybox_ != NULL ) {
+		GPUZone gpuZone( mGPUTimer_, PASS_SKYBOX );
+		mSkybox_->draw( mStarMap_ );
+	}
+	glPopMatrix();
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		// draw the clouds of the Earth
+	glPushMatrix();
+	applyEarthTransform();
+
+		// draw the grid of the Earth (the single pass leaves only the axis)
 		// set material settings
 		ambient[3] = 0.3f;
 		diffuse[3] = 0.3f;
 		specular[3] = 0.3f;
-		emmisive[0] = 0.7f;
-		emmisive[1] = 0.7f;
-		emmisive[2] = 0.7f;
 		emmisive[3] = 0.3f;
-		glMaterialfv( GL_FRONT, GL_AMBIENT, ambient );
-		glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
-		glMaterialfv( GL_FRONT, GL_SPECULAR, specular );
-		glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, emmisive );
-		glPushMatrix();
-		glRotatef(mSphereRot_/2.0f, 0.3f, 0.6f, 0.4f );
-		if( mEarthCloudTexture_ != NULL )
-			mEarthCloudTexture_->bind();
+		setMaterial( ambient, diffuse, specular, emmisive, shininess );
 		glColor4f(1.0f,1.0f,1.0f, 0.3f);
-		qobj = gluNewQuadric();
-			gluQuadricTexture(qobj,GL_TRUE);
-			gluQuadricOrientation(qobj, GLU_INSIDE);
-			gluQuadricDrawStyle(qobj, GLU_FILL);
-			gluQuadricNormals( qobj, GLU_SMOOTH);
-			gluQuadricOrientation( qobj, GLU_OUTSIDE);
-			gluSphere(qobj,5.4f,120,120);
-		gluDeleteQuadric(qobj);
-		if( mEarthCloudTexture_ != NULL )
-			mEarthCloudTexture_->unbind();
-		glPopMatrix();
+		{
+			PROFILE_ZONE( "RenderEngine::grid" );
+			GPUZone gpuZone( mGPUTimer_, PASS_GRID );
+			beginShading( false );
+			if( mCompositor_ == NULL )
+				mGridLOD_->getMesh( mGridLevel_ )->drawWireframe( 5.1f );
+
+			// draw the Axis of the Earth
+			glBegin( GL_LINES );
+				glColor3f(1.0f,1.0f,0.0f);
+				glVertex3f(0.0f, 0.0, -10.0f);
+				glVertex3f(0.0f, 0.0, 10.0f);
+			glEnd();
+			endShading();
+		}
+
+		// draw the clouds of the Earth, the single pass has already done this
+		if( mCompositor_ == NULL ) {
+			// set material settings
+			ambient[3] = CLOUD_EMISSION[3];
+			diffuse[3] = CLOUD_EMISSION[3];
+			specular[3] = CLOUD_EMISSION[3];
+			for( unsigned i = 0; i < 4; ++i )
+				emmisive[i] = CLOUD_EMISSION[i];
+			setMaterial( ambient, diffuse, specular, emmisive, shininess );
+			glPushMatrix();
+			glRotatef(mSphereRot_/2.0f, 0.3f, 0.6f, 0.4f );
+			{
+				PROFILE_ZONE( "RenderEngine::clouds" );
+				GPUZone gpuZone( mGPUTimer_, PASS_CLOUDS );
+				if( mEarthCloudTexture_ != NULL )
+					mEarthCloudTexture_->bind();
+				glColor4f(1.0f,1.0f,1.0f, CLOUD_EMISSION[3]);
+				beginShading( mEarthCloudTexture_ != NULL );
+				SphereMesh* clouds = mCloudLOD_->getMesh( mCloudLevel_ );
+				clouds->draw( 5.4f );
+				mTriangleCount_ += clouds->getTriangleCount();
+				endShading();
+				if( mEarthCloudTexture_ != NULL )
+					mEarthCloudTexture_->unbind();
+			}
+			glPopMatrix();
+		}
 
 	glPopMatrix();
+	glPopMatrix();
 	
-	mSphereRot_ += 3.0f * (float)timeSinceLastFrame;
+	if( mBenchmark_ != NULL || !InputManager::getSingletonPtr()->isAnimationPaused() )
+		mSphereRot_ += 3.0f * (float)timeSinceLastFrame;
+	return true;
+}
+
+bool
+RenderEngine::displayScene( double timeSinceLastFrame ) {
+	// the camera starts outside of the system, looking down onto the plane of the orbits
+	glTranslatef( 0.0f, 0.0f, -mScene_->getViewDistance() );
+	glRotatef( mScene_->getViewPitch(), 1.0f, 0.0f, 0.0f );
+	mScene_->update( mSceneTime_ );
+	// only the camera is on the modelview matrix, so the frustum is given in the coordinates of the scene
+	GLfloat projection[16], view[16];
+	glGetFloatv( GL_PROJECTION_MATRIX, projection );
+	glGetFloatv( GL_MODELVIEW_MATRIX, view );
+	Frustum frustum;
+	frustum.extract( projection, view );
+	mScene_->cull( frustum );
+	mTriangleCount_ = mScene_->selectDetail( view, mPixelScale_ );
+
+	// the light shines from the star, its colors were set by initLight()
+	float pos[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	int star = mScene_->getLightSource();
+	if( star >= 0 )
+		mScene_->getPosition( (unsigned)star, pos );
+	GLStateCache::getSingletonPtr()->light( GL_LIGHT0, GL_POSITION, pos );
+
+	{
+		GPUZone gpuZone( mGPUTimer_, PASS_BODIES );
+		mScene_->draw();
+	}
+	if( mSkybox_ != NULL ) {
+		GPUZone gpuZone( mGPUTimer_, PASS_SKYBOX );
+		mSkybox_->draw( mStarMap_ );
+	}
+	{
+		GPUZone gpuZone( mGPUTimer_, PASS_TRANSLUCENT );
+		mScene_->drawTranslucent();
+	}
+
+	if( mBenchmark_ != NULL || !InputManager::getSingletonPtr()->isAnimationPaused() )
+		mSceneTime_ += timeSinceLastFrame * mScene_->getTimeScale();
 	return true;
 }
 
@@ -412,77 +511,326 @@ RenderEngine::startRenderLoop() {
 		// a Framecounter
 		// renderengine was successfully initialized
 		bool done = false;
+		if( mHeadless_ || mBenchmark_ != NULL ) {
+			// the frames of a headless or benchmark run have to be reproducible, so they must not show any placeholders
+			while( TextureManager::getSingletonPtr()->processPendingUploads() > 0 )
+				SDL_Delay( 1 );
+		}
+		Profiler::setThreadName( "Render" );
+		if( !mProfilePath_.empty() )
+			Profiler::start();
+		unsigned pendingTextures = 0;
+		bool eventsHandled = false;
 			while( !done ) {
-				double timeSinceLastFrame = 0.0;
+				// in idle mode an unchanged scene is not rendered again - sleep until something happens
+				if( mIdleMode_ && mBenchmark_ == NULL && !mHeadless_ && !eventsHandled && pendingTextures == 0 &&
+					InputManager::getSingletonPtr()->isAnimationPaused() && !InputManager::getSingletonPtr()->isCameraMoving() ) {
+					SDL_Event sdlEvent;
+					if( SDL_WaitEvent( &sdlEvent ) )
+						SDL_PushEvent( &sdlEvent ); // it is handled with the other events of the frame
+					// the time spent waiting must neither move the Camera nor count as a frame
+					mClock_.reset();
+					mFrameLimiter_.reset();
+				}
+				eventsHandled = false;
+				double phases[Benchmark::PHASE_COUNT];
+				double phaseStart = Clock::getSeconds();
+				// the animation is driven by the smoothed frame time, single slow frames would make it stutter
+				mClock_.tick();
+				double timeSinceLastFrame = mClock_.getSmoothedDelta();
 
-#ifndef WIN32
-				timeval tvBegin;
-				gettimeofday(&tvBegin, NULL);
+				// a benchmark run advances the same simulated time every frame
+				if( mBenchmark_ != NULL )
+					timeSinceLastFrame = mBenchmark_->getTimestep();
+				// upload the textures which were decoded in the background
+				pendingTextures = TextureManager::getSingletonPtr()->processPendingUploads();
+				if( mBenchmark_ != NULL ) {
+					float rot[3], trans[3];
+					Benchmark::getCameraPath( frame * mBenchmark_->getTimestep(), rot, trans );
+					InputManager::getSingletonPtr()->setCamera( rot, trans );
+				}
+				double now = Clock::getSeconds();
+				phases[Benchmark::PHASE_UPDATE] = now - phaseStart;
+				phaseStart = now;
 
+				if( mGPUTimer_ != NULL )
+					mGPUTimer_->beginFrame();
+				done = !display( timeSinceLastFrame );
+				now = Clock::getSeconds();
+				phases[Benchmark::PHASE_DRAW] = now - phaseStart;
 
-				double tv = tvBegin.tv_sec + (tvBegin.tv_usec / 1000000.0);
-				if( unixLastTime >= 0.0f )
-					timeSinceLastFrame = tv - unixLastTime;
-				else
-					timeSinceLastFrame = 0.0f;
-				unixLastTime = tv;
-#else
-				double currentTime = timeGetTime() / 1000.0;	
-				if( win32LastTime >= 0.0 )
-					timeSinceLastFrame = currentTime - win32LastTime;
-				else
-					timeSinceLastFrame = 0.0;
-				win32LastTime = currentTime;
-#endif
-				done = !display( timeSinceLastFrame );
-				SDL_Event sdlEvent;
-				while ( SDL_PollEvent(&sdlEvent) ) {
-					// call the InputManagers callback methods
-					if ( sdlEvent.type == SDL_KEYDOWN ) {
-						done = !InputManager::getSingletonPtr()->keyDown( sdlEvent );
-						if( done )
-							break;
-					}
-					if ( sdlEvent.type == SDL_KEYUP ) {
-						done = !InputManager::getSingletonPtr()->keyUp( sdlEvent );
-						if( done )
-							break;
-					}
-					if ( sdlEvent.type == SDL_MOUSEBUTTONDOWN ) {
-						done = !InputManager::getSingletonPtr()->mouseDown( sdlEvent );
-						if( done )
-							break;
-					}
-					if ( sdlEvent.type == SDL_MOUSEBUTTONUP ) {
-						done = !InputManager::getSingletonPtr()->mouseUp( sdlEvent );
-						if( done )
-							break;
-					}
-					if ( sdlEvent.type == SDL_MOUSEMOTION ) {
-						done = !InputManager::getSingletonPtr()->mouseMoved( sdlEvent );
-						if( done )
-							break;
+				// the readback is not part of any phase
+				if( !mDumpPath_.empty() && frame == mDumpFrame_ )
+					saveFrame( mDumpPath_ );
+				phaseStart = Clock::getSeconds();
+
+				{
+					PROFILE_ZONE( "RenderEngine::events" );
+					SDL_Event sdlEvent;
+					// without a window there are no events
+					while ( !mHeadless_ && SDL_PollEvent(&sdlEvent) ) {
+						// the result of the events is shown in the next frame, even in idle mode
+						eventsHandled = true;
+						// the scripted camera of a benchmark must not be disturbed
+						if( mBenchmark_ != NULL ) {
+							if( sdlEvent.type == SDL_KEYDOWN && sdlEvent.key.keysym.sym == SDLK_ESCAPE )
+								done = true;
+							continue;
+						}
+						// call the InputManagers callback methods
+						if ( sdlEvent.type == SDL_KEYDOWN ) {
+							done = !InputManager::getSingletonPtr()->keyDown( sdlEvent );
+							if( done )
+								break;
+						}
+						if ( sdlEvent.type == SDL_KEYUP ) {
+							done = !InputManager::getSingletonPtr()->keyUp( sdlEvent );
+							if( done )
+								break;
+						}
+						if ( sdlEvent.type == SDL_MOUSEBUTTONDOWN ) {
+							done = !InputManager::getSingletonPtr()->mouseDown( sdlEvent );
+							if( done )
+								break;
+						}
+						if ( sdlEvent.type == SDL_MOUSEBUTTONUP ) {
+							done = !InputManager::getSingletonPtr()->mouseUp( sdlEvent );
+							if( done )
+								break;
+						}
+						if ( sdlEvent.type == SDL_MOUSEMOTION ) {
+							done = !InputManager::getSingletonPtr()->mouseMoved( sdlEvent );
+							if( done )
+								break;
+						}
 					}
 				}
+				now = Clock::getSeconds();
+				phases[Benchmark::PHASE_INPUT] = now - phaseStart;
+				phaseStart = now;
+
 				++frame;
-				SDL_GL_SwapBuffers();
+				{
+					PROFILE_ZONE( "RenderEngine::swap" );
+					if( mHeadless_ ) {
+						// without a swap nothing waits for the GPU - a benchmark has to, else the GPU time would not be measured
+						if( mBenchmark_ != NULL )
+							glFinish();
+						else
+							glFlush();
+					}
+					else
+						SDL_GL_SwapBuffers();
+				}
+				phases[Benchmark::PHASE_SWAP] = Clock::getSeconds() - phaseStart;
+				if( mBenchmark_ != NULL )
+					mBenchmark_->addFrame( phases );
+				else {
+					PROFILE_ZONE( "FrameLimiter::wait" );
+					mFrameLimiter_.wait();
+				}
+				Profiler::frameMark();
+				if( mFrameLimit_ != 0 && frame >= mFrameLimit_ )
+					done = true;
 			}
+		if( mBenchmark_ != NULL )
+			reportBenchmark();
+		if( !mProfilePath_.empty() )
+			reportProfile();
+		if( mGPUTimer_ != NULL )
+			mGPUTimer_->logSummary();
 	}
 	else
-		LogManager::getSingletonPtr()->logMessage("RenderError: SDL wasnt setup successfully. Cannot start RenderLoop.");
-	std::stringstream log;
-	log << "Renderengine: " << frame << " Frames rendered.";
-	LogManager::getSingletonPtr()->logMessage( log );
+		LOG_ERROR( RENDER, "RenderEngine: SDL wasnt setup successfully. Cannot start RenderLoop." );
+	LOG_INFO( RENDER, "Renderengine: " << frame << " Frames rendered. Mean frame time of the last " << mClock_.getHistoryCount()
+					  << " Frames: " << mClock_.getAverageDelta() * 1000.0 << " ms." );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	LOG_INFO( RENDER, "GLStateCache: " << sc->getIssuedCount() << " state changes issued, " << sc->getFilteredCount() << " filtered, "
+					  << sc->getQueryCount() << " state queries." );
+	if( mLightingShader_ != NULL )
+		LOG_INFO( RENDER, "LightingShader: " << mLightingShader_->getUploadCount() << " uploads of the light and material uniforms." );
+	if( mCompositor_ != NULL )
+		LOG_INFO( RENDER, "EarthCompositor: " << mCompositor_->getUploadCount() << " uploads of the uniforms." );
+	LOG_INFO( RENDER, "RenderEngine: " << mTriangleCount_ << " triangles were drawn in the last frame." );
+	if( mScene_ != NULL )
+		LOG_INFO( RENDER, "SceneGraph: " << mScene_->getVisibleCount() << " of " << mScene_->getBodyCount() << " bodies were visible in the last frame, drawn with "
+						  << mScene_->getDrawCount() << " draw calls." );
 	SDL_Quit();
 }
 
+void
+RenderEngine::setFrameLimit( unsigned frames ) {
+	mFrameLimit_ = frames;
+}
+
+void
+RenderEngine::setFrameDump( unsigned frame, std::string const& path ) {
+	mDumpFrame_ = frame;
+	mDumpPath_ = path;
+}
+
+bool
+RenderEngine::saveFrame( std::string const& path ) {
+	ImageData image;
+	image.width = mWindow_.x;
+	image.height = mWindow_.y;
+	image.components = 3;
+	image.format = GL_RGB;
+	image.pixels.resize( image.width * image.height * image.components );
+	// the rows are tightly packed, like the ones of the decoded images
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels( 0, 0, image.width, image.height, GL_RGB, GL_UNSIGNED_BYTE, &image.pixels[0] );
+	glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+	if( !TextureManager::getSingletonPtr()->saveImage( path, image ) )
+		return false;
+	LOG_INFO( RENDER, "RenderEngine: Frame written to '" << path << "'." );
+	return true;
+}
+
+void
+RenderEngine::setBenchmark( unsigned frames, double timestep, std::string const& reportPath ) {
+	delete mBenchmark_;
+	mBenchmark_ = new Benchmark( frames, timestep );
+	mBenchmarkPath_ = reportPath;
+	mFrameLimit_ = frames;
+}
+
+void
+RenderEngine::setTargetFPS( double fps ) {
+	mFrameLimiter_.setTargetFPS( fps );
+	if( fps > 0.0 )
+		LOG_INFO( RENDER, "RenderEngine: Frame rate limited to " << fps << " FPS." );
+}
+
+bool
+RenderEngine::setSwapInterval( int interval ) {
+	if( !mValid_ || mHeadless_ )
+		return false;
+	return FrameLimiter::setSwapInterval( interval );
+}
+
+void
+RenderEngine::setIdleMode( bool idle ) {
+	mIdleMode_ = idle;
+}
+
+void
+RenderEngine::setProfileOutput( std::string const& tracePath ) {
+	mProfilePath_ = tracePath;
+}
+
+void
+RenderEngine::setGPUTiming( bool enable ) {
+	delete mGPUTimer_;
+	mGPUTimer_ = NULL;
+	if( !enable || !mValid_ )
+		return;
+	// the passes are added in the order of RenderPass
+	mGPUTimer_ = new GPUTimer();
+	mGPUTimer_->addPass( "earth" );
+	mGPUTimer_->addPass( "skybox" );
+	mGPUTimer_->addPass( "grid" );
+	mGPUTimer_->addPass( "clouds" );
+	mGPUTimer_->addPass( "bodies" );
+	mGPUTimer_->addPass( "translucent" );
+	mGPUTimer_->init();
+}
+
+void
+RenderEngine::setShaders( bool enable ) {
+	delete mLightingShader_;
+	mLightingShader_ = NULL;
+	if( !enable || !mValid_ )
+		return;
+	mLightingShader_ = LightingShader::create();
+	if( mLightingShader_ == NULL )
+		LOG_WARNING( RENDER, "RenderEngine: The Earth is lit by the fixed function pipeline." );
+}
+
+void
+RenderEngine::setCompositing( bool enable ) {
+	delete mCompositor_;
+	mCompositor_ = NULL;
+	if( !enable || !mValid_ )
+		return;
+	mCompositor_ = EarthCompositor::create();
+	if( mCompositor_ == NULL )
+		LOG_WARNING( RENDER, "RenderEngine: The grid and the clouds are blended over the Earth." );
+}
+
+bool
+RenderEngine::setScene( std::string const& filename, bool instancing ) {
+	delete mScene_;
+	mScene_ = NULL;
+	if( !mValid_ )
+		return false;
+	std::string path = RessourceManager::getSingletonPtr()->getPath( filename );
+	if( path.empty() )
+		return false;
+	mScene_ = new SceneGraph();
+	std::string error;
+	if( !mScene_->load( path, error ) ) {
+		LOG_ERROR( RENDER, "RenderEngine: " << error );
+		delete mScene_;
+		mScene_ = NULL;
+		return false;
+	}
+	mScene_->setInstancing( instancing );
+	mSceneTime_ = 0.0;
+	return true;
+}
+
+void
+RenderEngine::reportProfile() {
+	Profiler::stop();
+	Profiler::logSummary();
+	std::string error;
+	if( Profiler::exportChromeTrace( mProfilePath_, error ) )
+		LOG_INFO( RENDER, "RenderEngine: Profile written to '" << mProfilePath_ << "'." );
+	else
+		LOG_ERROR( RENDER, "RenderEngine: " << error );
+}
+
+void
+RenderEngine::reportBenchmark() {
+	if( !mBenchmark_->isFinished() )
+		LOG_WARNING( RENDER, "RenderEngine: The benchmark was aborted, the report covers the rendered frames only." );
+	std::string json = mBenchmark_->toJSON();
+	LOG_INFO( RENDER, "RenderEngine: Benchmark results:\n" << json );
+	if( !mBenchmarkPath_.empty() ) {
+		std::ofstream file( mBenchmarkPath_.c_str() );
+		file << json;
+		if( !file )
+			LOG_ERROR( RENDER, "RenderEngine: Could not write the benchmark report '" << mBenchmarkPath_ << "'." );
+		else
+			LOG_INFO( RENDER, "RenderEngine: Benchmark report written to '" << mBenchmarkPath_ << "'." );
+	}
+}
+
 RenderEngine::~RenderEngine() {
-	// delete all Singleton managers and all used textures
-	RessourceManager::destroy();
-	LogManager::destroy();
 	// call the Texturemanager to delete all used textures
 	TextureManager::getSingleton().deleteTexture( mEarthTexture_ );
 	TextureManager::getSingleton().deleteTexture( mEarthCloudTexture_ );
 	TextureManager::getSingleton().deleteTexture( mStarMap_ );
+	delete mScene_;
+	// this stops the decoder threads, which may still read from the archives of the RessourceManager
 	TextureManager::destroy();
+	GLStateCache::destroy();
+	// no thread records anymore
+	Profiler::shutdown();
+	// delete all Singleton managers
+	RessourceManager::destroy();
+	LogManager::destroy();
+	// delete the buffers of all cached spheres and the sky
+	SphereMesh::destroyCache();
+	delete mSkybox_;
+	delete mEarthLOD_;
+	delete mGridLOD_;
+	delete mCloudLOD_;
+	delete mGPUTimer_;
+	delete mLightingShader_;
+	delete mCompositor_;
+	delete mBenchmark_;
+	// the context goes last, everything above still needs it
+	delete mHeadlessContext_;
 }
@@ -5,6 +5,19 @@
 #include <TextureManager.h>
 #include <RessourceManager.h>
 #include <InputManager.h>
+#include <SphereMesh.h>
+#include <Skybox.h>
+#include <GLStateCache.h>
+#include <HeadlessContext.h>
+#include <Benchmark.h>
+#include <Clock.h>
+#include <FrameLimiter.h>
+#include <Profiler.h>
+#include <GPUTimer.h>
+#include <SceneGraph.h>
+#include <SphereLOD.h>
+#include <LightingShader.h>
+#include <EarthCompositor.h>
 
 #include <GL/glew.h>
 #include <GL/gl.h>
@@ -41,20 +54,104 @@ class RenderEngine {
 		 * @param winY The Resolution in Y-Dimension.
 		 * @param aaSamples The number of Anti-Aliasing Samples to use when rendering.
 		 * @param title The title of the Renderwindow.
+		 * @param headless If true, no window is opened. The frames are rendered into a framebuffer object of a
+		 * windowless context (see HeadlessContext), e.g. on machines without a display or a GPU.
+		 * @param compressTextures If true, the textures are compressed with S3TC (lossy) and the compressed versions are
+		 * cached next to the images for the next start (see TextureManager::setTextureCompression()).
 		 * @note The Window Title is only set, if the machine supports this feature.
 		 */
-		RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, unsigned sdlFlags, std::string const& title );
+		RenderEngine( unsigned winX, unsigned winY, unsigned aaSamples, unsigned sdlFlags, std::string const& title, bool headless = false,
+					  bool compressTextures = false );
 		/** This function will start the RenderLoop if the RenderEngine was initialized and is valid.
+		 * In headless mode the loop waits for the textures loaded in the background before the first frame, so the frames don't
+		 * depend on the speed of the decoding.
 		 */
 		void startRenderLoop();
-
+		/** This function limits the number of frames the RenderLoop renders.
+		 * @param frames The RenderLoop stops after this many frames. 0 renders until the window is closed (the default).
+		 * @note In headless mode nothing closes the loop, so a limit should be set.
+		 */
+		void setFrameLimit( unsigned frames );
+		/** This function selects a frame, which is written into an image file after it was rendered.
+		 * @param frame The number of the frame, starting with 0.
+		 * @param path The path of the image. '.ppm' is written directly, other formats (like '.png') by DevIL.
+		 */
+		void setFrameDump( unsigned frame, std::string const& path );
+		/** This function writes the current content of the framebuffer (the back buffer in window mode) into an image file.
+		 * @param path The path of the image (see setFrameDump()).
+		 * @return true if the image was written.
+		 */
+		bool saveFrame( std::string const& path );
+		/** This function turns the RenderLoop into a benchmark run (see Benchmark).
+		 * The loop renders the given number of frames with a fixed timestep and a scripted camera, the input is ignored
+		 * (except for Escape). Afterwards the statistics are logged and written into a file as JSON. The report isn't
+		 * printed to stdout, where the lines of the log writer thread could interleave with it.
+		 * @param frames The number of frames to render and measure.
+		 * @param timestep The simulated time of one frame in seconds.
+		 * @param reportPath The file of the JSON report. If empty, the report is only logged.
+		 */
+		void setBenchmark( unsigned frames, double timestep, std::string const& reportPath );
+		/** This function limits the frame rate of the RenderLoop (see FrameLimiter). Benchmark runs are never limited.
+		 * @param fps The maximum number of frames per second, 0 for no limit (the default).
+		 */
+		void setTargetFPS( double fps );
+		/** This function sets the swap interval of the Renderwindow.
+		 * @param interval 0 disables vsync, 1 enables it, -1 enables adaptive vsync (see FrameLimiter::setSwapInterval()).
+		 * @return true if the interval was set.
+		 */
+		bool setSwapInterval( int interval );
+		/** This function enables the idle mode. In idle mode no frame is rendered while the scene doesn't change, i.e.
+		 * while the animation is paused (P key), the Camera doesn't move and no texture is loading. The RenderLoop sleeps
+		 * until the next event instead.
+		 * @param idle If true, the idle mode is enabled.
+		 */
+		void setIdleMode( bool idle );
+		/** This function records a CPU profile of the RenderLoop (see Profiler). When the loop ends, a summary is logged
+		 * and the zones are written as a Chrome trace.
+		 * @param tracePath The file of the trace, empty to disable profiling.
+		 */
+		void setProfileOutput( std::string const& tracePath );
+		/** This function measures the GPU time of the passes of a frame (see GPUTimer). When the RenderLoop ends,
+		 * the times are logged next to the CPU zones of the Profiler.
+		 * @param enable If true, the passes are measured.
+		 */
+		void setGPUTiming( bool enable );
+		/** This function replaces the Earth of the example by a scene of celestial bodies (see SceneGraph).
+		 * @param filename The name of the scene file, which is searched in the RessourceLocations.
+		 * @param instancing If true, the bodies are drawn instanced where the machine supports it.
+		 * @return true if the scene was loaded, else the Earth is rendered.
+		 */
+		bool setScene( std::string const& filename, bool instancing = true );
+		/** This function lights the Earth with a GLSL program (see LightingShader) instead of the fixed function pipeline.
+		 * If the machine doesn't support GLSL, the fixed function pipeline is kept.
+		 * @param enable If true, the shaders are used.
+		 */
+		void setShaders( bool enable );
+		/** This function draws the Earth, its grid and its clouds in a single pass (see EarthCompositor) instead of
+		 * blending the grid and the clouds over it. If the machine doesn't support GLSL, the spheres are blended.
+		 * @param enable If true, the single pass is used.
+		 */
+		void setCompositing( bool enable );
 
 		~RenderEngine();
 	private:
+		/** The passes measured by the GPUTimer.
+		 */
+		enum RenderPass {
+			PASS_EARTH,
+			PASS_SKYBOX,
+			PASS_GRID,
+			PASS_CLOUDS,
+			PASS_BODIES,
+			PASS_TRANSLUCENT
+		};
 
 		/** This function will open the Renderwindow after parsing the needed variables like the window metrics, ...
 		 */
 		bool initWindow();
+		/** This function creates the windowless context instead of the Renderwindow.
+		 */
+		bool initHeadless();
 		/** This function inits all the managers used in the OOP-Framework
 		 */
 		void initManagers();
@@ -76,19 +173,73 @@ class RenderEngine {
 		 * it have to be calles every frame.
 		 */
 		void setLight();
+		/** This function applies the position, the tilt and the rotation of the Earth to the modelview matrix.
+		 */
+		void applyEarthTransform();
+		/** This function sets the material of the next draw calls, in the uniforms of the LightingShader if it is used.
+		 * @param ambient The ambient color.
+		 * @param diffuse The diffuse color.
+		 * @param specular The specular color.
+		 * @param emission The emission.
+		 * @param shininess The specular exponent.
+		 */
+		void setMaterial( float const ambient[4], float const diffuse[4], float const specular[4], float const emission[4], float shininess );
+		/** This function binds the LightingShader for the next draw calls, nothing happens without it.
+		 * @param textured If true, the lit color is modulated with the bound texture.
+		 */
+		void beginShading( bool textured );
+		/** This function returns to the fixed function pipeline after beginShading().
+		 */
+		void endShading();
 
 		/** This routine contains the OpenGL-Calls which are needed to render the Scene
 		 * @param timeSinceLastFrame The elapsed time since the rendering of the last Frame in seconds.
 		 */
 		bool display( double timeSinceLastFrame );
+		/** This routine renders the SceneGraph instead of the Earth. It is called by display() with the camera set.
+		 * @param timeSinceLastFrame The elapsed time since the rendering of the last Frame in seconds.
+		 */
+		bool displayScene( double timeSinceLastFrame );
+		/** This function logs the statistics of a benchmark run and writes them into mBenchmarkPath_.
+		 */
+		void reportBenchmark();
+		/** This function logs the summary of the profile and writes the trace.
+		 */
+		void reportProfile();
 
 		bool mValid_; //!< If this is true, it indicates that the renderengine was initialized successfully
+		bool mHeadless_; //!< If this is true, there is no window and the frames are rendered offscreen
+		bool mCompressTextures_; //!< If this is true, the textures are compressed with S3TC and cached on disk
+		HeadlessContext* mHeadlessContext_; //!< The windowless context in headless mode, NULL else
+		unsigned mFrameLimit_; //!< The number of frames to render, 0 for no limit
+		unsigned mDumpFrame_; //!< The number of the frame to write into mDumpPath_
+		std::string mDumpPath_; //!< The image file of the dumped frame, empty if no frame is dumped
+		Benchmark* mBenchmark_; //!< The statistics of a benchmark run, NULL if the loop runs normally
+		std::string mBenchmarkPath_; //!< The file of the benchmark report, empty to log it only
+		Clock mClock_; //!< Measures the time between the frames
+		FrameLimiter mFrameLimiter_; //!< Limits the frame rate
+		bool mIdleMode_; //!< If this is true, nothing is rendered while the scene doesn't change
+		std::string mProfilePath_; //!< The file of the Chrome trace, empty if the RenderLoop isn't profiled
 
 		windowSettings mWindow_; //!< The settings of the Window
 
 		Texture* mEarthTexture_; //!< the Texture of the Earth in the Example Program, which is rendered.
 		Texture* mEarthCloudTexture_; //!< the Cloud Texture of the Earth in the Example Program, which is rendered.
-		Texture* mStarMap_; //!< The stars Texture
+		Texture* mStarMap_; //!< The stars Texture (a cube map)
+		Skybox* mSkybox_; //!< The cube the stars are drawn on
+		GPUTimer* mGPUTimer_; //!< Measures the GPU time of the passes, NULL if they aren't measured
+		LightingShader* mLightingShader_; //!< Lights the Earth, NULL if the fixed function pipeline is used
+		EarthCompositor* mCompositor_; //!< Draws the Earth with its grid and clouds in one pass, NULL if they are blended
+		SceneGraph* mScene_; //!< The rendered bodies, NULL if the Earth of the example is rendered
+		double mSceneTime_; //!< The simulated time of the scene in days
+		SphereLOD* mEarthLOD_; //!< The tessellations of the Earth
+		SphereLOD* mGridLOD_; //!< The tessellations of the grid of the Earth
+		SphereLOD* mCloudLOD_; //!< The tessellations of the clouds
+		unsigned mEarthLevel_; //!< The level of detail of the Earth in the last frame
+		unsigned mGridLevel_; //!< The level of detail of the grid in the last frame
+		unsigned mCloudLevel_; //!< The level of detail of the clouds in the last frame
+		float mPixelScale_; //!< The pixels per unit at the distance 1 in front of the camera
+		unsigned mTriangleCount_; //!< The number of triangles drawn in the last frame
 		float mSphereRot_;
 
 
@@ -1,4 +1,12 @@
 #include "RessourceManager.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/types.h>
+	#include <sys/stat.h>
+#endif
 
 // SINGLETON
 RessourceManager* RessourceManager::mInstance_ = NULL;
@@ -20,27 +28,98 @@ RessourceManager::getSingletonPtr( ) {
 
 void 
 RessourceManager::addRessourceLocation( std::string const& loc ) {
-	std::stringstream log;
-	log << "Ressourcemanager: Adding Ressource Location '" << loc << "' to Ressource Manager.";
-	LogManager::getSingletonPtr()->logMessage( log );
+	LOG_INFO( RESOURCE, "Ressourcemanager: Adding Ressource Location '" << loc << "' to Ressource Manager." );
 	std::string locNew = loc;
 	if( locNew.substr( locNew.length()-1, 1 ) != "/" )
 		locNew.append("/");
 	mLocations_.push_back( locNew );
+	unsigned files = scanLocation( (unsigned)mLocations_.size() - 1 );
+	LOG_INFO( RESOURCE, "Ressourcemanager: Indexed " << files << " files in ressource location '" << locNew << "'." );
+}
+
+void
+RessourceManager::addArchiveLocation( std::string const& archive ) {
+	LOG_INFO( RESOURCE, "Ressourcemanager: Adding Archive '" << archive << "' to Ressource Manager." );
+	AssetArchive* a = new AssetArchive();
+	std::string error;
+	if( !a->open( archive, error ) ) {
+		delete a;
+		LOG_WARNING( RESOURCE, "Ressourcemanager: " << error );
+		return;
+	}
+	mArchives_.push_back( a );
+	LOG_INFO( RESOURCE, "Ressourcemanager: Archive '" << archive << "' contains " << a->getEntryCount() << " files." );
+}
+
+bool
+RessourceManager::findArchived( std::string const& filename, AssetEntry& entry ) {
+	for( unsigned i = 0; i < mArchives_.size(); ++i )
+		if( mArchives_[i]->find( filename, entry ) )
+			return true;
+	return false;
+}
+
+void
+RessourceManager::rescan() {
+	mIndex_.clear();
+	for( unsigned i = 0; i < mLocations_.size(); ++i )
+		scanLocation( i );
+	LOG_INFO( RESOURCE, "Ressourcemanager: Rescanned " << mLocations_.size() << " ressource locations, " << mIndex_.size() << " files indexed." );
+}
+
+unsigned
+RessourceManager::scanLocation( unsigned location ) {
+	std::string const& path = mLocations_[location];
+	unsigned files = 0;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE h = FindFirstFileA( ( path + "*" ).c_str(), &data );
+	if( h == INVALID_HANDLE_VALUE )
+		return 0;
+	do {
+		if( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+			continue;
+		mIndex_.insert( std::make_pair( std::string( data.cFileName ), location ) );
+		++files;
+	} while( FindNextFileA( h, &data ) );
+	FindClose( h );
+#else
+	DIR* dir = opendir( path.c_str() );
+	if( dir == NULL )
+		return 0;
+	struct dirent* entry;
+	while( ( entry = readdir( dir ) ) != NULL ) {
+		std::string name( entry->d_name );
+		struct stat st;
+		if( stat( ( path + name ).c_str(), &st ) != 0 || !S_ISREG( st.st_mode ) )
+			continue;
+		mIndex_.insert( std::make_pair( name, location ) );
+		++files;
+	}
+	closedir( dir );
+#endif
+	return files;
 }
 
 std::string 
 RessourceManager::getPath( std::string const& filename ) {
-	std::vector<std::string>::iterator it = mLocations_.begin();
-	while( it != mLocations_.end() ) {
-		if( fileExists( filename, *it ) ) {
-			return *it;
+	if( filename.find_first_of( "/\\" ) == std::string::npos ) {
+		// a plain filename - only the index has to be asked
+		std::tr1::unordered_map< std::string, unsigned >::const_iterator found = mIndex_.find( filename );
+		if( found != mIndex_.end() )
+			return mLocations_[found->second];
+	}
+	else {
+		// the filename contains a subdirectory, which isn't part of the index
+		std::vector<std::string>::iterator it = mLocations_.begin();
+		while( it != mLocations_.end() ) {
+			if( fileExists( filename, *it ) ) {
+				return *it;
+			}
+			++it;
 		}
-		++it;
 	}
-	std::stringstream log;
-	log << "Ressourcemanager Warning: Could not get path for the File " << filename << ". File was not found in available ressource locations.";
-	LogManager::getSingletonPtr()->logMessage( log );
+	LOG_WARNING( RESOURCE, "Ressourcemanager: Could not get path for the File " << filename << ". File was not found in available ressource locations." );
 	return std::string("");
 }
 
@@ -52,9 +131,7 @@ RessourceManager::fileExists( std::string const& file, std::string const& path )
 	inp.open(fullName.c_str(), std::ifstream::in);
 	inp.close();
 	if(!inp.fail()) {
-		std::stringstream log;
-		log << "Ressourcemanager: File " << file << " found in ressource location " << path;
-		LogManager::getSingletonPtr()->logMessage( log );
+		LOG_DEBUG( RESOURCE, "Ressourcemanager: File " << file << " found in ressource location " << path );
 		return true;
 	}
 	return false;
@@ -66,6 +143,10 @@ RessourceManager::RessourceManager() {
 
 RessourceManager::~RessourceManager() {
 	mLocations_.clear();
+	mIndex_.clear();
+	for( unsigned i = 0; i < mArchives_.size(); ++i )
+		delete mArchives_[i];
+	mArchives_.clear();
 }
 
 void
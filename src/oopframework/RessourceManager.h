@@ -13,6 +13,8 @@
 #include <fstream>
 #include <string>
 #include <LogManager.h>
+#include <HashMap.h>
+#include <AssetArchive.h>
 
 /** This Class provides an easy to handle access to the Paths of every File of the RessourceLocations registered.
  * @brief Access the Paths of every File which is part of the registered RessourceLocations
@@ -30,14 +32,33 @@ class RessourceManager {
 		 */
 		static RessourceManager* getSingletonPtr( );
 		/** Add a path to the Ressource Locations.
+		 * The files of the location are indexed right away, so later lookups don't touch the filesystem.
 		 * @param loc the Location to add to the RessourceLocations.
 		 */
 		void addRessourceLocation( std::string const& loc );
+		/** Add a packed archive (see AssetArchive) to the Ressource Locations.
+		 * The archive is mapped into memory, so its files are read without opening them one by one.
+		 * @param archive The path of the archive.
+		 * @note If the archive can't be opened, a Warning will be created and the location is ignored.
+		 */
+		void addArchiveLocation( std::string const& archive );
+		/** Search a file in the registered archives.
+		 * The archives are searched in the order they were added, before any directory is asked by getPath().
+		 * @param filename The Filename to search for.
+		 * @param entry The entry of the file, which can be read with entry.archive->read().
+		 * @return true if the file is part of an archive.
+		 * @note The entry stays valid until the RessourceManager is destroyed.
+		 */
+		bool findArchived( std::string const& filename, AssetEntry& entry );
 		/** Get the full path to a file.
 		 * @param filename The Filename to get the Path from.
 		 * @note If the FileName was not found in any RessourceLocation, an Warning will be created and an empty string will be returned.
+		 * @note Files which were added to a location after it was indexed are only found after a call of rescan().
 		 */
 		std::string getPath( std::string const& filename );
+		/** Rebuilds the index of all RessourceLocations, e.g. after files were added or removed.
+		 */
+		void rescan();
 		/** Destroys the one single instance.
 		 */
 		static void destroy();
@@ -48,11 +69,19 @@ class RessourceManager {
 		 * @param path The Path to search in for the FileName.
 		 */
 		bool fileExists( std::string const& file, std::string const& path );
+		/** This internal Function adds all files of a RessourceLocation to the index.
+		 * Files which are already in the index (from a location registered before) are not replaced.
+		 * @param location The index of the location in mLocations_.
+		 * @return The number of files found in the location.
+		 */
+		unsigned scanLocation( unsigned location );
 		static RessourceManager* mInstance_; //!< the one single instance
 		RessourceManager(); //!< constructor
 		~RessourceManager(); //!< destructor
 
 		std::vector<std::string> mLocations_; //!< The list of registered RessourceLocations
+		std::tr1::unordered_map< std::string, unsigned > mIndex_; //!< The location (index into mLocations_) of every known filename
+		std::vector<AssetArchive*> mArchives_; //!< The list of registered archives
 
 };
 
@@ -0,0 +1,101 @@
+#ifndef RINGBUFFER
+#define RINGBUFFER
+
+#include <Atomic.h>
+
+#include <vector>
+#include <algorithm>
+
+/** This class is a bounded queue, which can be used by several threads without a lock (the algorithm of Dmitry Vyukov).
+ * Every cell carries a sequence number, which tells the producers and consumers whether the cell is free or filled.
+ * A thread never waits for another one: if the queue is full, push() fails and the caller decides what to do.
+ * The items are swapped in and out of the cells, so strings and vectors are moved without copying their content.
+ * @brief A lock-free bounded queue.
+ */
+template< typename T >
+class RingBuffer {
+	public:
+		/** Creates the queue.
+		 * @param capacity The number of cells. It is rounded up to a power of two.
+		 */
+		RingBuffer( unsigned capacity ) {
+			unsigned size = 2;
+			while( size < capacity )
+				size *= 2;
+			mMask_ = size - 1;
+			mCells_ = new Cell[size];
+			for( unsigned i = 0; i < size; ++i )
+				mCells_[i].sequence.set( i );
+		}
+		/** Deletes the cells and the items which were not popped.
+		 */
+		~RingBuffer() {
+			delete[] mCells_;
+		}
+		/** Appends an item. It is safe to call it from any thread.
+		 * @param item The item to append. On success it is swapped with an empty item.
+		 * @return false if the queue is full.
+		 */
+		bool push( T& item ) {
+			long pos = mTail_.get();
+			while( true ) {
+				Cell& cell = mCells_[pos & mMask_];
+				long diff = cell.sequence.get() - pos;
+				if( diff == 0 ) {
+					// the cell is free - try to claim it
+					if( mTail_.compareAndSwap( pos, pos + 1 ) ) {
+						std::swap( cell.item, item );
+						cell.sequence.set( pos + 1 );
+						return true;
+					}
+					pos = mTail_.get();
+				}
+				else if( diff < 0 )
+					return false;
+				else
+					pos = mTail_.get();
+			}
+		}
+		/** Removes the oldest item. It is safe to call it from any thread.
+		 * @param item Is swapped with the oldest item.
+		 * @return false if the queue is empty.
+		 */
+		bool pop( T& item ) {
+			long pos = mHead_.get();
+			while( true ) {
+				Cell& cell = mCells_[pos & mMask_];
+				long diff = cell.sequence.get() - ( pos + 1 );
+				if( diff == 0 ) {
+					if( mHead_.compareAndSwap( pos, pos + 1 ) ) {
+						std::swap( cell.item, item );
+						cell.sequence.set( pos + mMask_ + 1 );
+						return true;
+					}
+					pos = mHead_.get();
+				}
+				else if( diff < 0 )
+					return false;
+				else
+					pos = mHead_.get();
+			}
+		}
+
+	private:
+		// the cells can't be copied
+		RingBuffer( RingBuffer const& );
+		RingBuffer& operator=( RingBuffer const& );
+
+		/** One cell of the queue.
+		 */
+		struct Cell {
+			Atomic sequence;	//!< The position the cell is free for (pos) or filled for (pos + 1)
+			T item;				//!< The item
+		};
+
+		Cell* mCells_;		//!< The cells
+		long mMask_;		//!< The number of cells minus 1
+		Atomic mHead_;		//!< The position of the next pop
+		Atomic mTail_;		//!< The position of the next push
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include <RingMesh.h>
+#include <GLStateCache.h>
+#include <Profiler.h>
+
+#include <cmath>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+RingMesh::RingMesh( float inner, float outer, unsigned segments ) :
+	mVertexBuffer_(0),
+	mUseVBO_(false),
+	mVertexCount_(0) {
+	if( segments < 3 )
+		segments = 3;
+	// an inner and an outer vertex per segment, the first pair is repeated to close the strip
+	std::vector< float > vertices;
+	vertices.reserve( ( segments + 1 ) * 2 * 5 );
+	for( unsigned i = 0; i <= segments; ++i ) {
+		double angle = 2.0 * M_PI * ( i % segments ) / segments;
+		float c = (float)std::cos( angle );
+		float s = (float)std::sin( angle );
+		float const edge[2][5] = {
+			{ 0.0f, 0.5f, inner * c, inner * s, 0.0f },
+			{ 1.0f, 0.5f, outer * c, outer * s, 0.0f }
+		};
+		for( unsigned e = 0; e < 2; ++e )
+			vertices.insert( vertices.end(), edge[e], edge[e] + 5 );
+	}
+	mVertexCount_ = (GLsizei)( vertices.size() / 5 );
+
+	mUseVBO_ = ( GLEW_VERSION_1_5 == GL_TRUE );
+	if( mUseVBO_ ) {
+		glGenBuffers( 1, &mVertexBuffer_ );
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glBufferData( GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	}
+	else
+		mVertices_.swap( vertices );
+}
+
+void
+RingMesh::draw() const {
+	PROFILE_ZONE( "RingMesh::draw" );
+	// the ring is seen from both sides and has no normals, so it is drawn unlit
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	bool lighting = sc->isEnabled( GL_LIGHTING );
+	bool culling = sc->isEnabled( GL_CULL_FACE );
+	sc->disable( GL_LIGHTING );
+	sc->disable( GL_CULL_FACE );
+	if( mUseVBO_ ) {
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glInterleavedArrays( GL_T2F_V3F, 0, 0 );
+	}
+	else
+		glInterleavedArrays( GL_T2F_V3F, 0, &mVertices_[0] );
+	glDrawArrays( GL_TRIANGLE_STRIP, 0, mVertexCount_ );
+	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
+	if( mUseVBO_ )
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	if( lighting )
+		sc->enable( GL_LIGHTING );
+	if( culling )
+		sc->enable( GL_CULL_FACE );
+}
+
+RingMesh::~RingMesh() {
+	if( mUseVBO_ )
+		glDeleteBuffers( 1, &mVertexBuffer_ );
+}
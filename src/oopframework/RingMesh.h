@@ -0,0 +1,48 @@
+#ifndef RINGMESH
+#define RINGMESH
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+
+#include <vector>
+
+/** This class holds a flat ring (an annulus) in the xy-plane, the equatorial plane of a SphereMesh.
+ * The texture coordinate s runs from the inner (0) to the outer edge (1), so a strip of the colors along the
+ * radius (like saturnringcolor.jpg) can be mapped onto it. The ring is built once and drawn from a Vertex Buffer Object.
+ * @brief The rings of a planet.
+ * @code
+ * RingMesh rings( 4.2f, 7.7f );
+ * // with the matrix of the planet on the modelview stack
+ * rings.draw();
+ * @endcode
+ */
+class RingMesh {
+	public:
+		/** Creates the ring.
+		 * @param inner The inner radius.
+		 * @param outer The outer radius.
+		 * @param segments The number of segments around the ring.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		RingMesh( float inner, float outer, unsigned segments = 128 );
+		/** Frees the buffer of the ring.
+		 */
+		~RingMesh();
+		/** This function draws both sides of the ring as a triangle strip with texture coordinates.
+		 */
+		void draw() const;
+
+	private:
+		// the buffer can't be shared by copies
+		RingMesh( RingMesh const& );
+		RingMesh& operator=( RingMesh const& );
+
+		GLuint	mVertexBuffer_;		//!< The Vertex Buffer Object of the vertices (GL_T2F_V3F)
+		bool	mUseVBO_;			//!< If false the vertices are kept in client memory
+		std::vector< float > mVertices_;	//!< The vertices if no Vertex Buffer Objects are supported
+		GLsizei mVertexCount_;		//!< The number of vertices of the strip
+};
+
+#endif
@@ -0,0 +1,688 @@
+#include <SceneGraph.h>
+#include <TextureManager.h>
+#include <GLStateCache.h>
+#include <Profiler.h>
+#include <HashMap.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+static double const DEG_TO_RAD = M_PI / 180.0;
+// the size of the layers of the packed surfaces, most maps are equirectangular images of 1024x512 pixels
+static unsigned const LAYER_WIDTH = 1024;
+static unsigned const LAYER_HEIGHT = 512;
+
+/** This helper parses a number and fails on trailing characters.
+ */
+static bool parseNumber( std::string const& text, float& value ) {
+	std::istringstream in( text );
+	in >> value;
+	return !in.fail() && in.eof();
+}
+
+/** This helper returns a pseudo random number in [0,1), so the belts are the same on every start.
+ */
+static double nextRandom( unsigned& state ) {
+	state = state * 1664525u + 1013904223u;
+	return ( state >> 8 ) / 16777216.0;
+}
+
+/** This helper sorts the bodies by the number of their ancestors.
+ */
+struct ByDepth {
+	template< class T >
+	bool operator()( T const& lhs, T const& rhs ) const { return lhs.depth < rhs.depth; }
+};
+
+SceneGraph::SceneGraph() :
+	mVisibleCount_(0),
+	mSurfaceArray_(NULL),
+	mInstancer_(NULL),
+	mViewDistance_(100.0f),
+	mViewPitch_(20.0f),
+	mTimeScale_(10.0f) {
+}
+
+bool
+SceneGraph::load( std::string const& filename, std::string& error ) {
+	PROFILE_ZONE( "SceneGraph::load" );
+	clear();
+	std::ifstream file( filename.c_str() );
+	if( !file ) {
+		error = "Could not open the scene '" + filename + "'.";
+		return false;
+	}
+	std::vector< BodyDesc > bodies;
+	std::string text;
+	for( unsigned lineNumber = 1; std::getline( file, text ); ++lineNumber ) {
+		std::string::size_type comment = text.find( '#' );
+		if( comment != std::string::npos )
+			text.erase( comment );
+		std::istringstream line( text );
+		std::string type, name;
+		if( !( line >> type ) )
+			continue;
+		bool ok = true;
+		if( type == "body" && line >> name ) {
+			BodyDesc body;
+			body.name = name;
+			ok = parseBody( line, body, error );
+			bodies.push_back( body );
+		}
+		else if( type == "belt" && line >> name )
+			ok = parseBelt( line, name, bodies, error );
+		else if( type == "view" ) {
+			std::string pair;
+			while( ok && line >> pair ) {
+				std::string::size_type eq = pair.find( '=' );
+				std::string key = pair.substr( 0, eq );
+				float value = 0.0f;
+				ok = eq != std::string::npos && parseNumber( pair.substr( eq + 1 ), value );
+				if( ok && key == "distance" )
+					mViewDistance_ = value;
+				else if( ok && key == "pitch" )
+					mViewPitch_ = value;
+				else if( ok && key == "speed" )
+					mTimeScale_ = value;
+				else
+					ok = false;
+				if( !ok )
+					error = "invalid view setting '" + pair + "'";
+			}
+		}
+		else {
+			ok = false;
+			error = "unknown line '" + type + "'";
+		}
+		if( !ok ) {
+			std::ostringstream message;
+			message << filename << ":" << lineNumber << ": " << error;
+			error = message.str();
+			return false;
+		}
+	}
+
+	// the parents have to be found by their names, before the order changes
+	std::tr1::unordered_map< std::string, unsigned > index;
+	for( unsigned i = 0; i < bodies.size(); ++i ) {
+		if( !index.insert( std::make_pair( bodies[i].name, i ) ).second ) {
+			error = filename + ": The body '" + bodies[i].name + "' is defined twice.";
+			return false;
+		}
+	}
+	for( unsigned i = 0; i < bodies.size(); ++i ) {
+		unsigned depth = 0;
+		for( std::string parent = bodies[i].parent; !parent.empty(); parent = bodies[index[parent]].parent ) {
+			if( index.find( parent ) == index.end() ) {
+				error = filename + ": The parent '" + parent + "' of '" + bodies[i].name + "' does not exist.";
+				return false;
+			}
+			if( ++depth > bodies.size() ) {
+				error = filename + ": The parents of '" + bodies[i].name + "' form a cycle.";
+				return false;
+			}
+		}
+		bodies[i].depth = depth;
+	}
+	// the parents come first, so update() can compute every body from an already updated parent
+	std::stable_sort( bodies.begin(), bodies.end(), ByDepth() );
+	build( bodies );
+	update( 0.0 );
+	LOG_INFO( RENDER, "SceneGraph: Loaded " << bodies.size() << " bodies from '" << filename << "'." );
+	return true;
+}
+
+bool
+SceneGraph::parseBody( std::istream& line, BodyDesc& body, std::string& error ) {
+	body.radius = 1.0f;
+	body.tilt = 0.0f;
+	body.day = 0.0f;
+	for( unsigned i = 0; i < 6; ++i )
+		body.orbit[i] = 0.0f;
+	body.year = 0.0f;
+	body.ringInner = 0.0f;
+	body.ringOuter = 0.0f;
+	body.emissive = false;
+	body.detail = 64;
+	body.depth = 0;
+
+	char const* const orbitKeys[6] = { "orbit", "ecc", "incl", "node", "peri", "anomaly" };
+	std::string pair;
+	while( line >> pair ) {
+		std::string::size_type eq = pair.find( '=' );
+		if( eq == std::string::npos ) {
+			error = "expected key=value instead of '" + pair + "'";
+			return false;
+		}
+		std::string key = pair.substr( 0, eq );
+		std::string text = pair.substr( eq + 1 );
+		if( key == "parent" )
+			body.parent = text;
+		else if( key == "texture" )
+			body.texture = text;
+		else if( key == "clouds" )
+			body.clouds = text;
+		else if( key == "ring_texture" )
+			body.ringTexture = text;
+		else {
+			float value = 0.0f;
+			if( !parseNumber( text, value ) ) {
+				error = "'" + text + "' is not a number";
+				return false;
+			}
+			float* number = NULL;
+			for( unsigned i = 0; i < 6; ++i )
+				if( key == orbitKeys[i] )
+					number = &body.orbit[i];
+			if( key == "radius" )
+				number = &body.radius;
+			else if( key == "tilt" )
+				number = &body.tilt;
+			else if( key == "day" )
+				number = &body.day;
+			else if( key == "year" )
+				number = &body.year;
+			else if( key == "ring_inner" )
+				number = &body.ringInner;
+			else if( key == "ring_outer" )
+				number = &body.ringOuter;
+			else if( key == "emissive" )
+				body.emissive = ( value != 0.0f );
+			else if( key == "detail" )
+				body.detail = std::max( 4u, (unsigned)value );
+			else if( number == NULL ) {
+				error = "unknown key '" + key + "'";
+				return false;
+			}
+			if( number != NULL )
+				*number = value;
+		}
+	}
+	return true;
+}
+
+bool
+SceneGraph::parseBelt( std::istream& line, std::string const& name, std::vector< BodyDesc >& bodies, std::string& error ) {
+	std::string parent, texture;
+	float count = 0.0f, inner = 0.0f, outer = 0.0f, year = 0.0f, radius = 0.1f;
+	float maxEcc = 0.1f, maxIncl = 5.0f, seed = 1.0f, detail = 12.0f;
+	std::string pair;
+	while( line >> pair ) {
+		std::string::size_type eq = pair.find( '=' );
+		std::string key = pair.substr( 0, eq );
+		std::string text = ( eq != std::string::npos ) ? pair.substr( eq + 1 ) : "";
+		float value = 0.0f;
+		bool number = parseNumber( text, value );
+		if( key == "parent" )
+			parent = text;
+		else if( key == "texture" )
+			texture = text;
+		else if( !number ) {
+			error = "invalid belt setting '" + pair + "'";
+			return false;
+		}
+		else if( key == "count" )
+			count = value;
+		else if( key == "inner" )
+			inner = value;
+		else if( key == "outer" )
+			outer = value;
+		else if( key == "year" )
+			year = value;
+		else if( key == "radius" )
+			radius = value;
+		else if( key == "ecc" )
+			maxEcc = value;
+		else if( key == "incl" )
+			maxIncl = value;
+		else if( key == "seed" )
+			seed = value;
+		else if( key == "detail" )
+			detail = value;
+		else {
+			error = "unknown key '" + key + "'";
+			return false;
+		}
+	}
+	if( count < 1.0f || inner <= 0.0f || outer < inner ) {
+		error = "a belt needs a count and 0 < inner <= outer";
+		return false;
+	}
+
+	unsigned state = (unsigned)seed;
+	for( unsigned i = 0; i < (unsigned)count; ++i ) {
+		BodyDesc body;
+		std::ostringstream bodyName;
+		bodyName << name << i;
+		std::istringstream none( "" );
+		parseBody( none, body, error );
+		body.name = bodyName.str();
+		body.parent = parent;
+		body.texture = texture;
+		body.detail = std::max( 4u, (unsigned)detail );
+		body.radius = radius * (float)( 0.3 + 0.7 * nextRandom( state ) );
+		body.day = (float)( 0.2 + 2.0 * nextRandom( state ) );
+		body.tilt = (float)( 180.0 * nextRandom( state ) );
+		body.orbit[0] = inner + ( outer - inner ) * (float)nextRandom( state );
+		body.orbit[1] = maxEcc * (float)nextRandom( state );
+		body.orbit[2] = maxIncl * (float)( 2.0 * nextRandom( state ) - 1.0 );
+		for( unsigned k = 3; k < 6; ++k )
+			body.orbit[k] = (float)( 360.0 * nextRandom( state ) );
+		// Kepler's third law: the square of the period grows with the cube of the semi-major axis
+		body.year = year * (float)std::pow( body.orbit[0] / inner, 1.5f );
+		bodies.push_back( body );
+	}
+	return true;
+}
+
+void
+SceneGraph::build( std::vector< BodyDesc > const& bodies ) {
+	unsigned n = (unsigned)bodies.size();
+	std::tr1::unordered_map< std::string, int > index;
+	for( unsigned i = 0; i < n; ++i )
+		index[bodies[i].name] = (int)i;
+
+	mParents_.resize( n );
+	mOrbits_.resize( n );
+	mTilts_.resize( n * 2 );
+	mSpins_.resize( n );
+	mPositionsX_.assign( n, 0.0f );
+	mPositionsY_.assign( n, 0.0f );
+	mPositionsZ_.assign( n, 0.0f );
+	mMatrices_.assign( n * 16, 0.0f );
+	mBounds_.resize( n );
+	// everything is drawn until the first cull()
+	mVisible_.assign( n, 1 );
+	mVisibleCount_ = n;
+	mRadii_.resize( n );
+	mLODs_.resize( n );
+	mLevels_.assign( n, 0 );
+	mEmissive_.resize( n );
+	mSurfaceNames_.resize( n );
+	mTextures_.assign( n, (Texture*)NULL );
+	mLayers_.assign( n, -1.0f );
+	mCloudTextures_.assign( n, (Texture*)NULL );
+	mRings_.assign( n, (RingMesh*)NULL );
+	mRingTextures_.assign( n, (Texture*)NULL );
+	mNames_.resize( n );
+
+	TextureManager* tm = TextureManager::getSingletonPtr();
+	for( unsigned i = 0; i < n; ++i ) {
+		BodyDesc const& body = bodies[i];
+		mParents_[i] = body.parent.empty() ? -1 : index[body.parent];
+
+		OrbitElements& o = mOrbits_[i];
+		float e = std::min( std::max( body.orbit[1], 0.0f ), 0.99f );
+		o.semiMajorAxis = body.orbit[0];
+		o.semiMinorAxis = body.orbit[0] * std::sqrt( 1.0f - e * e );
+		o.eccentricity = e;
+		o.meanMotion = ( body.year != 0.0f ) ? (float)( 2.0 * M_PI / body.year ) : 0.0f;
+		o.meanAnomaly = (float)( body.orbit[5] * DEG_TO_RAD );
+		// the orbital plane in ecliptic coordinates (z points north) ...
+		double ci = std::cos( body.orbit[2] * DEG_TO_RAD ), si = std::sin( body.orbit[2] * DEG_TO_RAD );
+		double cn = std::cos( body.orbit[3] * DEG_TO_RAD ), sn = std::sin( body.orbit[3] * DEG_TO_RAD );
+		double cp = std::cos( body.orbit[4] * DEG_TO_RAD ), sp = std::sin( body.orbit[4] * DEG_TO_RAD );
+		double p[3] = { cp * cn - sp * ci * sn, cp * sn + sp * ci * cn, sp * si };
+		double q[3] = { -sp * cn - cp * ci * sn, -sp * sn + cp * ci * cn, cp * si };
+		// ... turned into OpenGL coordinates, where y points north
+		o.periapsis[0] = (float)p[0];
+		o.periapsis[1] = (float)p[2];
+		o.periapsis[2] = (float)-p[1];
+		o.normal[0] = (float)q[0];
+		o.normal[1] = (float)q[2];
+		o.normal[2] = (float)-q[1];
+
+		mTilts_[i * 2] = (float)std::cos( body.tilt * DEG_TO_RAD );
+		mTilts_[i * 2 + 1] = (float)std::sin( body.tilt * DEG_TO_RAD );
+		mSpins_[i] = ( body.day != 0.0f ) ? (float)( 2.0 * M_PI / body.day ) : 0.0f;
+
+		mRadii_[i] = body.radius;
+		// the clouds are drawn a little above the surface (see drawTranslucent()), the rings may reach further
+		mBounds_[i] = std::max( body.radius * 1.02f, body.ringOuter );
+		SphereLOD*& lod = mLadders_[body.detail];
+		if( lod == NULL )
+			lod = new SphereLOD( body.detail );
+		mLODs_[i] = lod;
+		mEmissive_[i] = body.emissive ? 1 : 0;
+		mNames_[i] = body.name;
+		mSurfaceNames_[i] = body.texture;
+		if( !body.clouds.empty() )
+			mCloudTextures_[i] = tm->loadTextureAsync( body.clouds, GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR );
+		if( body.ringOuter > body.ringInner && body.ringInner > 0.0f ) {
+			mRings_[i] = new RingMesh( body.ringInner, body.ringOuter );
+			if( !body.ringTexture.empty() )
+				mRingTextures_[i] = tm->loadTextureAsync( body.ringTexture, GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR );
+		}
+	}
+	loadSurfaces();
+}
+
+bool
+SceneGraph::isPackingSurfaces() const {
+	return mInstancer_ != NULL && mInstancer_->isTextureArraySupported() && TextureManager::getSingletonPtr()->isTextureArraySupported();
+}
+
+void
+SceneGraph::loadSurfaces() {
+	TextureManager* tm = TextureManager::getSingletonPtr();
+	unsigned n = (unsigned)mSurfaceNames_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		tm->deleteTexture( mTextures_[i] );
+		mTextures_[i] = NULL;
+		mLayers_[i] = -1.0f;
+	}
+	tm->deleteTexture( mSurfaceArray_ );
+	mSurfaceArray_ = NULL;
+
+	if( isPackingSurfaces() ) {
+		// one layer per image, the bodies sharing an image share the layer
+		std::vector< std::string > images;
+		std::map< std::string, unsigned > layers;
+		for( unsigned i = 0; i < n; ++i ) {
+			if( mSurfaceNames_[i].empty() )
+				continue;
+			std::map< std::string, unsigned >::iterator it = layers.find( mSurfaceNames_[i] );
+			if( it == layers.end() ) {
+				it = layers.insert( std::make_pair( mSurfaceNames_[i], (unsigned)images.size() ) ).first;
+				images.push_back( mSurfaceNames_[i] );
+			}
+			mLayers_[i] = (float)it->second;
+		}
+		if( images.empty() )
+			return;
+		mSurfaceArray_ = tm->loadTextureArray( images, LAYER_WIDTH, LAYER_HEIGHT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR );
+		if( mSurfaceArray_ != NULL )
+			return;
+		// too many images for the layers of the machine, load them one by one instead
+		mLayers_.assign( n, -1.0f );
+	}
+	// bodies sharing an image share the texture
+	for( unsigned i = 0; i < n; ++i )
+		if( !mSurfaceNames_[i].empty() )
+			mTextures_[i] = tm->loadTextureAsync( mSurfaceNames_[i], GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR );
+}
+
+void
+SceneGraph::update( double days ) {
+	PROFILE_ZONE( "SceneGraph::update" );
+	unsigned n = (unsigned)mParents_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		OrbitElements const& o = mOrbits_[i];
+		float position[3] = { 0.0f, 0.0f, 0.0f };
+		if( o.semiMajorAxis > 0.0f ) {
+			// solve Kepler's equation M = E - e sin E for the eccentric anomaly E with Newton's method
+			double m = std::fmod( o.meanAnomaly + o.meanMotion * days, 2.0 * M_PI );
+			double e = o.eccentricity;
+			double ea = m + e * std::sin( m );
+			for( unsigned k = 0; k < 4; ++k )
+				ea -= ( ea - e * std::sin( ea ) - m ) / ( 1.0 - e * std::cos( ea ) );
+			float u = o.semiMajorAxis * (float)( std::cos( ea ) - e );
+			float v = o.semiMinorAxis * (float)std::sin( ea );
+			for( unsigned k = 0; k < 3; ++k )
+				position[k] = o.periapsis[k] * u + o.normal[k] * v;
+		}
+		// the parent was updated before
+		int parent = mParents_[i];
+		if( parent >= 0 ) {
+			position[0] += mPositionsX_[parent];
+			position[1] += mPositionsY_[parent];
+			position[2] += mPositionsZ_[parent];
+		}
+		mPositionsX_[i] = position[0];
+		mPositionsY_[i] = position[1];
+		mPositionsZ_[i] = position[2];
+
+		// translation * tilt (about z) * spin (about y) * the turn of the sphere's poles from z to y (see RenderEngine)
+		double spin = std::fmod( mSpins_[i] * days, 2.0 * M_PI );
+		float cs = (float)std::cos( spin ), ss = (float)std::sin( spin );
+		float ct = mTilts_[i * 2], st = mTilts_[i * 2 + 1];
+		float* m = &mMatrices_[i * 16];
+		m[0] = ct * cs;	m[4] = ct * ss;	m[8] = st;		m[12] = position[0];
+		m[1] = st * cs;	m[5] = st * ss;	m[9] = -ct;		m[13] = position[1];
+		m[2] = -ss;		m[6] = cs;		m[10] = 0.0f;	m[14] = position[2];
+		m[3] = 0.0f;	m[7] = 0.0f;	m[11] = 0.0f;	m[15] = 1.0f;
+	}
+}
+
+unsigned
+SceneGraph::cull( Frustum const& frustum ) {
+	PROFILE_ZONE( "SceneGraph::cull" );
+	if( mVisible_.empty() )
+		return 0;
+	mVisibleCount_ = frustum.cullSpheres( &mPositionsX_[0], &mPositionsY_[0], &mPositionsZ_[0], &mBounds_[0],
+										  (unsigned)mVisible_.size(), &mVisible_[0] );
+	return mVisibleCount_;
+}
+
+unsigned
+SceneGraph::selectDetail( float const view[16], float pixelScale ) {
+	PROFILE_ZONE( "SceneGraph::selectDetail" );
+	unsigned triangles = 0;
+	unsigned n = (unsigned)mVisible_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		if( !mVisible_[i] )
+			continue;
+		float center[3] = { mPositionsX_[i], mPositionsY_[i], mPositionsZ_[i] };
+		float pixels = SphereLOD::getProjectedRadius( view, center, mRadii_[i], pixelScale );
+		mLevels_[i] = (unsigned char)mLODs_[i]->selectLevel( pixels, mLevels_[i] );
+		unsigned sphere = mLODs_[i]->getMesh( mLevels_[i] )->getTriangleCount();
+		triangles += ( mCloudTextures_[i] != NULL ) ? 2 * sphere : sphere;
+	}
+	return triangles;
+}
+
+bool
+SceneGraph::setInstancing( bool enable ) {
+	if( !enable ) {
+		delete mInstancer_;
+		mInstancer_ = NULL;
+	}
+	else if( mInstancer_ == NULL ) {
+		mInstancer_ = new SphereInstancer();
+		if( !mInstancer_->init() ) {
+			delete mInstancer_;
+			mInstancer_ = NULL;
+		}
+	}
+	// the surfaces follow the way the bodies are drawn
+	if( isPackingSurfaces() != ( mSurfaceArray_ != NULL ) && !mSurfaceNames_.empty() )
+		loadSurfaces();
+	return mInstancer_ != NULL;
+}
+
+void
+SceneGraph::draw() const {
+	PROFILE_ZONE( "SceneGraph::draw" );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	float const ambient[4] = { 0.15f, 0.15f, 0.15f, 1.0f };
+	float const diffuse[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	float const specular[4] = { 0.1f, 0.1f, 0.1f, 1.0f };
+	float const black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float const white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	sc->material( GL_FRONT, GL_AMBIENT, ambient );
+	sc->material( GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse );
+	sc->material( GL_FRONT, GL_SPECULAR, specular );
+	sc->material( GL_FRONT_AND_BACK, GL_EMISSION, black );
+	glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+	glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
+	if( mInstancer_ != NULL ) {
+		drawInstanced();
+		return;
+	}
+
+	unsigned n = (unsigned)mParents_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		if( !mVisible_[i] )
+			continue;
+		// texturing stays enabled between the bodies, the cache filters the repeated enable of bind()
+		if( mTextures_[i] != NULL )
+			mTextures_[i]->bind();
+		else
+			sc->disable( GL_TEXTURE_2D );
+		if( mEmissive_[i] )
+			sc->material( GL_FRONT_AND_BACK, GL_EMISSION, white );
+		glPushMatrix();
+		glMultMatrixf( &mMatrices_[i * 16] );
+		mLODs_[i]->getMesh( mLevels_[i] )->draw( mRadii_[i] );
+		glPopMatrix();
+		if( mEmissive_[i] )
+			sc->material( GL_FRONT_AND_BACK, GL_EMISSION, black );
+	}
+	sc->disable( GL_TEXTURE_2D );
+}
+
+void
+SceneGraph::drawInstanced() const {
+	// sort the visible bodies into groups of the same sphere and surface (there is only one surface if they are packed)
+	mBatch_.clear();
+	unsigned n = (unsigned)mParents_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		if( !mVisible_[i] )
+			continue;
+		InstanceEntry entry;
+		entry.mesh = mLODs_[i]->getMesh( mLevels_[i] );
+		entry.texture = ( mSurfaceArray_ != NULL ) ? mSurfaceArray_ : mTextures_[i];
+		entry.body = i;
+		mBatch_.push_back( entry );
+	}
+	std::sort( mBatch_.begin(), mBatch_.end() );
+
+	mInstancer_->begin();
+	for( unsigned k = 0; k < mBatch_.size(); ++k ) {
+		unsigned body = mBatch_[k].body;
+		mInstancer_->add( &mMatrices_[body * 16], mRadii_[body], mEmissive_[body] ? 1.0f : 0.0f, mLayers_[body] );
+		// the group ends before the next sphere or surface
+		if( k + 1 == mBatch_.size() || mBatch_[k + 1].mesh != mBatch_[k].mesh || mBatch_[k + 1].texture != mBatch_[k].texture )
+			mInstancer_->draw( mBatch_[k].mesh, mBatch_[k].texture );
+	}
+	mInstancer_->end();
+	GLStateCache::getSingletonPtr()->disable( GL_TEXTURE_2D );
+}
+
+void
+SceneGraph::drawTranslucent() const {
+	PROFILE_ZONE( "SceneGraph::drawTranslucent" );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	float const clouds[4] = { 1.0f, 1.0f, 1.0f, 0.5f };
+	sc->material( GL_FRONT_AND_BACK, GL_DIFFUSE, clouds );
+	glColor4f( 1.0f, 1.0f, 1.0f, 0.8f );
+	unsigned n = (unsigned)mParents_.size();
+	for( unsigned i = 0; i < n; ++i ) {
+		if( !mVisible_[i] || ( mCloudTextures_[i] == NULL && mRings_[i] == NULL ) )
+			continue;
+		glPushMatrix();
+		glMultMatrixf( &mMatrices_[i * 16] );
+		if( mCloudTextures_[i] != NULL ) {
+			mCloudTextures_[i]->bind();
+			mLODs_[i]->getMesh( mLevels_[i] )->draw( mRadii_[i] * 1.02f );
+		}
+		if( mRings_[i] != NULL ) {
+			if( mRingTextures_[i] != NULL )
+				mRingTextures_[i]->bind();
+			else
+				sc->disable( GL_TEXTURE_2D );
+			mRings_[i]->draw();
+		}
+		glPopMatrix();
+	}
+	sc->disable( GL_TEXTURE_2D );
+}
+
+unsigned
+SceneGraph::getBodyCount() const {
+	return (unsigned)mParents_.size();
+}
+
+unsigned
+SceneGraph::getVisibleCount() const {
+	return mVisibleCount_;
+}
+
+unsigned
+SceneGraph::getDrawCount() const {
+	return ( mInstancer_ != NULL ) ? mInstancer_->getDrawCount() : mVisibleCount_;
+}
+
+void
+SceneGraph::getPosition( unsigned body, float position[3] ) const {
+	position[0] = mPositionsX_[body];
+	position[1] = mPositionsY_[body];
+	position[2] = mPositionsZ_[body];
+}
+
+std::string const&
+SceneGraph::getName( unsigned body ) const {
+	return mNames_[body];
+}
+
+int
+SceneGraph::getLightSource() const {
+	for( unsigned i = 0; i < mEmissive_.size(); ++i )
+		if( mEmissive_[i] )
+			return (int)i;
+	return -1;
+}
+
+float
+SceneGraph::getViewDistance() const {
+	return mViewDistance_;
+}
+
+float
+SceneGraph::getViewPitch() const {
+	return mViewPitch_;
+}
+
+float
+SceneGraph::getTimeScale() const {
+	return mTimeScale_;
+}
+
+void
+SceneGraph::clear() {
+	TextureManager* tm = TextureManager::getSingletonPtr();
+	for( unsigned i = 0; i < mParents_.size(); ++i ) {
+		tm->deleteTexture( mTextures_[i] );
+		tm->deleteTexture( mCloudTextures_[i] );
+		tm->deleteTexture( mRingTextures_[i] );
+		delete mRings_[i];
+	}
+	mParents_.clear();
+	mOrbits_.clear();
+	mTilts_.clear();
+	mSpins_.clear();
+	mPositionsX_.clear();
+	mPositionsY_.clear();
+	mPositionsZ_.clear();
+	mMatrices_.clear();
+	mBounds_.clear();
+	mVisible_.clear();
+	mVisibleCount_ = 0;
+	mRadii_.clear();
+	mLODs_.clear();
+	mLevels_.clear();
+	for( std::map< unsigned, SphereLOD* >::iterator it = mLadders_.begin(); it != mLadders_.end(); ++it )
+		delete it->second;
+	mLadders_.clear();
+	mEmissive_.clear();
+	tm->deleteTexture( mSurfaceArray_ );
+	mSurfaceArray_ = NULL;
+	mSurfaceNames_.clear();
+	mTextures_.clear();
+	mLayers_.clear();
+	mCloudTextures_.clear();
+	mRings_.clear();
+	mRingTextures_.clear();
+	mNames_.clear();
+}
+
+SceneGraph::~SceneGraph() {
+	clear();
+	delete mInstancer_;
+}
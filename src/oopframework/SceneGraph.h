@@ -0,0 +1,235 @@
+#ifndef SCENEGRAPH
+#define SCENEGRAPH
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+#include <Texture.h>
+#include <RingMesh.h>
+#include <SphereMesh.h>
+#include <Frustum.h>
+#include <SphereLOD.h>
+#include <SphereInstancer.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/** The orbit of a body around its parent, reduced to what the update needs every frame.
+ */
+struct OrbitElements {
+	float semiMajorAxis;	//!< The semi-major axis a, 0 for a body which doesn't move relative to its parent
+	float semiMinorAxis;	//!< The semi-minor axis b = a * sqrt( 1 - e^2 )
+	float eccentricity;		//!< The eccentricity e
+	float meanMotion;		//!< The change of the mean anomaly in radians per day
+	float meanAnomaly;		//!< The mean anomaly at the time 0 in radians
+	float periapsis[3];		//!< The unit vector towards the periapsis (P)
+	float normal[3];		//!< The unit vector in the orbital plane, 90 degrees ahead of P (Q)
+};
+
+/** This class holds a hierarchy of celestial bodies (stars, planets, moons, asteroids), loaded from a text file.
+ * Each line of the file describes one body with key=value pairs, '#' starts a comment:
+ * @code
+ * body Sun radius=8 texture=sunmap.jpg day=25.38 tilt=7.25 emissive=1
+ * body Earth parent=Sun radius=1 texture=earthmap1k.jpg clouds=earth_clouds_1k.jpg orbit=30 ecc=0.0167 year=365.26
+ * body Saturn parent=Sun radius=3.4 orbit=100 year=10759 ring_inner=4.2 ring_outer=7.7 ring_texture=saturnringcolor.jpg
+ * belt Asteroid parent=Sun count=2000 inner=46 outer=60 year=1700 radius=0.1 texture=moonmap1k.jpg seed=7
+ * view distance=120 pitch=25 speed=20
+ * @endcode
+ * The further keys of a body are tilt, day, incl, node, peri, anomaly and detail (the slices and stacks of the
+ * finest level of detail). The angles of the orbits (incl, node, peri, anomaly) and the tilt are given in degrees,
+ * the periods (day, year) in days, a negative day spins retrograde. A belt generates count small bodies on
+ * random orbits between inner and outer, their periods follow Kepler's third law from the year at the inner edge.
+ * The view line sets the start of the camera and how many days pass per second.
+ *
+ * The bodies are stored as flat arrays (structure of arrays) and sorted so every parent comes before its children.
+ * update() therefore computes all positions and model matrices in a single pass over contiguous memory, which
+ * keeps systems with thousands of bodies cheap. The names, textures and rings are only touched by draw().
+ * The positions are stored as one array per coordinate, so cull() can test the bounding spheres of the bodies in
+ * SIMD batches (see Frustum). The draw functions skip the culled bodies.
+ * The tessellation of every visible body is chosen by its size on the screen (see SphereLOD).
+ * With instancing (see setInstancing()) the visible bodies are grouped by their sphere and surface and every group
+ * is drawn with a single call, so a belt of thousands of asteroids costs a handful of draw calls instead of one each.
+ * If the machine supports array textures, the surfaces are packed into one of them as well: every body samples its own
+ * layer, so the groups only depend on the spheres and the surfaces are bound once per frame, whatever the number of bodies.
+ * @brief A data-driven solar system.
+ */
+class SceneGraph {
+	public:
+		/** Creates an empty scene.
+		 */
+		SceneGraph();
+		/** Releases the textures and the rings of all bodies.
+		 */
+		~SceneGraph();
+		/** This function loads the bodies from a file and starts the decoding of their textures.
+		 * @param filename The path of the file.
+		 * @param error The reason of a failure.
+		 * @return true if the file was loaded. On failure the scene stays empty.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		bool load( std::string const& filename, std::string& error );
+		/** This function computes the positions and model matrices of all bodies at a point in time.
+		 * @param days The time since the epoch of the orbital elements in days.
+		 */
+		void update( double days );
+		/** This function tests the bounding spheres of all bodies (including their clouds and rings) against the
+		 * view frustum. It has to be called after update(), the culled bodies aren't drawn until the next call.
+		 * @param frustum The frustum in the coordinates of the scene.
+		 * @return The number of bodies which may be visible.
+		 */
+		unsigned cull( Frustum const& frustum );
+		/** This function selects the level of detail of every visible body. It has to be called after cull().
+		 * @param view The column major camera matrix, which transforms the scene into eye coordinates.
+		 * @param pixelScale The pixels per unit at the distance 1 (see SphereLOD::getPixelScale()).
+		 * @return The number of triangles the next draw() and drawTranslucent() will draw.
+		 */
+		unsigned selectDetail( float const view[16], float pixelScale );
+		/** This function selects how draw() renders the bodies.
+		 * The surfaces of a loaded scene are reloaded, if they have to be packed into an array texture or unpacked again.
+		 * @param enable If true, the bodies are drawn instanced (see SphereInstancer), else one by one.
+		 * @return true if the bodies are drawn instanced, false if disabled or not supported by the machine.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		bool setInstancing( bool enable );
+		/** This function draws the opaque parts of all bodies with the modelview matrix of the camera.
+		 */
+		void draw() const;
+		/** This function draws the clouds and the rings, after everything opaque (including the sky) was drawn.
+		 */
+		void drawTranslucent() const;
+
+		/** Get the number of bodies.
+		 * @return The number of bodies, including the generated ones of the belts.
+		 */
+		unsigned getBodyCount() const;
+		/** Get the number of bodies which passed the last cull().
+		 * @return The number of bodies drawn.
+		 */
+		unsigned getVisibleCount() const;
+		/** Get the number of draw calls of the last draw().
+		 * @return The number of instanced draw calls, or the number of visible bodies if they are drawn one by one.
+		 */
+		unsigned getDrawCount() const;
+		/** Get the position of a body after the last update().
+		 * @param body The number of the body.
+		 * @param position Receives the x, y and z coordinate.
+		 */
+		void getPosition( unsigned body, float position[3] ) const;
+		/** Get the name of a body.
+		 * @param body The number of the body.
+		 * @return The name given in the file.
+		 */
+		std::string const& getName( unsigned body ) const;
+		/** Get the first emissive body, which is used as the light source.
+		 * @return The number of the body, -1 if there is none.
+		 */
+		int getLightSource() const;
+		/** Get the distance of the camera from the root of the scene.
+		 */
+		float getViewDistance() const;
+		/** Get the angle the camera looks down onto the plane of the orbits, in degrees.
+		 */
+		float getViewPitch() const;
+		/** Get the speed of the simulation.
+		 * @return The number of days which pass per second.
+		 */
+		float getTimeScale() const;
+
+	private:
+		/** The description of one body while the file is parsed.
+		 */
+		struct BodyDesc {
+			std::string name;		//!< The name of the body
+			std::string parent;		//!< The name of the parent, empty for a root
+			float radius;			//!< The radius
+			float tilt;				//!< The axial tilt in degrees
+			float day;				//!< The rotation period in days
+			float orbit[6];			//!< a, e, i, node, peri and anomaly (angles in degrees)
+			float year;				//!< The orbital period in days
+			std::string texture;	//!< The image of the surface
+			std::string clouds;		//!< The image of the clouds, may be empty
+			float ringInner;		//!< The inner radius of the rings, 0 if there are none
+			float ringOuter;		//!< The outer radius of the rings
+			std::string ringTexture;//!< The image of the rings
+			bool emissive;			//!< If true the body shines itself
+			unsigned detail;		//!< The slices and stacks of the finest sphere
+			unsigned depth;			//!< The number of ancestors
+		};
+		/** A visible body in the order of the instanced draw calls.
+		 */
+		struct InstanceEntry {
+			SphereMesh* mesh;		//!< The sphere of the selected level of detail
+			Texture* texture;		//!< The surface
+			unsigned body;			//!< The number of the body
+			bool operator<( InstanceEntry const& rhs ) const {
+				return ( mesh != rhs.mesh ) ? mesh < rhs.mesh : texture < rhs.texture;
+			}
+		};
+
+		// the textures and meshes can't be shared by copies
+		SceneGraph( SceneGraph const& );
+		SceneGraph& operator=( SceneGraph const& );
+
+		/** This function parses the key=value pairs of a body or belt line.
+		 * @return false if a key is unknown or a value isn't a number.
+		 */
+		static bool parseBody( std::istream& line, BodyDesc& body, std::string& error );
+		/** This function adds the bodies of a belt.
+		 * @return false if the line is malformed.
+		 */
+		static bool parseBelt( std::istream& line, std::string const& name, std::vector< BodyDesc >& bodies, std::string& error );
+		/** This function creates the arrays from the descriptions, which are sorted by their depth.
+		 */
+		void build( std::vector< BodyDesc > const& bodies );
+		/** This function draws the opaque parts of the visible bodies grouped by their sphere and surface.
+		 */
+		void drawInstanced() const;
+		/** This function tells whether the surfaces have to be packed into an array texture.
+		 * @return true if the bodies are drawn instanced and the machine supports array textures.
+		 */
+		bool isPackingSurfaces() const;
+		/** This function releases the surfaces of all bodies and loads them again, packed or one by one (see isPackingSurfaces()).
+		 */
+		void loadSurfaces();
+		/** This function releases all bodies.
+		 */
+		void clear();
+
+		// the data of update(), one entry per body in the order parents first
+		std::vector< int > mParents_;				//!< The parent of every body, -1 for a root
+		std::vector< OrbitElements > mOrbits_;		//!< The orbit of every body around its parent
+		std::vector< float > mTilts_;				//!< The cosine and sine of the axial tilt (2 per body)
+		std::vector< float > mSpins_;				//!< The rotation in radians per day
+		std::vector< float > mPositionsX_;			//!< The x coordinates of the positions
+		std::vector< float > mPositionsY_;			//!< The y coordinates of the positions
+		std::vector< float > mPositionsZ_;			//!< The z coordinates of the positions
+		std::vector< float > mMatrices_;			//!< The column major model matrices (16 per body)
+		// the data of cull()
+		std::vector< float > mBounds_;				//!< The radius of the bounding sphere of every body
+		std::vector< unsigned char > mVisible_;		//!< 1 for every body which passed the last cull()
+		unsigned mVisibleCount_;					//!< The number of bodies which passed the last cull()
+		// the data of draw()
+		std::vector< float > mRadii_;				//!< The radius of every body
+		std::vector< SphereLOD* > mLODs_;			//!< The spheres of every body
+		std::vector< unsigned char > mLevels_;		//!< The level of detail of every body
+		std::map< unsigned, SphereLOD* > mLadders_;	//!< The spheres by their finest detail, shared by the bodies
+		std::vector< char > mEmissive_;				//!< 1 for the bodies which shine themselves
+		std::vector< std::string > mSurfaceNames_;	//!< The image of the surface of every body, may be empty
+		std::vector< Texture* > mTextures_;			//!< The surface of every body, may be NULL (always NULL if packed)
+		std::vector< float > mLayers_;				//!< The layer of the surface of every body in mSurfaceArray_, -1 for none
+		Texture* mSurfaceArray_;					//!< The surfaces packed into an array texture, NULL if loaded one by one
+		std::vector< Texture* > mCloudTextures_;	//!< The clouds of every body, may be NULL
+		std::vector< RingMesh* > mRings_;			//!< The rings of every body, may be NULL
+		std::vector< Texture* > mRingTextures_;		//!< The texture of the rings, may be NULL
+		std::vector< std::string > mNames_;			//!< The name of every body
+		SphereInstancer* mInstancer_;				//!< The instanced drawing, NULL draws the bodies one by one
+		mutable std::vector< InstanceEntry > mBatch_;	//!< The visible bodies sorted into draw calls
+
+		float mViewDistance_;	//!< The distance of the camera
+		float mViewPitch_;		//!< The pitch of the camera in degrees
+		float mTimeScale_;		//!< The days per second
+};
+
+#endif
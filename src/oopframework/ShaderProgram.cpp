@@ -0,0 +1,95 @@
+#include <ShaderProgram.h>
+
+#include <vector>
+
+bool
+ShaderProgram::isSupported() {
+	return GLEW_VERSION_2_0 != GL_FALSE;
+}
+
+ShaderProgram*
+ShaderProgram::create( std::string const& name, char const* vertexSource, char const* fragmentSource ) {
+	if( !isSupported() ) {
+		LOG_WARNING( RENDER, "ShaderProgram: GLSL is not supported, '" << name << "' is unavailable." );
+		return NULL;
+	}
+	GLuint vertex = compile( name, GL_VERTEX_SHADER, vertexSource );
+	GLuint fragment = compile( name, GL_FRAGMENT_SHADER, fragmentSource );
+	if( vertex == 0 || fragment == 0 ) {
+		glDeleteShader( vertex );
+		glDeleteShader( fragment );
+		return NULL;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader( program, vertex );
+	glAttachShader( program, fragment );
+	glLinkProgram( program );
+	// the shaders are deleted together with the program
+	glDeleteShader( vertex );
+	glDeleteShader( fragment );
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if( linked != GL_TRUE ) {
+		GLint length = 0;
+		glGetProgramiv( program, GL_INFO_LOG_LENGTH, &length );
+		std::vector< GLchar > log( length + 1, '\0' );
+		if( length > 0 )
+			glGetProgramInfoLog( program, length, NULL, &log[0] );
+		LOG_ERROR( RENDER, "ShaderProgram: Could not link '" << name << "': " << &log[0] );
+		glDeleteProgram( program );
+		return NULL;
+	}
+	LOG_INFO( RENDER, "ShaderProgram: Linked '" << name << "'." );
+	return new ShaderProgram( name, program );
+}
+
+GLuint
+ShaderProgram::compile( std::string const& name, GLenum type, char const* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, NULL );
+	glCompileShader( shader );
+	GLint compiled = GL_FALSE;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+	if( compiled != GL_TRUE ) {
+		GLint length = 0;
+		glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &length );
+		std::vector< GLchar > log( length + 1, '\0' );
+		if( length > 0 )
+			glGetShaderInfoLog( shader, length, NULL, &log[0] );
+		LOG_ERROR( RENDER, "ShaderProgram: Could not compile the " << ( type == GL_VERTEX_SHADER ? "vertex" : "fragment" )
+						   << " shader of '" << name << "': " << &log[0] );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+ShaderProgram::ShaderProgram( std::string const& name, GLuint program ) :
+	mName_(name),
+	mProgram_(program) {
+}
+
+void
+ShaderProgram::bind() const {
+	glUseProgram( mProgram_ );
+}
+
+void
+ShaderProgram::unbind() const {
+	glUseProgram( 0 );
+}
+
+GLint
+ShaderProgram::getUniform( char const* uniform ) const {
+	return glGetUniformLocation( mProgram_, uniform );
+}
+
+std::string const&
+ShaderProgram::getName() const {
+	return mName_;
+}
+
+ShaderProgram::~ShaderProgram() {
+	glDeleteProgram( mProgram_ );
+}
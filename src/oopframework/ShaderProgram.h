@@ -0,0 +1,76 @@
+#ifndef SHADERPROGRAM
+#define SHADERPROGRAM
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+
+#include <string>
+
+/** This class holds a GLSL program built from a vertex and a fragment shader.
+ * The sources are compiled and linked by create(), which logs the info log of the driver and returns NULL if
+ * anything fails, so the caller can fall back to the fixed function pipeline. The fixed function state
+ * (matrices, lights, materials) stays available to the shaders through the built-in uniforms of GLSL 1.20.
+ * @brief A linked GLSL program.
+ * @code
+ * ShaderProgram* program = ShaderProgram::create( "earth", vertexSource, fragmentSource );
+ * if( program != NULL ) {
+ *     program->bind();
+ *     glUniform1i( program->getUniform( "surface" ), 0 );
+ *     drawEarth();
+ *     program->unbind();
+ * }
+ * delete program;
+ * @endcode
+ */
+class ShaderProgram {
+	public:
+		/** This function tells whether the machine can run GLSL programs.
+		 * @return true if OpenGL 2.0 is supported.
+		 */
+		static bool isSupported();
+		/** This function compiles and links a program.
+		 * @param name The name of the program in the log.
+		 * @param vertexSource The source of the vertex shader.
+		 * @param fragmentSource The source of the fragment shader.
+		 * @return The program or NULL if GLSL is not supported or a shader doesn't compile or link.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		static ShaderProgram* create( std::string const& name, char const* vertexSource, char const* fragmentSource );
+		/** Deletes the program. The OpenGL context has to be current.
+		 */
+		~ShaderProgram();
+		/** This function makes the program current.
+		 */
+		void bind() const;
+		/** This function returns to the fixed function pipeline.
+		 */
+		void unbind() const;
+		/** Get the location of a uniform.
+		 * @param uniform The name of the uniform.
+		 * @return The location, -1 if the program has no such (active) uniform. glUniform ignores -1.
+		 */
+		GLint getUniform( char const* uniform ) const;
+		/** Get the name of the program.
+		 */
+		std::string const& getName() const;
+
+	private:
+		/** Creates the program from the linked handle.
+		 */
+		ShaderProgram( std::string const& name, GLuint program );
+		// the program can't be shared by copies
+		ShaderProgram( ShaderProgram const& );
+		ShaderProgram& operator=( ShaderProgram const& );
+
+		/** This internal function compiles one shader.
+		 * @return The shader or 0 on failure (the info log is logged).
+		 */
+		static GLuint compile( std::string const& name, GLenum type, char const* source );
+
+		std::string mName_;	//!< The name of the program
+		GLuint mProgram_;	//!< The linked program
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <Skybox.h>
+#include <GLStateCache.h>
+#include <Profiler.h>
+
+// the half edge length of the cube - it only has to lie between the near and the far plane
+static float const SKYBOX_SIZE = 10.0f;
+
+Skybox::Skybox() :
+	mVertexBuffer_(0),
+	mUseVBO_(false),
+	mVertexCount_(0) {
+	// the 8 corners and the 2 triangles of each of the 6 faces
+	float const corners[8][3] = {
+		{ -1.0f, -1.0f, -1.0f }, {  1.0f, -1.0f, -1.0f }, {  1.0f,  1.0f, -1.0f }, { -1.0f,  1.0f, -1.0f },
+		{ -1.0f, -1.0f,  1.0f }, {  1.0f, -1.0f,  1.0f }, {  1.0f,  1.0f,  1.0f }, { -1.0f,  1.0f,  1.0f }
+	};
+	unsigned const faces[6][4] = {
+		{ 1, 5, 6, 2 }, { 4, 0, 3, 7 },		// +X, -X
+		{ 3, 2, 6, 7 }, { 4, 5, 1, 0 },		// +Y, -Y
+		{ 5, 4, 7, 6 }, { 0, 1, 2, 3 }		// +Z, -Z
+	};
+	std::vector< float > vertices;
+	for( unsigned f = 0; f < 6; ++f ) {
+		unsigned const quad[6] = { faces[f][0], faces[f][1], faces[f][2], faces[f][0], faces[f][2], faces[f][3] };
+		for( unsigned v = 0; v < 6; ++v )
+			for( unsigned i = 0; i < 3; ++i )
+				vertices.push_back( corners[quad[v]][i] * SKYBOX_SIZE );
+	}
+	mVertexCount_ = (GLsizei)( vertices.size() / 3 );
+
+	mUseVBO_ = ( GLEW_VERSION_1_5 == GL_TRUE );
+	if( mUseVBO_ ) {
+		glGenBuffers( 1, &mVertexBuffer_ );
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glBufferData( GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		LOG_INFO( RENDER, "Skybox: Built the cube in a Vertex Buffer Object." );
+	}
+	else {
+		mVertices_.swap( vertices );
+		LOG_WARNING( RENDER, "Skybox: Vertex Buffer Objects are not supported. Built the cube in client memory." );
+	}
+}
+
+void
+Skybox::draw( Texture* cubeMap ) const {
+	PROFILE_ZONE( "Skybox::draw" );
+	if( cubeMap == NULL || cubeMap->getType() != GL_TEXTURE_CUBE_MAP )
+		return;
+	// keep the rotation of the camera only, so the sky is infinitely far away
+	GLfloat view[16];
+	glGetFloatv( GL_MODELVIEW_MATRIX, view );
+	view[12] = view[13] = view[14] = 0.0f;
+	glPushMatrix();
+	glLoadMatrixf( view );
+
+	// the enable bits are restored through the state cache, glPopAttrib() would pass them by it
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	GLenum const caps[4] = { GL_LIGHTING, GL_BLEND, GL_CULL_FACE, GL_POLYGON_SMOOTH };
+	bool enabled[4];
+	for( unsigned i = 0; i < 4; ++i ) {
+		enabled[i] = sc->isEnabled( caps[i] );
+		sc->disable( caps[i] );
+	}
+	glPushAttrib( GL_DEPTH_BUFFER_BIT | GL_CURRENT_BIT );
+	// every fragment lies on the far plane: it passes only where nothing was drawn before, and writes no depth
+	glDepthMask( GL_FALSE );
+	glDepthFunc( GL_LEQUAL );
+	glDepthRange( 1.0, 1.0 );
+	glColor3f( 1.0f, 1.0f, 1.0f );
+
+	cubeMap->bind();
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	if( mUseVBO_ ) {
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glVertexPointer( 3, GL_FLOAT, 0, 0 );
+		glTexCoordPointer( 3, GL_FLOAT, 0, 0 );
+	}
+	else {
+		glVertexPointer( 3, GL_FLOAT, 0, &mVertices_[0] );
+		glTexCoordPointer( 3, GL_FLOAT, 0, &mVertices_[0] );
+	}
+	glDrawArrays( GL_TRIANGLES, 0, mVertexCount_ );
+	if( mUseVBO_ )
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
+	cubeMap->unbind();
+
+	// the depth range is part of the viewport state, which isn't pushed
+	glDepthRange( 0.0, 1.0 );
+	glPopAttrib();
+	for( unsigned i = 0; i < 4; ++i ) {
+		if( enabled[i] )
+			sc->enable( caps[i] );
+	}
+	glPopMatrix();
+}
+
+Skybox::~Skybox() {
+	if( mUseVBO_ )
+		glDeleteBuffers( 1, &mVertexBuffer_ );
+}
@@ -0,0 +1,48 @@
+#ifndef SKYBOX
+#define SKYBOX
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Texture.h>
+#include <LogManager.h>
+
+#include <vector>
+
+/** This class draws a cube map around the camera. The cube is built once and drawn from a Vertex Buffer Object.
+ * The positions of the cube are used as the texture coordinates of the cube map, so no other attributes are needed.
+ * The sky is drawn at the far plane without writing depth. If it is drawn after the opaque objects, the depth test
+ * rejects the covered pixels early and only the visible background is shaded.
+ * @brief A cube mapped background.
+ * @code
+ * Skybox sky;
+ * // after the opaque objects, with the camera matrix on the modelview stack
+ * sky.draw( TextureManager::getSingletonPtr()->loadTextureAsync( "starmap_4k.jpg", GL_TEXTURE_CUBE_MAP ) );
+ * @endcode
+ */
+class Skybox {
+	public:
+		/** Creates the cube.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		Skybox();
+		/** Frees the buffer of the cube.
+		 */
+		~Skybox();
+		/** This function draws the sky. Only the rotation of the modelview matrix is used, the translation is removed.
+		 * @param cubeMap The cube map to draw. Nothing is drawn if it is NULL or not of the type GL_TEXTURE_CUBE_MAP.
+		 */
+		void draw( Texture* cubeMap ) const;
+
+	private:
+		// the buffer can't be shared by copies
+		Skybox( Skybox const& );
+		Skybox& operator=( Skybox const& );
+
+		GLuint	mVertexBuffer_;		//!< The Vertex Buffer Object of the positions
+		bool	mUseVBO_;			//!< If false the positions are kept in client memory
+		std::vector< float > mVertices_;	//!< The positions if no Vertex Buffer Objects are supported
+		GLsizei mVertexCount_;		//!< The number of vertices (two triangles per face)
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include <SphereInstancer.h>
+#include <GLStateCache.h>
+#include <LightingShader.h>
+#include <Profiler.h>
+
+// the unit of the instance buffer, the surface stays on unit 0 where Texture::bind() puts it
+static unsigned const INSTANCE_UNIT = 1;
+
+// the lines in front of LightingShader::LIGHTING_SOURCE
+static char const* VERTEX_HEADER =
+	"#version 120\n"
+	"#extension GL_EXT_gpu_shader4 : require\n";
+
+// places the instance by the texels of gl_InstanceID and lights it like the fixed function pipeline (per vertex, light 0)
+static char const* VERTEX_SHADER =
+	"uniform samplerBuffer instances;\n"
+	"varying vec4 color;\n"
+	"varying float layer;\n"
+	"void main() {\n"
+	"	int base = gl_InstanceID * 4;\n"
+	"	vec4 row0 = texelFetchBuffer( instances, base );\n"
+	"	vec4 row1 = texelFetchBuffer( instances, base + 1 );\n"
+	"	vec4 row2 = texelFetchBuffer( instances, base + 2 );\n"
+	"	vec4 extra = texelFetchBuffer( instances, base + 3 );\n"
+	"	vec4 position = vec4( dot( row0, gl_Vertex ), dot( row1, gl_Vertex ), dot( row2, gl_Vertex ), 1.0 );\n"
+	"	vec3 normal = vec3( dot( row0.xyz, gl_Normal ), dot( row1.xyz, gl_Normal ), dot( row2.xyz, gl_Normal ) );\n"
+	"	vec4 eye = gl_ModelViewMatrix * position;\n"
+	"	vec2 light = lightVertex( normalize( gl_NormalMatrix * normal ), eye, gl_LightSource[0].position,\n"
+	"							  gl_FrontMaterial.shininess );\n"
+	"	color = gl_FrontLightModelProduct.sceneColor + gl_FrontLightProduct[0].ambient\n"
+	"		  + light.x * gl_FrontLightProduct[0].diffuse + light.y * gl_FrontLightProduct[0].specular;\n"
+	"	color = clamp( vec4( color.rgb + vec3( extra.x ), gl_FrontMaterial.diffuse.a ), 0.0, 1.0 );\n"
+	"	layer = extra.y;\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * position;\n"
+	"}\n";
+
+// modulates the lit color with the surface, like GL_MODULATE
+static char const* FRAGMENT_SHADER =
+	"#version 120\n"
+	"uniform sampler2D surface;\n"
+	"uniform bool textured;\n"
+	"varying vec4 color;\n"
+	"void main() {\n"
+	"	gl_FragColor = textured ? color * texture2D( surface, gl_TexCoord[0].st ) : color;\n"
+	"}\n";
+
+// the same with the layer of the instance, a negative one leaves it untextured
+static char const* ARRAY_FRAGMENT_SHADER =
+	"#version 120\n"
+	"#extension GL_EXT_texture_array : require\n"
+	"uniform sampler2DArray surface;\n"
+	"uniform bool textured;\n"
+	"varying vec4 color;\n"
+	"varying float layer;\n"
+	"void main() {\n"
+	"	if( textured && layer >= 0.0 )\n"
+	"		gl_FragColor = color * texture2DArray( surface, vec3( gl_TexCoord[0].st, floor( layer + 0.5 ) ) );\n"
+	"	else\n"
+	"		gl_FragColor = color;\n"
+	"}\n";
+
+bool
+SphereInstancer::isSupported() {
+	return ShaderProgram::isSupported() && GLEW_EXT_draw_instanced && GLEW_EXT_gpu_shader4 && GLEW_EXT_texture_buffer_object;
+}
+
+SphereInstancer::SphereInstancer() :
+	mProgram_(NULL),
+	mArrayProgram_(NULL),
+	mCurrent_(NULL),
+	mTexturedUniform_(-1),
+	mArrayTexturedUniform_(-1),
+	mBuffer_(0),
+	mTexture_(0),
+	mMaxInstances_(0),
+	mDrawCount_(0) {
+}
+
+bool
+SphereInstancer::init() {
+	if( !isSupported() ) {
+		LOG_WARNING( RENDER, "SphereInstancer: Instancing from texture buffers is not supported, the spheres are drawn one by one." );
+		return false;
+	}
+	GLint maxTexels = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_BUFFER_SIZE_EXT, &maxTexels );
+	if( maxTexels < (GLint)TEXELS ) {
+		LOG_WARNING( RENDER, "SphereInstancer: The texture buffers are too small, the spheres are drawn one by one." );
+		return false;
+	}
+	mMaxInstances_ = (unsigned)maxTexels / TEXELS;
+	std::string vertex = std::string( VERTEX_HEADER ) + LightingShader::LIGHTING_SOURCE + VERTEX_SHADER;
+	mProgram_ = ShaderProgram::create( "SphereInstancer", vertex.c_str(), FRAGMENT_SHADER );
+	if( mProgram_ == NULL )
+		return false;
+	mProgram_->bind();
+	glUniform1i( mProgram_->getUniform( "instances" ), INSTANCE_UNIT );
+	glUniform1i( mProgram_->getUniform( "surface" ), 0 );
+	mTexturedUniform_ = mProgram_->getUniform( "textured" );
+	mProgram_->unbind();
+	if( GLEW_EXT_texture_array ) {
+		mArrayProgram_ = ShaderProgram::create( "SphereInstancer (array)", vertex.c_str(), ARRAY_FRAGMENT_SHADER );
+		if( mArrayProgram_ != NULL ) {
+			mArrayProgram_->bind();
+			glUniform1i( mArrayProgram_->getUniform( "instances" ), INSTANCE_UNIT );
+			glUniform1i( mArrayProgram_->getUniform( "surface" ), 0 );
+			mArrayTexturedUniform_ = mArrayProgram_->getUniform( "textured" );
+			mArrayProgram_->unbind();
+		}
+	}
+
+	glGenBuffers( 1, &mBuffer_ );
+	glBindBuffer( GL_TEXTURE_BUFFER_EXT, mBuffer_ );
+	glBufferData( GL_TEXTURE_BUFFER_EXT, TEXELS * 4 * sizeof(float), NULL, GL_STREAM_DRAW );
+	glBindBuffer( GL_TEXTURE_BUFFER_EXT, 0 );
+	glGenTextures( 1, &mTexture_ );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	sc->activeTexture( INSTANCE_UNIT );
+	sc->bindTexture( GL_TEXTURE_BUFFER_EXT, mTexture_ );
+	glTexBufferEXT( GL_TEXTURE_BUFFER_EXT, GL_RGBA32F_ARB, mBuffer_ );
+	sc->bindTexture( GL_TEXTURE_BUFFER_EXT, 0 );
+	sc->activeTexture( 0 );
+	LOG_INFO( RENDER, "SphereInstancer: Up to " << mMaxInstances_ << " spheres per draw call." );
+	return true;
+}
+
+bool
+SphereInstancer::isTextureArraySupported() const {
+	return mArrayProgram_ != NULL;
+}
+
+void
+SphereInstancer::begin() {
+	mDrawCount_ = 0;
+	mInstances_.clear();
+	mCurrent_ = NULL;
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	sc->activeTexture( INSTANCE_UNIT );
+	sc->bindTexture( GL_TEXTURE_BUFFER_EXT, mTexture_ );
+	sc->activeTexture( 0 );
+}
+
+void
+SphereInstancer::add( float const model[16], float radius, float emission, float layer ) {
+	// the rows of the upper 3x4 part, the scale only applies to the axes
+	for( unsigned r = 0; r < 3; ++r ) {
+		mInstances_.push_back( model[r] * radius );
+		mInstances_.push_back( model[4 + r] * radius );
+		mInstances_.push_back( model[8 + r] * radius );
+		mInstances_.push_back( model[12 + r] );
+	}
+	mInstances_.push_back( emission );
+	mInstances_.push_back( layer );
+	mInstances_.push_back( 0.0f );
+	mInstances_.push_back( 0.0f );
+}
+
+void
+SphereInstancer::draw( SphereMesh const* mesh, Texture* texture ) {
+	PROFILE_ZONE( "SphereInstancer::draw" );
+	unsigned count = (unsigned)mInstances_.size() / ( TEXELS * 4 );
+	if( count == 0 )
+		return;
+	bool array = ( texture != NULL && texture->getType() == GL_TEXTURE_2D_ARRAY_EXT );
+	if( array && mArrayProgram_ == NULL )
+		texture = NULL;
+	ShaderProgram* program = ( array && texture != NULL ) ? mArrayProgram_ : mProgram_;
+	if( program != mCurrent_ ) {
+		program->bind();
+		mCurrent_ = program;
+	}
+	if( texture != NULL )
+		texture->bind();
+	glUniform1i( ( program == mArrayProgram_ ) ? mArrayTexturedUniform_ : mTexturedUniform_, texture != NULL ? 1 : 0 );
+	glBindBuffer( GL_TEXTURE_BUFFER_EXT, mBuffer_ );
+	for( unsigned first = 0; first < count; first += mMaxInstances_ ) {
+		unsigned batch = ( count - first < mMaxInstances_ ) ? count - first : mMaxInstances_;
+		GLsizeiptr size = batch * TEXELS * 4 * sizeof(float);
+		// orphan the storage, so the upload doesn't wait for the draw calls still reading it
+		glBufferData( GL_TEXTURE_BUFFER_EXT, size, NULL, GL_STREAM_DRAW );
+		glBufferSubData( GL_TEXTURE_BUFFER_EXT, 0, size, &mInstances_[first * TEXELS * 4] );
+		mesh->drawInstanced( (GLsizei)batch );
+		++mDrawCount_;
+	}
+	glBindBuffer( GL_TEXTURE_BUFFER_EXT, 0 );
+	mInstances_.clear();
+}
+
+void
+SphereInstancer::end() {
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	sc->activeTexture( INSTANCE_UNIT );
+	sc->bindTexture( GL_TEXTURE_BUFFER_EXT, 0 );
+	sc->activeTexture( 0 );
+	if( mCurrent_ != NULL )
+		mCurrent_->unbind();
+	mCurrent_ = NULL;
+}
+
+unsigned
+SphereInstancer::getDrawCount() const {
+	return mDrawCount_;
+}
+
+SphereInstancer::~SphereInstancer() {
+	if( mTexture_ != 0 )
+		GLStateCache::getSingletonPtr()->deleteTextures( 1, &mTexture_ );
+	if( mBuffer_ != 0 )
+		glDeleteBuffers( 1, &mBuffer_ );
+	delete mProgram_;
+	delete mArrayProgram_;
+}
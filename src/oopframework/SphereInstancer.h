@@ -0,0 +1,96 @@
+#ifndef SPHEREINSTANCER
+#define SPHEREINSTANCER
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <LogManager.h>
+#include <ShaderProgram.h>
+#include <SphereMesh.h>
+#include <Texture.h>
+
+#include <vector>
+
+/** This class draws many copies of a sphere mesh with one call each (GL_EXT_draw_instanced).
+ * The instances are collected by add() and streamed into a single buffer object, which the vertex shader reads
+ * as a texture buffer (GL_EXT_texture_buffer_object) by gl_InstanceID. Every instance takes TEXELS RGBA32F texels:
+ * the first three are the rows of its model matrix with the radius applied, the fourth holds its emission in x
+ * and its layer in y (the other components are unused). The lighting of the fixed function pipeline (light 0, the
+ * current material) is evaluated per vertex by the shader, so the instances look like the spheres drawn one by one.
+ * The bound texture is shared by all instances of a draw(), the instances have to be grouped by mesh and texture.
+ * With an array texture (see TextureManager::loadTextureArray()) every instance picks its own layer, so bodies with
+ * different surfaces only have to be grouped by their mesh. Batches larger than the texture buffer allows are split.
+ * @brief Instanced drawing of spheres.
+ * @code
+ * SphereInstancer instancer;
+ * if( instancer.init() ) {	// needs the OpenGL context
+ *     instancer.begin();
+ *     for( unsigned i = 0; i < count; ++i )
+ *         instancer.add( matrices + i * 16, radii[i], 0.0f );
+ *     instancer.draw( SphereMesh::getSphere( 12, 12 ), texture );
+ *     instancer.end();
+ * }
+ * @endcode
+ */
+class SphereInstancer {
+	public:
+		static unsigned const TEXELS = 4;	//!< The RGBA32F texels of one instance
+
+		/** This function tells whether the machine supports instancing from a texture buffer.
+		 * @return true if GLSL, GL_EXT_draw_instanced, GL_EXT_gpu_shader4 and GL_EXT_texture_buffer_object are supported.
+		 */
+		static bool isSupported();
+		/** Creates an instancer without any OpenGL objects.
+		 */
+		SphereInstancer();
+		/** Deletes the program, the buffer and the texture. The OpenGL context has to be current.
+		 */
+		~SphereInstancer();
+		/** This function builds the program and creates the instance buffer.
+		 * @return true if the instancer can be used.
+		 */
+		bool init();
+		/** This function tells whether draw() accepts array textures.
+		 * @return true if GL_EXT_texture_array is supported and its program was built by init().
+		 */
+		bool isTextureArraySupported() const;
+		/** This function binds the instance buffer. The modelview matrix, the light and the material have to be set before.
+		 */
+		void begin();
+		/** This function appends an instance to the next draw().
+		 * @param model The column major model matrix, which is applied after the modelview matrix.
+		 * @param radius The radius to scale the unit sphere with.
+		 * @param emission The light the sphere emits itself, 0 for none and 1 for full white.
+		 * @param layer The layer of an array texture, a negative layer draws the sphere untextured. Ignored for 2D textures.
+		 */
+		void add( float const model[16], float radius, float emission, float layer = 0.0f );
+		/** This function draws all instances added since the last draw().
+		 * @param mesh The sphere of all instances.
+		 * @param texture The surface of all instances (a 2D or an array texture), NULL draws them untextured.
+		 */
+		void draw( SphereMesh const* mesh, Texture* texture );
+		/** This function unbinds the program and the instance buffer.
+		 */
+		void end();
+		/** Get the number of draw calls since the last begin().
+		 */
+		unsigned getDrawCount() const;
+
+	private:
+		// the buffers can't be shared by copies
+		SphereInstancer( SphereInstancer const& );
+		SphereInstancer& operator=( SphereInstancer const& );
+
+		ShaderProgram* mProgram_;		//!< The program which places the instances, with a 2D texture
+		ShaderProgram* mArrayProgram_;	//!< The program with an array texture, NULL if not supported
+		ShaderProgram* mCurrent_;		//!< The program bound by the last draw(), NULL after begin()
+		GLint mTexturedUniform_;		//!< The location of the switch for the surface texture of mProgram_
+		GLint mArrayTexturedUniform_;	//!< The location of the switch for the surface texture of mArrayProgram_
+		GLuint mBuffer_;			//!< The buffer object of the instances
+		GLuint mTexture_;			//!< The texture buffer which views mBuffer_ as RGBA32F texels
+		unsigned mMaxInstances_;	//!< The number of instances which fit into the texture buffer
+		unsigned mDrawCount_;		//!< The number of draw calls since begin()
+		std::vector< float > mInstances_;	//!< The instances of the next draw()
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include <SphereLOD.h>
+
+#include <cmath>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+float const SphereLOD::EDGE_PIXELS = 6.0f;
+float const SphereLOD::HYSTERESIS = 0.3f;
+
+// the tessellations of the ladders, a level is about 1.5 times finer than the one below
+static unsigned const LADDER[] = { 8, 12, 16, 24, 32, 48, 64, 96, 128, 192 };
+static unsigned const LADDER_SIZE = sizeof(LADDER) / sizeof(LADDER[0]);
+
+SphereLOD::SphereLOD( unsigned maxDetail ) {
+	if( maxDetail < LADDER[0] )
+		maxDetail = LADDER[0];
+	// a level just below the finest one would hardly save anything
+	for( unsigned i = 0; i < LADDER_SIZE && LADDER[i] < maxDetail * 0.8f; ++i )
+		mDetails_.push_back( LADDER[i] );
+	mDetails_.push_back( maxDetail );
+	for( unsigned i = 0; i < mDetails_.size(); ++i )
+		mMeshes_.push_back( SphereMesh::getSphere( mDetails_[i], mDetails_[i] ) );
+}
+
+unsigned
+SphereLOD::getLevelCount() const {
+	return (unsigned)mDetails_.size();
+}
+
+SphereMesh*
+SphereLOD::getMesh( unsigned level ) const {
+	if( level >= mMeshes_.size() )
+		level = (unsigned)mMeshes_.size() - 1;
+	return mMeshes_[level];
+}
+
+unsigned
+SphereLOD::getDetail( unsigned level ) const {
+	if( level >= mDetails_.size() )
+		level = (unsigned)mDetails_.size() - 1;
+	return mDetails_[level];
+}
+
+unsigned
+SphereLOD::findLevel( float detail ) const {
+	for( unsigned i = 0; i < mDetails_.size(); ++i )
+		if( mDetails_[i] >= detail )
+			return i;
+	return (unsigned)mDetails_.size() - 1;
+}
+
+unsigned
+SphereLOD::selectLevel( float pixelRadius, unsigned current ) const {
+	// the number of silhouette edges of EDGE_PIXELS which fit around the circumference
+	float detail = 2.0f * (float)M_PI * pixelRadius / EDGE_PIXELS;
+	// never coarser than needed, and no finer than needed for a sphere which is HYSTERESIS larger
+	unsigned finest = findLevel( detail * ( 1.0f + HYSTERESIS ) );
+	unsigned coarsest = findLevel( detail );
+	if( current < coarsest )
+		return coarsest;
+	if( current > finest )
+		return finest;
+	return current;
+}
+
+float
+SphereLOD::getPixelScale( float const projection[16], unsigned viewportHeight ) {
+	// projection[5] is cot( fovy / 2 ), which maps the half height of the view at the distance 1 onto 1
+	return projection[5] * viewportHeight * 0.5f;
+}
+
+float
+SphereLOD::getProjectedRadius( float const modelview[16], float const center[3], float radius, float pixelScale ) {
+	float eye[3];
+	for( unsigned r = 0; r < 3; ++r )
+		eye[r] = modelview[r] * center[0] + modelview[4 + r] * center[1] + modelview[8 + r] * center[2] + modelview[12 + r];
+	float distance = std::sqrt( eye[0] * eye[0] + eye[1] * eye[1] + eye[2] * eye[2] );
+	if( distance <= radius )
+		return 1e9f;
+	return radius * pixelScale / distance;
+}
@@ -0,0 +1,77 @@
+#ifndef SPHERELOD
+#define SPHERELOD
+
+#include <SphereMesh.h>
+
+#include <vector>
+
+/** This class holds a ladder of sphere tessellations and picks the one which fits the size of a sphere on the screen.
+ * The number of slices (and stacks) of a level is chosen so the edges along the silhouette are about
+ * EDGE_PIXELS long: a sphere covering a few pixels is drawn with a handful of triangles, a sphere filling the
+ * screen with the full detail. A level is only left downwards if the sphere shrank clearly below it (by
+ * HYSTERESIS), so a sphere at the border of two levels doesn't switch back and forth every frame.
+ * The meshes come from the cache of SphereMesh, ladders with the same levels share them.
+ * @brief Level of detail for spheres.
+ * @code
+ * SphereLOD lod( 100 );
+ * unsigned level = 0;
+ * // every frame, with the transformation of the sphere on the modelview stack
+ * level = lod.selectLevel( SphereLOD::getProjectedRadius( modelview, center, 5.0f, pixelScale ), level );
+ * lod.getMesh( level )->draw( 5.0f );
+ * @endcode
+ */
+class SphereLOD {
+	public:
+		static float const EDGE_PIXELS;	//!< The length in pixels of the silhouette edges a level is chosen for
+		static float const HYSTERESIS;	//!< The relative amount a sphere has to shrink below a level to leave it
+
+		/** Creates the ladder.
+		 * @param maxDetail The slices and stacks of the finest level.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		SphereLOD( unsigned maxDetail );
+		/** Get the number of levels.
+		 * @return The number of levels, 0 is the coarsest.
+		 */
+		unsigned getLevelCount() const;
+		/** Get the mesh of a level.
+		 * @param level The level, it is clamped to the finest one.
+		 * @return The sphere of the level.
+		 */
+		SphereMesh* getMesh( unsigned level ) const;
+		/** Get the slices and stacks of a level.
+		 * @param level The level, it is clamped to the finest one.
+		 * @return The number of slices, which is also the number of stacks.
+		 */
+		unsigned getDetail( unsigned level ) const;
+		/** This function selects the level for a sphere.
+		 * @param pixelRadius The radius of the sphere on the screen in pixels.
+		 * @param current The level of the last frame.
+		 * @return The level to draw.
+		 */
+		unsigned selectLevel( float pixelRadius, unsigned current ) const;
+		/** This function computes the number of pixels a unit at the distance 1 in front of the camera covers.
+		 * @param projection The column major projection matrix (a perspective one).
+		 * @param viewportHeight The height of the viewport in pixels.
+		 * @return The scale for getProjectedRadius().
+		 */
+		static float getPixelScale( float const projection[16], unsigned viewportHeight );
+		/** This function computes the radius of a sphere on the screen.
+		 * @param modelview The column major matrix which transforms the center of the sphere into eye coordinates.
+		 * @param center The center of the sphere, given in the coordinates of the modelview matrix.
+		 * @param radius The radius of the sphere.
+		 * @param pixelScale The result of getPixelScale().
+		 * @return The radius in pixels, very large if the camera is inside of the sphere.
+		 */
+		static float getProjectedRadius( float const modelview[16], float const center[3], float radius, float pixelScale );
+
+	private:
+		/** This function returns the coarsest level with at least the given detail.
+		 */
+		unsigned findLevel( float detail ) const;
+
+		std::vector< unsigned > mDetails_;		//!< The slices and stacks of every level, growing
+		std::vector< SphereMesh* > mMeshes_;	//!< The sphere of every level
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include <SphereMesh.h>
+#include <Profiler.h>
+#include <cmath>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+// CACHE
+SphereMesh::SphereCache SphereMesh::mCache_;
+
+SphereMesh*
+SphereMesh::getSphere( unsigned slices, unsigned stacks ) {
+	// gluSphere needs at least 2 slices and 1 stack as well
+	if( slices < 2 )
+		slices = 2;
+	if( stacks < 1 )
+		stacks = 1;
+	std::pair< unsigned, unsigned > key( slices, stacks );
+	SphereCache::iterator it = mCache_.find( key );
+	if( it != mCache_.end() )
+		return it->second;
+	SphereMesh* sphere = new SphereMesh( slices, stacks );
+	mCache_[key] = sphere;
+	return sphere;
+}
+
+void
+SphereMesh::destroyCache() {
+	SphereCache::iterator it = mCache_.begin();
+	while( it != mCache_.end() ) {
+		delete it->second;
+		++it;
+	}
+	mCache_.clear();
+}
+
+SphereMesh::SphereMesh( unsigned slices, unsigned stacks ) :
+	mSlices_(slices),
+	mStacks_(stacks),
+	mUseVBO_(false),
+	mVertexBuffer_(0),
+	mIndexBuffer_(0),
+	mLineIndexBuffer_(0),
+	mIndexCount_(0),
+	mLineIndexCount_(0) {
+	build();
+}
+
+void
+SphereMesh::build() {
+	PROFILE_ZONE( "SphereMesh::build" );
+	std::vector< SphereVertex > vertices;
+	std::vector< GLuint > indices;
+	std::vector< GLuint > lineIndices;
+	vertices.reserve( (mStacks_ + 1) * (mSlices_ + 1) );
+	indices.reserve( mStacks_ * mSlices_ * 6 );
+	lineIndices.reserve( mStacks_ * mSlices_ * 4 );
+
+	// the same parametrisation as gluSphere with GLU_OUTSIDE:
+	// rho runs from the +z pole to the -z pole, theta around the z-axis
+	double drho = M_PI / (double)mStacks_;
+	double dtheta = 2.0 * M_PI / (double)mSlices_;
+	for( unsigned i = 0; i <= mStacks_; ++i ) {
+		double rho = i * drho;
+		for( unsigned j = 0; j <= mSlices_; ++j ) {
+			// close the seam exactly like gluSphere does
+			double theta = ( j == mSlices_ ) ? 0.0 : j * dtheta;
+			SphereVertex v;
+			v.position[0] = (float)(-std::sin(theta) * std::sin(rho));
+			v.position[1] = (float)( std::cos(theta) * std::sin(rho));
+			v.position[2] = (float)( std::cos(rho));
+			v.normal[0] = v.position[0];
+			v.normal[1] = v.position[1];
+			v.normal[2] = v.position[2];
+			v.texCoord[0] = (float)j / (float)mSlices_;
+			v.texCoord[1] = 1.0f - (float)i / (float)mStacks_;
+			vertices.push_back( v );
+		}
+	}
+
+	GLuint rowLength = mSlices_ + 1;
+	for( unsigned i = 0; i < mStacks_; ++i ) {
+		for( unsigned j = 0; j < mSlices_; ++j ) {
+			GLuint a0 = i * rowLength + j;		// upper ring
+			GLuint a1 = a0 + 1;
+			GLuint b0 = a0 + rowLength;			// lower ring
+			GLuint b1 = b0 + 1;
+			// the two triangles of the quad strip segment
+			indices.push_back( a0 );
+			indices.push_back( b0 );
+			indices.push_back( b1 );
+			indices.push_back( a0 );
+			indices.push_back( b1 );
+			indices.push_back( a1 );
+			// meridian segment
+			lineIndices.push_back( a0 );
+			lineIndices.push_back( b0 );
+			// latitude segment (the poles are degenerated to a point)
+			if( i > 0 ) {
+				lineIndices.push_back( a0 );
+				lineIndices.push_back( a1 );
+			}
+		}
+	}
+	mIndexCount_ = (GLsizei)indices.size();
+	mLineIndexCount_ = (GLsizei)lineIndices.size();
+
+	mUseVBO_ = ( GLEW_VERSION_1_5 == GL_TRUE );
+	if( mUseVBO_ ) {
+		glGenBuffers( 1, &mVertexBuffer_ );
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glBufferData( GL_ARRAY_BUFFER, vertices.size() * sizeof(SphereVertex), &vertices[0], GL_STATIC_DRAW );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+		glGenBuffers( 1, &mIndexBuffer_ );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer_ );
+		glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW );
+		glGenBuffers( 1, &mLineIndexBuffer_ );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, mLineIndexBuffer_ );
+		glBufferData( GL_ELEMENT_ARRAY_BUFFER, lineIndices.size() * sizeof(GLuint), &lineIndices[0], GL_STATIC_DRAW );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+		LOG_INFO( RENDER, "SphereMesh: Built sphere with " << mSlices_ << " slices and " << mStacks_ << " stacks (" << getTriangleCount() << " triangles) in a Vertex Buffer Object." );
+	}
+	else {
+		// no VBOs available - keep the arrays in client memory
+		mVertices_.swap( vertices );
+		mIndices_.swap( indices );
+		mLineIndices_.swap( lineIndices );
+		LOG_WARNING( RENDER, "SphereMesh: Vertex Buffer Objects are not supported. Built sphere with " << mSlices_ << " slices and " << mStacks_ << " stacks in client memory." );
+	}
+}
+
+void
+SphereMesh::bindArrays() const {
+	if( mUseVBO_ ) {
+		glBindBuffer( GL_ARRAY_BUFFER, mVertexBuffer_ );
+		glInterleavedArrays( GL_T2F_N3F_V3F, sizeof(SphereVertex), 0 );
+	}
+	else
+		glInterleavedArrays( GL_T2F_N3F_V3F, sizeof(SphereVertex), &mVertices_[0] );
+}
+
+void
+SphereMesh::unbindArrays() const {
+	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+	glDisableClientState( GL_NORMAL_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
+	if( mUseVBO_ )
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void
+SphereMesh::drawElements( GLenum mode, GLuint buffer, std::vector< GLuint > const& indices, GLsizei instances ) const {
+	GLsizei count = ( mode == GL_LINES ) ? mLineIndexCount_ : mIndexCount_;
+	// the offset into the bound index buffer or the client side indices
+	GLvoid const* first = NULL;
+	if( mUseVBO_ )
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffer );
+	else
+		first = &indices[0];
+	if( instances > 0 )
+		glDrawElementsInstancedEXT( mode, count, GL_UNSIGNED_INT, first, instances );
+	else
+		glDrawElements( mode, count, GL_UNSIGNED_INT, first );
+	if( mUseVBO_ )
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+}
+
+void
+SphereMesh::draw( float radius ) const {
+	PROFILE_ZONE( "SphereMesh::draw" );
+	glPushMatrix();
+	glScalef( radius, radius, radius );
+	bindArrays();
+	drawElements( GL_TRIANGLES, mIndexBuffer_, mIndices_ );
+	unbindArrays();
+	glPopMatrix();
+}
+
+void
+SphereMesh::drawWireframe( float radius ) const {
+	PROFILE_ZONE( "SphereMesh::drawWireframe" );
+	glPushMatrix();
+	glScalef( radius, radius, radius );
+	bindArrays();
+	drawElements( GL_LINES, mLineIndexBuffer_, mLineIndices_ );
+	unbindArrays();
+	glPopMatrix();
+}
+
+void
+SphereMesh::drawInstanced( GLsizei instances ) const {
+	PROFILE_ZONE( "SphereMesh::drawInstanced" );
+	bindArrays();
+	drawElements( GL_TRIANGLES, mIndexBuffer_, mIndices_, instances );
+	unbindArrays();
+}
+
+unsigned
+SphereMesh::getTriangleCount() const {
+	return (unsigned)mIndexCount_ / 3;
+}
+
+SphereMesh::~SphereMesh() {
+	if( mUseVBO_ ) {
+		glDeleteBuffers( 1, &mVertexBuffer_ );
+		glDeleteBuffers( 1, &mIndexBuffer_ );
+		glDeleteBuffers( 1, &mLineIndexBuffer_ );
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef SPHEREMESH
+#define SPHEREMESH
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+#include <LogManager.h>
+
+#include <map>
+#include <vector>
+#include <utility>
+
+/** One vertex of a SphereMesh in the layout of GL_T2F_N3F_V3F, so it can be handed to glInterleavedArrays() directly.
+ */
+struct SphereVertex {
+	float texCoord[2];	//!< The texture coordinate (s,t)
+	float normal[3];	//!< The normal of the unit sphere (equals the position)
+	float position[3];	//!< The position on the unit sphere
+};
+
+/** This class holds a tessellated unit sphere which is built only once and then drawn from a Vertex Buffer Object.
+ * The tessellation matches gluSphere() (same orientation and texture coordinates), so it can be used as a drop-in replacement.
+ * Spheres are cached by their slices and stacks, the radius is applied by the modelview matrix when drawing.
+ * @brief A cached unit sphere in GPU memory.
+ * @code
+ * // draw a sphere with radius 5 and 100 slices and stacks
+ * SphereMesh::getSphere( 100, 100 )->draw( 5.0f );
+ * @endcode
+ */
+class SphereMesh {
+	public:
+		/** Get a sphere with the given tessellation. The sphere will be built on the first request.
+		 * @param slices The number of subdivisions around the z-axis (like longitude lines).
+		 * @param stacks The number of subdivisions along the z-axis (like latitude lines).
+		 * @return A pointer to the cached sphere.
+		 * @note A valid OpenGL context has to exist when calling this function.
+		 */
+		static SphereMesh* getSphere( unsigned slices, unsigned stacks );
+		/** Deletes all cached spheres and frees their buffers.
+		 */
+		static void destroyCache();
+		/** This function draws the sphere as filled triangles with normals and texture coordinates.
+		 * @param radius The radius to scale the unit sphere with.
+		 */
+		void draw( float radius ) const;
+		/** This function draws the latitude and longitude lines of the sphere.
+		 * @param radius The radius to scale the unit sphere with.
+		 */
+		void drawWireframe( float radius ) const;
+		/** This function draws the unit sphere several times with one call (GL_EXT_draw_instanced).
+		 * The vertex shader of the bound program has to place every copy by gl_InstanceID, see SphereInstancer.
+		 * @param instances The number of copies.
+		 */
+		void drawInstanced( GLsizei instances ) const;
+		/** This function will return the number of triangles of the sphere.
+		 * @return The number of triangles drawn by draw().
+		 */
+		unsigned getTriangleCount() const;
+
+	private:
+		typedef std::map< std::pair< unsigned, unsigned >, SphereMesh* > SphereCache;
+
+		/** Creates and builds a new sphere.
+		 * @param slices The number of subdivisions around the z-axis.
+		 * @param stacks The number of subdivisions along the z-axis.
+		 */
+		SphereMesh( unsigned slices, unsigned stacks );
+		~SphereMesh(); //!< destructor
+		/** This internal function tessellates the unit sphere and uploads it into the buffers.
+		 */
+		void build();
+		/** This internal function sets up the vertex arrays for drawing.
+		 */
+		void bindArrays() const;
+		/** This internal function resets the vertex arrays after drawing.
+		 */
+		void unbindArrays() const;
+		/** This internal function draws a range of indices.
+		 * @param mode The primitive type to draw.
+		 * @param buffer The index buffer to use, if VBOs are used.
+		 * @param indices The client side indices, if no VBOs are used.
+		 * @param instances The number of instances to draw with glDrawElementsInstancedEXT, 0 draws without instancing.
+		 */
+		void drawElements( GLenum mode, GLuint buffer, std::vector< GLuint > const& indices, GLsizei instances = 0 ) const;
+
+		static SphereCache mCache_; //!< All previously built spheres
+
+		unsigned mSlices_;		//!< The number of slices
+		unsigned mStacks_;		//!< The number of stacks
+		bool	 mUseVBO_;		//!< If true, the data is stored in Vertex Buffer Objects, else in client memory
+		GLuint	 mVertexBuffer_;	//!< The interleaved vertex buffer
+		GLuint	 mIndexBuffer_;		//!< The triangle index buffer
+		GLuint	 mLineIndexBuffer_;	//!< The line index buffer for the wireframe
+
+		std::vector< SphereVertex > mVertices_;	//!< The vertices (only kept if VBOs are not supported)
+		std::vector< GLuint > mIndices_;		//!< The triangle indices (only kept if VBOs are not supported)
+		std::vector< GLuint > mLineIndices_;	//!< The line indices (only kept if VBOs are not supported)
+		GLsizei	 mIndexCount_;		//!< The number of triangle indices
+		GLsizei	 mLineIndexCount_;	//!< The number of line indices
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include <Texture.h>
+#include <GLStateCache.h>
+#include <Profiler.h>
 
 Texture::Texture() :
 	texID(0),
@@ -7,22 +9,28 @@ Texture::Texture() :
 	magFilter(GL_NEAREST),
 	mipMaps(false),
 	name(""),
+	pathID(0),
 	refCnt(0),
-	isPrivate(true) {
+	isPrivate(true),
+	width(0),
+	height(0),
+	depth(1),
+	loaded(true) {
 }
 
 void
 Texture::bind() {
-	if( !glIsEnabled( GL_TEXTURE_2D ) )
-		glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texID );
+	PROFILE_ZONE( "Texture::bind" );
+	GLStateCache* sc = GLStateCache::getSingletonPtr();
+	if( texType != GL_TEXTURE_2D_ARRAY_EXT )
+		sc->enable( texType );
+	sc->bindTexture( texType, texID );
 }
 
 void
 Texture::unbind() {
-	if( glIsEnabled( GL_TEXTURE_2D ) )
-		glDisable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, NULL );
+	if( texType != GL_TEXTURE_2D_ARRAY_EXT )
+		GLStateCache::getSingletonPtr()->disable( texType );
 }
 
 unsigned 
@@ -35,6 +43,21 @@ Texture::getHeight() const {
 	return height;
 }
 
+unsigned
+Texture::getDepth() const {
+	return depth;
+}
+
+bool
+Texture::isLoaded() const {
+	return loaded;
+}
+
+GLuint
+Texture::getType() const {
+	return texType;
+}
+
 bool
 Texture::operator ==( Texture const& rhs ) {
 	if( texID == rhs.texID &&
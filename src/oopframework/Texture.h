@@ -22,9 +22,12 @@ class Texture {
 		 */
 		Texture();
 		/** This function binds the Texture into a specific Texture slot.
+		 * The state changes go through the GLStateCache, so binding an already bound Texture costs no driver call.
+		 * Array textures are only bound, they can't be enabled for the fixed function pipeline and have to be sampled by a shader.
 		 */
 		void bind();
 		/** This function unbinds the Texture from a specific Texture slot.
+		 * Only the texture type is disabled, the Texture stays bound, so binding it again is filtered by the GLStateCache.
 		 */
 		void unbind();
 		/** This function will return the width of the Texture.
@@ -35,6 +38,18 @@ class Texture {
 		 * @return The height of the Texture
 		 */
 		unsigned getHeight() const;
+		/** This function will return the number of layers of the Texture.
+		 * @return The number of layers of an array texture, 1 for all other types.
+		 */
+		unsigned getDepth() const;
+		/** This function tells whether the image of the Texture is available.
+		 * @return false while the Texture is decoded in the background and a placeholder is bound instead.
+		 */
+		bool isLoaded() const;
+		/** This function will return the type of the Texture.
+		 * @return The OpenGL target of the Texture (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY_EXT).
+		 */
+		GLuint getType() const;
 		/** This is a normal EQUAL operator.
 		*/
 		bool operator==(Texture const& rhs);
@@ -50,10 +65,13 @@ class Texture {
 		GLuint magFilter;	//!< The type of mag filter, the texture uses
 		bool mipMaps;		//!< If true mipmaps are applied to the texture
 		std::string name;	//!< The name of the Texture.
+		unsigned pathID;	//!< The ID of the name in the texture pool of the TextureManager.
 		GLuint refCnt;	//!< The reference counter of the texture.
 		bool isPrivate;		//!< if true, the texture will not be shared between different objects.
 		GLuint width;		//!< The height of the Texture.
 		GLuint height;	//!< The width of the Texture.
+		GLuint depth;		//!< The number of layers of an array texture (1 for all other types).
+		bool loaded;		//!< false while the image is decoded in the background (texID is the placeholder then).
 		
 };
 
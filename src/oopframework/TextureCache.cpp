@@ -0,0 +1,138 @@
+#include <TextureCache.h>
+
+#include <fstream>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// the file layout of the cache (all values are unsigned 32 bit integers):
+// magic, version, maximum size, setting flags, internal format, number of levels,
+// then per level: width, height, size and the data
+static unsigned const CACHE_MAGIC = 0x43543353; // 'S3TC'
+static unsigned const CACHE_VERSION = 2;
+
+// the flags of the CacheSettings
+static unsigned const FLAG_MIPMAPS = 1;
+static unsigned const FLAG_CPU_MIPMAPS = 2;
+static unsigned const FLAG_GAMMA_CORRECT = 4;
+
+static unsigned
+getFlags( CacheSettings const& settings ) {
+	return ( settings.mipMaps ? FLAG_MIPMAPS : 0 ) | ( settings.cpuMipMaps ? FLAG_CPU_MIPMAPS : 0 )
+		 | ( settings.gammaCorrect ? FLAG_GAMMA_CORRECT : 0 );
+}
+
+std::string
+TextureCache::getCachePath( std::string const& path ) {
+	return path + ".s3tc";
+}
+
+bool
+TextureCache::isValid( std::string const& path ) {
+	struct stat source;
+	struct stat cache;
+	if( stat( path.c_str(), &source ) != 0 )
+		return false;
+	if( stat( getCachePath( path ).c_str(), &cache ) != 0 )
+		return false;
+	return cache.st_mtime >= source.st_mtime;
+}
+
+bool
+TextureCache::read( std::string const& path, CacheSettings const& settings, CompressedImage& image, std::string& error ) {
+	std::string cachePath = getCachePath( path );
+	std::ifstream file( cachePath.c_str(), std::ios::in | std::ios::binary );
+	if( !file ) {
+		error = "Could not open cache file '" + cachePath + "'.";
+		return false;
+	}
+	unsigned header[6];
+	file.read( (char*)header, sizeof(header) );
+	if( !file || header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION || header[5] == 0 ) {
+		error = "Cache file '" + cachePath + "' is corrupted or of an old version.";
+		return false;
+	}
+	if( header[2] != settings.maxSize || header[3] != getFlags( settings ) ) {
+		error = "Cache file '" + cachePath + "' was built with other texture settings.";
+		return false;
+	}
+	image.internalFormat = header[4];
+	image.levels.resize( header[5] );
+	for( unsigned i = 0; i < image.levels.size(); ++i ) {
+		unsigned level[3];
+		file.read( (char*)level, sizeof(level) );
+		if( !file || level[2] == 0 ) {
+			error = "Cache file '" + cachePath + "' is truncated.";
+			image.levels.clear();
+			return false;
+		}
+		image.levels[i].width = level[0];
+		image.levels[i].height = level[1];
+		image.levels[i].data.resize( level[2] );
+		file.read( (char*)&image.levels[i].data[0], level[2] );
+		if( !file ) {
+			error = "Cache file '" + cachePath + "' is truncated.";
+			image.levels.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+TextureCache::write( std::string const& path, CacheSettings const& settings, CompressedImage const& image, std::string& error ) {
+	std::string cachePath = getCachePath( path );
+	std::ofstream file( cachePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !file ) {
+		error = "Could not create cache file '" + cachePath + "'.";
+		return false;
+	}
+	unsigned header[6] = { CACHE_MAGIC, CACHE_VERSION, settings.maxSize, getFlags( settings ), image.internalFormat,
+						   (unsigned)image.levels.size() };
+	file.write( (char const*)header, sizeof(header) );
+	for( unsigned i = 0; i < image.levels.size(); ++i ) {
+		CompressedLevel const& l = image.levels[i];
+		unsigned level[3] = { l.width, l.height, (unsigned)l.data.size() };
+		file.write( (char const*)level, sizeof(level) );
+		file.write( (char const*)&l.data[0], l.data.size() );
+	}
+	file.close();
+	if( !file ) {
+		error = "Could not write cache file '" + cachePath + "'.";
+		std::remove( cachePath.c_str() );
+		return false;
+	}
+	return true;
+}
+
+bool
+TextureCache::readBack( GLenum texType, CompressedImage& image ) {
+	GLint compressed = GL_FALSE;
+	glGetTexLevelParameteriv( texType, 0, GL_TEXTURE_COMPRESSED, &compressed );
+	if( compressed != GL_TRUE )
+		return false;
+	GLint format = 0;
+	glGetTexLevelParameteriv( texType, 0, GL_TEXTURE_INTERNAL_FORMAT, &format );
+	image.internalFormat = format;
+	image.levels.clear();
+	for( GLint level = 0; ; ++level ) {
+		GLint width = 0, height = 0, size = 0;
+		glGetTexLevelParameteriv( texType, level, GL_TEXTURE_WIDTH, &width );
+		glGetTexLevelParameteriv( texType, level, GL_TEXTURE_HEIGHT, &height );
+		if( width == 0 || height == 0 )
+			break;
+		glGetTexLevelParameteriv( texType, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size );
+		if( size <= 0 )
+			break;
+		CompressedLevel l;
+		l.width = width;
+		l.height = height;
+		l.data.resize( size );
+		glGetCompressedTexImage( texType, level, &l.data[0] );
+		image.levels.push_back( l );
+		// the last level of the chain
+		if( width == 1 && height == 1 )
+			break;
+	}
+	return !image.levels.empty();
+}
@@ -0,0 +1,89 @@
+#ifndef TEXTURECACHE
+#define TEXTURECACHE
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <vector>
+#include <string>
+
+/** One level of the mip chain of a compressed texture.
+ */
+struct CompressedLevel {
+	unsigned width;		//!< The width of the level
+	unsigned height;	//!< The height of the level
+	std::vector< unsigned char > data;	//!< The compressed blocks of the level
+};
+
+/** This struct holds a compressed texture including its mip chain, ready for glCompressedTexImage2D().
+ * @brief A compressed texture in client memory.
+ */
+struct CompressedImage {
+	GLenum internalFormat;	//!< The compressed format (GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+	std::vector< CompressedLevel > levels;	//!< The mip levels, beginning with the base level
+
+	CompressedImage() : internalFormat(0) {}
+};
+
+/** This struct holds the settings of the TextureManager which change the pixels of a texture.
+ * They are stored in the cache file, which is not used if the texture would be built with other settings now.
+ * @brief The settings a cached texture was built with.
+ */
+struct CacheSettings {
+	unsigned maxSize;	//!< The size the image was scaled down to if it was bigger
+	bool mipMaps;		//!< If true, the texture has a mip chain
+	bool cpuMipMaps;	//!< If true, the mip chain was built on the CPU instead of by the driver
+	bool gammaCorrect;	//!< If true, the mip chain was built in linear space
+
+	CacheSettings() : maxSize(0), mipMaps(false), cpuMipMaps(false), gammaCorrect(false) {}
+	/** The settings which don't apply (e.g. the gamma correction of mipmaps built by the driver) are cleared,
+	 * so they don't invalidate the cache.
+	 */
+	CacheSettings( unsigned size, bool mips, bool cpuMips, bool gamma ) :
+		maxSize(size), mipMaps(mips), cpuMipMaps(mips && cpuMips), gammaCorrect(mips && cpuMips && gamma) {}
+};
+
+/** This class reads and writes the on-disk cache of compressed textures.
+ * The cache of an image is stored next to the image with the extension '.s3tc' appended. It is valid as long as it is
+ * not older than the image itself and was built with the current CacheSettings. The cache files are written in the
+ * byte order of the machine.
+ * @brief On-disk cache of S3TC compressed textures.
+ */
+class TextureCache {
+	public:
+		/** Get the path of the cache file of an image.
+		 * @param path The full path of the image.
+		 * @return The full path of the cache file.
+		 */
+		static std::string getCachePath( std::string const& path );
+		/** This function tests whether an up-to-date cache file of an image exists.
+		 * @param path The full path of the image.
+		 * @return true if the cache file exists and is not older than the image.
+		 */
+		static bool isValid( std::string const& path );
+		/** This function reads the cache file of an image. It is safe to call it from any thread.
+		 * @param path The full path of the image (not of the cache file).
+		 * @param settings The settings the texture would be built with now.
+		 * @param image The image to fill.
+		 * @param error The reason of a failure.
+		 * @return true if the cache was read successfully, false if it is broken or was built with other settings.
+		 */
+		static bool read( std::string const& path, CacheSettings const& settings, CompressedImage& image, std::string& error );
+		/** This function writes the cache file of an image.
+		 * @param path The full path of the image (not of the cache file).
+		 * @param settings The settings the texture was built with.
+		 * @param image The compressed image to store.
+		 * @param error The reason of a failure.
+		 * @return true if the cache was written successfully.
+		 */
+		static bool write( std::string const& path, CacheSettings const& settings, CompressedImage const& image, std::string& error );
+		/** This function reads back the compressed mip chain of the currently bound texture.
+		 * @param texType The texture target the texture is bound to.
+		 * @param image The image to fill.
+		 * @return true if the texture is compressed and could be read back.
+		 * @note This function has to be called by the thread owning the OpenGL context.
+		 */
+		static bool readBack( GLenum texType, CompressedImage& image );
+};
+
+#endif
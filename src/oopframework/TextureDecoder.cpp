@@ -0,0 +1,456 @@
+#include <TextureDecoder.h>
+#include <ImageFilter.h>
+#include <Profiler.h>
+
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+#ifdef TEXTUREDECODER_LIBJPEG
+	#include <cstdio>
+	#include <csetjmp>
+	#include <jpeglib.h>
+
+/** The error handler of libjpeg, which returns to decodeJPEG() instead of exiting the program.
+ */
+struct JPEGError {
+	jpeg_error_mgr manager;	//!< The standard handler, which formats the messages
+	jmp_buf jump;			//!< The state to return to
+};
+
+static void
+jpegErrorExit( j_common_ptr info ) {
+	longjmp( reinterpret_cast< JPEGError* >( info->err )->jump, 1 );
+}
+
+static void
+jpegOutputMessage( j_common_ptr ) {
+	// the workers never log, the warnings of libjpeg are dropped
+}
+
+// the whole file is already in memory, so the source only has to hand it out once (jpeg_mem_src() is libjpeg 8 only)
+static void
+jpegInitSource( j_decompress_ptr ) {
+}
+
+static boolean
+jpegFillInputBuffer( j_decompress_ptr info ) {
+	// the data is exhausted: end a truncated file with an EOI marker, like the file readers of libjpeg do
+	static JOCTET const END_OF_IMAGE[2] = { 0xFF, JPEG_EOI };
+	info->src->next_input_byte = END_OF_IMAGE;
+	info->src->bytes_in_buffer = 2;
+	return TRUE;
+}
+
+static void
+jpegSkipInputData( j_decompress_ptr info, long count ) {
+	if( count <= 0 )
+		return;
+	if( (size_t)count > info->src->bytes_in_buffer )
+		count = (long)info->src->bytes_in_buffer;
+	info->src->next_input_byte += count;
+	info->src->bytes_in_buffer -= (size_t)count;
+}
+
+static void
+jpegTermSource( j_decompress_ptr ) {
+}
+#endif
+
+TextureDecoder::TextureDecoder( unsigned numThreads ) :
+	mNumThreads_(numThreads),
+	mQuit_(false) {
+	if( mNumThreads_ == 0 )
+		mNumThreads_ = getProcessorCount();
+	mMutex_ = SDL_CreateMutex();
+	mCond_ = SDL_CreateCond();
+	mILMutex_ = SDL_CreateMutex();
+}
+
+void
+TextureDecoder::startThreads() {
+	if( !mThreads_.empty() )
+		return;
+	for( unsigned i = 0; i < mNumThreads_; ++i ) {
+		SDL_Thread* t = SDL_CreateThread( &TextureDecoder::workerMain, this );
+		if( t != NULL )
+			mThreads_.push_back( t );
+	}
+}
+
+void
+TextureDecoder::enqueue( DecodeJob* job ) {
+	startThreads();
+	if( mThreads_.empty() ) {
+		// no thread could be started - decode it right here
+		process( job );
+		SDL_LockMutex( mMutex_ );
+		mFinished_.push_back( job );
+		SDL_UnlockMutex( mMutex_ );
+		return;
+	}
+	SDL_LockMutex( mMutex_ );
+	mQueue_.push_back( job );
+	SDL_CondSignal( mCond_ );
+	SDL_UnlockMutex( mMutex_ );
+}
+
+DecodeJob*
+TextureDecoder::popFinished() {
+	DecodeJob* job = NULL;
+	SDL_LockMutex( mMutex_ );
+	if( !mFinished_.empty() ) {
+		job = mFinished_.front();
+		mFinished_.pop_front();
+	}
+	SDL_UnlockMutex( mMutex_ );
+	return job;
+}
+
+void
+TextureDecoder::cancel( Texture const* target ) {
+	SDL_LockMutex( mMutex_ );
+	std::list< DecodeJob* >::iterator it = mQueue_.begin();
+	while( it != mQueue_.end() ) {
+		if( (*it)->target == target ) {
+			delete *it;
+			it = mQueue_.erase( it );
+		}
+		else
+			++it;
+	}
+	for( it = mRunning_.begin(); it != mRunning_.end(); ++it )
+		if( (*it)->target == target )
+			(*it)->target = NULL;
+	for( it = mFinished_.begin(); it != mFinished_.end(); ++it )
+		if( (*it)->target == target )
+			(*it)->target = NULL;
+	SDL_UnlockMutex( mMutex_ );
+}
+
+unsigned
+TextureDecoder::getPendingCount() {
+	SDL_LockMutex( mMutex_ );
+	unsigned count = (unsigned)( mQueue_.size() + mRunning_.size() + mFinished_.size() );
+	SDL_UnlockMutex( mMutex_ );
+	return count;
+}
+
+void
+TextureDecoder::process( DecodeJob* job ) {
+	PROFILE_ZONE( "TextureDecoder::process" );
+	job->fromCache = false;
+	// packed images have no file of their own, which the cache could be compared with
+	if( job->entry.archive == NULL && job->useCache && TextureCache::isValid( job->path ) ) {
+		// the compressed blocks can be uploaded directly - no need to decode the image
+		std::string error;
+		job->compressed.levels.clear();
+		CacheSettings settings( job->maxSize, job->generateMipMaps, job->buildMipMaps, job->gammaCorrect );
+		if( TextureCache::read( job->path, settings, job->compressed, error ) ) {
+			job->fromCache = true;
+			job->success = true;
+			return;
+		}
+	}
+	if( job->entry.archive != NULL )
+		job->success = decodeEntry( job->entry, job->path, job->image, job->error );
+	else
+		job->success = decodeFile( job->path, job->image, job->error );
+	job->sourceWidth = job->image.width;
+	job->sourceHeight = job->image.height;
+	if( job->success && job->texType == GL_TEXTURE_CUBE_MAP ) {
+		// the panorama is converted into the faces, their mip chains are built here as well
+		ImageFilter::equirectToCube( job->image, job->maxSize, job->faces );
+		job->image.pixels.clear();
+		if( job->buildMipMaps ) {
+			Uint32 start = SDL_GetTicks();
+			job->faceMipLevels.resize( job->faces.size() );
+			for( unsigned i = 0; i < job->faces.size(); ++i )
+				ImageFilter::buildMipChain( job->faces[i], job->faceMipLevels[i], job->gammaCorrect );
+			job->mipTime = SDL_GetTicks() - start;
+		}
+		return;
+	}
+	// scale images which are too big for the machine down right here, instead of on the render thread
+	if( job->success && job->texType == GL_TEXTURE_2D_ARRAY_EXT ) {
+		// all layers of an array texture have the same size
+		if( job->image.width != job->layerWidth || job->image.height != job->layerHeight ) {
+			ImageData layer;
+			ImageFilter::resample( job->image, job->layerWidth, job->layerHeight, layer );
+			job->image.pixels.swap( layer.pixels );
+			job->image.width = layer.width;
+			job->image.height = layer.height;
+		}
+	}
+	else if( job->success )
+		ImageFilter::fitToSize( job->image, job->maxSize );
+	// the mip chain is built here as well, so the render thread only has to upload the levels
+	if( job->success && job->buildMipMaps ) {
+		Uint32 start = SDL_GetTicks();
+		ImageFilter::buildMipChain( job->image, job->mipLevels, job->gammaCorrect );
+		job->mipTime = SDL_GetTicks() - start;
+	}
+}
+
+int SDLCALL
+TextureDecoder::workerMain( void* data ) {
+	static_cast< TextureDecoder* >( data )->work();
+	return 0;
+}
+
+void
+TextureDecoder::work() {
+	Profiler::setThreadName( "TextureDecoder" );
+	SDL_LockMutex( mMutex_ );
+	while( true ) {
+		while( mQueue_.empty() && !mQuit_ )
+			SDL_CondWait( mCond_, mMutex_ );
+		if( mQuit_ )
+			break;
+		DecodeJob* job = mQueue_.front();
+		mQueue_.pop_front();
+		mRunning_.push_back( job );
+		SDL_UnlockMutex( mMutex_ );
+
+		process( job );
+
+		SDL_LockMutex( mMutex_ );
+		mRunning_.remove( job );
+		mFinished_.push_back( job );
+	}
+	SDL_UnlockMutex( mMutex_ );
+}
+
+bool
+TextureDecoder::decodeFile( std::string const& path, ImageData& image, std::string& error ) {
+	// read the whole file without holding the DevIL lock, so the IO of several workers can overlap
+	std::ifstream file( path.c_str(), std::ios::in | std::ios::binary );
+	if( !file ) {
+		error = "Could not open Imagefile '" + path + "'.";
+		return false;
+	}
+	file.seekg( 0, std::ios::end );
+	std::streamoff size = file.tellg();
+	file.seekg( 0, std::ios::beg );
+	if( size <= 0 ) {
+		error = "Imagefile '" + path + "' is empty.";
+		return false;
+	}
+	std::vector< char > buffer( (size_t)size );
+	file.read( &buffer[0], size );
+	if( !file ) {
+		error = "Could not read Imagefile '" + path + "'.";
+		return false;
+	}
+	file.close();
+
+	SDL_LockMutex( mILMutex_ );
+	ILenum type = ilTypeFromExt( path.c_str() );
+	SDL_UnlockMutex( mILMutex_ );
+	return decodeMemory( type, &buffer[0], (unsigned)size, image, error );
+}
+
+bool
+TextureDecoder::decodeMemory( ILenum type, void const* data, unsigned size, ImageData& image, std::string& error ) {
+#ifdef TEXTUREDECODER_LIBJPEG
+	unsigned char const* bytes = static_cast< unsigned char const* >( data );
+	bool jpeg = ( type == IL_JPG || ( type == IL_TYPE_UNKNOWN && size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xD8 ) );
+	// libjpeg keeps its whole state in the decompressor, so JPEGs are decoded by all workers at the same time
+	// the few images it rejects (CMYK) are left to DevIL
+	if( jpeg && decodeJPEG( data, size, image ) )
+		return true;
+#endif
+	SDL_LockMutex( mILMutex_ );
+	if( type == IL_TYPE_UNKNOWN )
+		type = ilDetermineTypeL( data, size );
+	// create a new ILImage
+	ILuint imageID;				// index for DevIL texture
+	ilGenImages(1,&imageID);	// generate IL-ID for texture
+	ilBindImage(imageID);		// bind ID as current Texture
+	if( !ilLoadL( type, data, size ) ) {
+		ilDeleteImages(1,&imageID);
+		SDL_UnlockMutex( mILMutex_ );
+		error = "Could not load Imagefile.";
+		return false;
+	}
+	unsigned char* texData = ilGetData();
+	if( texData == NULL ) {
+		ilDeleteImages(1,&imageID);
+		SDL_UnlockMutex( mILMutex_ );
+		error = "Could not retrieve Texture Data of ImageFile. Maybe the file is corrupted.";
+		return false;
+	}
+	// get the texture properties
+	image.width		 = ilGetInteger( IL_IMAGE_WIDTH );
+	image.height	 = ilGetInteger( IL_IMAGE_HEIGHT );
+	image.components = ilGetInteger( IL_IMAGE_BYTES_PER_PIXEL );
+	image.format	 = ilGetInteger( IL_IMAGE_FORMAT );
+	image.pixels.assign( texData, texData + image.width * image.height * image.components );
+	// free memory of DevIL
+	ilDeleteImages(1,&imageID);
+	SDL_UnlockMutex( mILMutex_ );
+	return true;
+}
+
+#ifdef TEXTUREDECODER_LIBJPEG
+bool
+TextureDecoder::decodeJPEG( void const* data, unsigned size, ImageData& image ) {
+	PROFILE_ZONE( "TextureDecoder::decodeJPEG" );
+	jpeg_decompress_struct info;
+	JPEGError error;
+	jpeg_source_mgr source;
+	info.err = jpeg_std_error( &error.manager );
+	error.manager.error_exit = jpegErrorExit;
+	error.manager.output_message = jpegOutputMessage;
+	if( setjmp( error.jump ) ) {
+		// libjpeg failed somewhere below
+		jpeg_destroy_decompress( &info );
+		return false;
+	}
+	jpeg_create_decompress( &info );
+	source.next_input_byte = static_cast< JOCTET const* >( data );
+	source.bytes_in_buffer = size;
+	source.init_source = jpegInitSource;
+	source.fill_input_buffer = jpegFillInputBuffer;
+	source.skip_input_data = jpegSkipInputData;
+	source.resync_to_restart = jpeg_resync_to_restart;
+	source.term_source = jpegTermSource;
+	info.src = &source;
+	jpeg_read_header( &info, TRUE );
+	if( info.jpeg_color_space == JCS_CMYK || info.jpeg_color_space == JCS_YCCK ) {
+		jpeg_destroy_decompress( &info );
+		return false;
+	}
+	// the same layout DevIL returns: RGB or luminance, the rows from the top to the bottom of the image
+	info.out_color_space = ( info.num_components == 1 ) ? JCS_GRAYSCALE : JCS_RGB;
+	jpeg_start_decompress( &info );
+	image.width = info.output_width;
+	image.height = info.output_height;
+	image.components = info.output_components;
+	image.format = ( image.components == 1 ) ? IL_LUMINANCE : IL_RGB;
+	image.pixels.resize( image.width * image.height * image.components );
+	while( info.output_scanline < info.output_height ) {
+		JSAMPROW row = &image.pixels[info.output_scanline * image.width * image.components];
+		jpeg_read_scanlines( &info, &row, 1 );
+	}
+	jpeg_finish_decompress( &info );
+	jpeg_destroy_decompress( &info );
+	return true;
+}
+#endif
+
+bool
+TextureDecoder::decodeEntry( AssetEntry const& entry, std::string const& name, ImageData& image, std::string& error ) {
+	std::vector< unsigned char > buffer;
+	void const* data = NULL;
+	unsigned size = 0;
+	if( entry.archive == NULL || !entry.archive->read( entry, buffer, data, size ) ) {
+		error = "Could not read Imagefile '" + name + "' from its archive.";
+		return false;
+	}
+	if( size == 0 ) {
+		error = "Imagefile '" + name + "' is empty.";
+		return false;
+	}
+	SDL_LockMutex( mILMutex_ );
+	ILenum type = ilTypeFromExt( name.c_str() );
+	SDL_UnlockMutex( mILMutex_ );
+	return decodeMemory( type, data, size, image, error );
+}
+
+bool
+TextureDecoder::encodeFile( std::string const& path, ImageData const& image, std::string& error ) {
+	if( image.width == 0 || image.height == 0 || image.pixels.size() < image.width * image.height * image.components ) {
+		error = "The image for '" + path + "' is empty.";
+		return false;
+	}
+	std::string::size_type dot = path.rfind( '.' );
+	if( dot != std::string::npos && path.substr( dot ) == ".ppm" ) {
+		// a binary PPM needs no library at all: a small header followed by the RGB rows from top to bottom
+		if( image.components < 3 ) {
+			error = "Only RGB and RGBA images can be written as PPM.";
+			return false;
+		}
+		std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+		if( !file ) {
+			error = "Could not open '" + path + "' for writing.";
+			return false;
+		}
+		file << "P6\n" << image.width << " " << image.height << "\n255\n";
+		std::vector< char > row( image.width * 3 );
+		for( unsigned y = image.height; y > 0; --y ) {
+			unsigned char const* src = &image.pixels[( y - 1 ) * image.width * image.components];
+			for( unsigned x = 0; x < image.width; ++x, src += image.components ) {
+				row[x * 3 + 0] = (char)src[0];
+				row[x * 3 + 1] = (char)src[1];
+				row[x * 3 + 2] = (char)src[2];
+			}
+			file.write( &row[0], (std::streamsize)row.size() );
+		}
+		if( !file ) {
+			error = "Could not write '" + path + "'.";
+			return false;
+		}
+		return true;
+	}
+
+	SDL_LockMutex( mILMutex_ );
+	ILuint imageID;
+	ilGenImages(1,&imageID);
+	ilBindImage(imageID);
+	// DevIL copies the pixels, its default origin is the lower left corner like the one of OpenGL
+	bool success = ilTexImage( image.width, image.height, 1, (ILubyte)image.components, image.format, IL_UNSIGNED_BYTE,
+							   const_cast< unsigned char* >( &image.pixels[0] ) ) == IL_TRUE;
+	if( success ) {
+		ilEnable( IL_FILE_OVERWRITE );
+		success = ilSaveImage( path.c_str() ) == IL_TRUE;
+	}
+	ilDeleteImages(1,&imageID);
+	SDL_UnlockMutex( mILMutex_ );
+	if( !success )
+		error = "Could not encode '" + path + "'. Maybe the format is not supported by DevIL.";
+	return success;
+}
+
+unsigned
+TextureDecoder::getProcessorCount() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	long count = (long)info.dwNumberOfProcessors;
+#else
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+	if( count < 1 )
+		count = 1;
+	return (unsigned)count;
+}
+
+TextureDecoder::~TextureDecoder() {
+	// stop the workers
+	SDL_LockMutex( mMutex_ );
+	mQuit_ = true;
+	SDL_CondBroadcast( mCond_ );
+	SDL_UnlockMutex( mMutex_ );
+	for( unsigned i = 0; i < mThreads_.size(); ++i )
+		SDL_WaitThread( mThreads_[i], NULL );
+	mThreads_.clear();
+
+	// delete the jobs nobody collected
+	std::list< DecodeJob* >::iterator it;
+	for( it = mQueue_.begin(); it != mQueue_.end(); ++it )
+		delete *it;
+	for( it = mFinished_.begin(); it != mFinished_.end(); ++it )
+		delete *it;
+	mQueue_.clear();
+	mFinished_.clear();
+
+	SDL_DestroyCond( mCond_ );
+	SDL_DestroyMutex( mMutex_ );
+	SDL_DestroyMutex( mILMutex_ );
+}
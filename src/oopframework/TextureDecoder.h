@@ -0,0 +1,175 @@
+#ifndef TEXTUREDECODER
+#define TEXTUREDECODER
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <IL/il.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_thread.h>
+#include <SDL/SDL_mutex.h>
+
+#include <TextureCache.h>
+#include <AssetArchive.h>
+
+#include <list>
+#include <vector>
+#include <string>
+
+class Texture;
+
+/** This struct holds the decoded pixels of an image in client memory.
+ * @brief Decoded image data.
+ */
+struct ImageData {
+	unsigned width;		//!< The width of the image
+	unsigned height;	//!< The height of the image
+	unsigned components;	//!< The number of bytes per pixel
+	unsigned format;	//!< The pixel format (the IL formats are equal to the OpenGL formats)
+	std::vector< unsigned char > pixels;	//!< The pixel data (rows are tightly packed)
+
+	ImageData() : width(0), height(0), components(0), format(0) {}
+};
+
+/** This struct describes one texture, which has to be decoded in the background.
+ * @brief A decode job of the TextureDecoder.
+ */
+struct DecodeJob {
+	Texture*	target;		//!< The texture to upload the pixels to. NULL if the texture was deleted before it was ready.
+	std::string path;		//!< The full path of the image file
+	AssetEntry	entry;		//!< The entry of the image if it is packed in an archive (entry.archive is NULL for plain files)
+	GLuint		texType;	//!< The type of texture (GL_TEXTURE_2D_ARRAY_EXT for a layer of an array texture)
+	unsigned	layer;		//!< The layer of the array texture the image is decoded for
+	unsigned	layerWidth;	//!< The width every layer of the array texture is resampled to
+	unsigned	layerHeight;	//!< The height every layer of the array texture is resampled to
+	GLuint		minFilter;	//!< The min filter to use
+	GLuint		magFilter;	//!< The mag filter to use
+	bool		dstFormat;	//!< The destination format flag of TextureManager::loadTexture()
+	bool		generateMipMaps;	//!< If true, mipmaps have to be created
+	bool		useCache;	//!< If true, the compressed texture is read from the on-disk cache if it is up to date
+	unsigned	maxSize;	//!< Images bigger than this are scaled down after decoding (0 keeps the size)
+	unsigned	sourceWidth;	//!< The width of the image before it was scaled down
+	unsigned	sourceHeight;	//!< The height of the image before it was scaled down
+	bool		buildMipMaps;	//!< If true, the mip chain is built by the worker
+	bool		gammaCorrect;	//!< If true, the mip chain is built in linear space
+	std::vector< ImageData > mipLevels;	//!< The levels 1 to n of the mip chain
+	std::vector< ImageData > faces;	//!< The six faces, if texType is GL_TEXTURE_CUBE_MAP (the image is a panorama then)
+	std::vector< std::vector< ImageData > > faceMipLevels;	//!< The levels 1 to n of the mip chain of every face
+	unsigned	mipTime;	//!< The time the worker needed to build the mip chain in ms
+	ImageData	image;		//!< The decoded image
+	CompressedImage compressed;	//!< The compressed texture, if it was read from the cache
+	bool		fromCache;	//!< true if compressed was read from the cache instead of decoding the image
+	bool		success;	//!< true if the image was decoded successfully
+	std::string error;		//!< The reason of the failure, if the image could not be decoded
+};
+
+/** This class decodes images on a pool of worker threads.
+ * DevIL keeps a global state (the bound image), so its decodes are serialized by a mutex, but still run outside of
+ * the render thread. Compiled with TEXTUREDECODER_LIBJPEG, the JPEGs are decoded by libjpeg instead, which keeps no
+ * global state, so the workers decode them at the same time. The finished jobs have to be collected with
+ * popFinished() by the thread owning the OpenGL context, because only this thread is allowed to upload the pixels.
+ * @brief Decodes images in the background.
+ * @note The workers never log. The errors are stored in the finished job and reported by the thread collecting it.
+ */
+class TextureDecoder {
+	public:
+		/** Creates a decoder. The worker threads are started on the first call of enqueue().
+		 * @param numThreads The number of worker threads. If 0 the number of processors is used.
+		 */
+		TextureDecoder( unsigned numThreads = 0 );
+		/** Stops all workers and deletes all jobs which were not collected.
+		 */
+		~TextureDecoder();
+		/** Adds a job to the queue. The decoder takes the ownership of the job until it is returned by popFinished().
+		 * @param job The job to decode.
+		 */
+		void enqueue( DecodeJob* job );
+		/** Get the next decoded job.
+		 * @return A job which was decoded (successfully or not) or NULL if there is none. The caller has to delete the job.
+		 */
+		DecodeJob* popFinished();
+		/** Detaches a texture from all of its jobs, e.g. because it was deleted before it was ready.
+		 * Queued jobs are dropped, running jobs are finished but will return a NULL target.
+		 * @param target The texture to detach.
+		 */
+		void cancel( Texture const* target );
+		/** Get the number of jobs which were not collected yet.
+		 * @return The number of queued, running and finished jobs.
+		 */
+		unsigned getPendingCount();
+		/** This function decodes an image file. It is safe to call it from any thread.
+		 * @param path The full path of the file.
+		 * @param image The image to store the pixels in.
+		 * @param error The reason of a failure.
+		 * @return true if the image was decoded successfully.
+		 */
+		bool decodeFile( std::string const& path, ImageData& image, std::string& error );
+		/** This function decodes an image which is already in memory. It is safe to call it from any thread.
+		 * @param type The IL type of the image (IL_JPG, ...) or IL_TYPE_UNKNOWN to detect it.
+		 * @param data The encoded image.
+		 * @param size The size of the encoded image in bytes.
+		 * @param image The image to store the pixels in.
+		 * @param error The reason of a failure.
+		 * @return true if the image was decoded successfully.
+		 */
+		bool decodeMemory( ILenum type, void const* data, unsigned size, ImageData& image, std::string& error );
+		/** This function decodes an image which is packed in an archive. It is safe to call it from any thread.
+		 * Stored entries are handed to DevIL straight from the mapping of the archive.
+		 * @param entry The entry of the image.
+		 * @param name The name of the image, its extension determines the IL type.
+		 * @param image The image to store the pixels in.
+		 * @param error The reason of a failure.
+		 * @return true if the image was decoded successfully.
+		 */
+		bool decodeEntry( AssetEntry const& entry, std::string const& name, ImageData& image, std::string& error );
+		/** This function writes an image into a file. It is safe to call it from any thread.
+		 * Files ending with '.ppm' are written directly (RGB only), all other formats are encoded by DevIL.
+		 * @param path The path of the file, its extension determines the format.
+		 * @param image The image to write. Row 0 is the bottom of the image, like the result of glReadPixels().
+		 * @param error The reason of a failure.
+		 * @return true if the file was written successfully.
+		 */
+		bool encodeFile( std::string const& path, ImageData const& image, std::string& error );
+		/** Get the number of processors of the machine.
+		 * @return The number of online processors, at least 1.
+		 */
+		static unsigned getProcessorCount();
+
+	private:
+		/** The entry point of the worker threads.
+		 * @param data A pointer to the TextureDecoder.
+		 */
+		static int SDLCALL workerMain( void* data );
+		/** The loop of one worker thread.
+		 */
+		void work();
+		/** This internal function starts the worker threads if not done yet.
+		 */
+		void startThreads();
+		/** This internal function executes a job: it reads the cache or decodes the image.
+		 * @param job The job to execute.
+		 */
+		void process( DecodeJob* job );
+#ifdef TEXTUREDECODER_LIBJPEG
+		/** This internal function decodes a JPEG with libjpeg. It needs no lock, every call has its own decompressor.
+		 * @param data The encoded image.
+		 * @param size The size of the encoded image in bytes.
+		 * @param image The image to store the pixels in.
+		 * @return true if the image was decoded, false if it is broken or has to be decoded by DevIL (CMYK).
+		 */
+		static bool decodeJPEG( void const* data, unsigned size, ImageData& image );
+#endif
+
+		unsigned mNumThreads_;			//!< The number of worker threads to start
+		std::vector< SDL_Thread* > mThreads_;	//!< The running worker threads
+		SDL_mutex* mMutex_;				//!< Guards the job lists and the quit flag
+		SDL_cond*  mCond_;				//!< Signals new jobs to the workers
+		SDL_mutex* mILMutex_;			//!< Serializes the calls into DevIL (libjpeg needs no lock)
+		std::list< DecodeJob* > mQueue_;		//!< The jobs waiting for a worker
+		std::list< DecodeJob* > mRunning_;		//!< The jobs being decoded right now
+		std::list< DecodeJob* > mFinished_;		//!< The decoded jobs waiting for the upload
+		bool mQuit_;					//!< If true the workers will stop
+};
+
+#endif
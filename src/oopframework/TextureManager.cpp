@@ -1,4 +1,9 @@
 #include <TextureManager.h>
+#include <ImageFilter.h>
+#include <GLStateCache.h>
+#include <Profiler.h>
+
+#include <algorithm>
 
 // SINGLETON
 TextureManager* TextureManager::mInstance_ = NULL;
@@ -17,7 +22,71 @@ TextureManager::getSingletonPtr( ) {
   return mInstance_;
 }
 
-TextureManager::TextureManager() {
+TextureManager::TextureManager() :
+	mMaxTextureSize_(0),
+	mMaxCubeMapSize_(0),
+	mMaxArrayLayers_(0),
+	mPlaceholder_(0),
+	mPlaceholderCube_(0),
+	mCompression_(false),
+	mCPUMipMaps_(true),
+	mGammaMipMaps_(false) {
+	// the maximum texture size is queried once, so it is also known outside of the render thread
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &mMaxTextureSize_);
+	if( GLEW_VERSION_1_3 )
+		glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &mMaxCubeMapSize_);
+	if( GLEW_EXT_texture_array && GLEW_VERSION_1_2 )
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS_EXT, &mMaxArrayLayers_);
+}
+
+unsigned
+TextureManager::internPath( std::string const& tex ) {
+	// the IDs start with 1, 0 is the ID of textures which were not loaded by the TextureManager
+	std::pair< PathIDMap::iterator, bool > res = mPathIDs_.insert( PathIDMap::value_type( tex, (unsigned)mPathIDs_.size() + 1 ) );
+	return res.first->second;
+}
+
+Texture*
+TextureManager::findTexture( std::string const& tex ) {
+	// only the textures which are registered intern their paths, so a failed lookup leaves no entry behind
+	PathIDMap::const_iterator id = mPathIDs_.find( tex );
+	if( id == mPathIDs_.end() )
+		return NULL;
+	TexturePool::iterator it = mTexturePool_.find( id->second );
+	if( it != mTexturePool_.end() )
+		return it->second;
+	return NULL;
+}
+
+Texture*
+TextureManager::addTexture( Texture const& unit ) {
+	Texture* t = new Texture( unit );
+	t->pathID = internPath( t->name );
+	if( t->isPrivate )
+		mPrivateTextures_.insert( t );
+	else
+		mTexturePool_[t->pathID] = t;
+	return t;
+}
+
+std::string
+TextureManager::resolvePath( std::string const& tex, AssetEntry& entry ) {
+	RessourceManager* rm = RessourceManager::getSingletonPtr();
+	// packed files are preferred, they are read without touching the filesystem
+	if( rm->findArchived( tex, entry ) )
+		return entry.archive->getPath() + "/" + tex;
+	std::string path = rm->getPath( tex );
+	if( path.empty() )
+		return path;
+	return path + tex;
+}
+
+std::string
+TextureManager::getPoolName( std::string const& tex, GLuint texType ) {
+	// a panorama may be used as a 2D texture and as a cube map at the same time
+	if( texType == GL_TEXTURE_CUBE_MAP )
+		return tex + "#cubemap";
+	return tex;
 }
 
 Texture*
@@ -25,136 +94,560 @@ TextureManager::loadTexture( std::string tex, GLuint texType,
 							 GLuint minFilter, GLuint magFilter, bool dstFormat, bool forceReload ) {
      
 	// get the full path of the texture
-	tex = RessourceManager::getSingletonPtr()->getPath( tex ) + tex;
+	AssetEntry entry;
+	std::string path = resolvePath( tex, entry );
+	if( !path.empty() )
+		tex = path;
     // check the parameters
 	bool generateMipMaps = checkParamState( texType, minFilter, magFilter );
 
-	LogManager* l = LogManager::getSingletonPtr();
-	std::stringstream log;
 	if( !forceReload ) {
-		log << "TextureManager: Searching in Texturepool for texture '" << tex << "'...";
-		l->logMessage( log );
-		std::list< Texture >::iterator it = mTexturePool_.begin();
-		while( it != mTexturePool_.end() ) {
-			if( tex == it->name && !it->isPrivate ) {
-				log.str("");
-				log << "TextureManager: done. Texture is previousely loaded. No load required.\n";
-				l->logMessage( log );
-				it->refCnt += 1;
-				return &(*it);
-			}
-			++it;
+		LOG_DEBUG( TEXTURE, "TextureManager: Searching in Texturepool for texture '" << tex << "'..." );
+		Texture* t = findTexture( getPoolName( tex, texType ) );
+		if( t != NULL ) {
+			LOG_DEBUG( TEXTURE, "TextureManager: done. Texture is previousely loaded. No load required.\n" );
+			t->refCnt += 1;
+			return t;
 		}
-		log.str("");
-		log << "TextureManager: done.\nTexture wasn't loaded before so we try to load it now...";
-		l->logMessage( log );
+		LOG_DEBUG( TEXTURE, "TextureManager: done.\nTexture wasn't loaded before so we try to load it now..." );
 	}
 	else {
-		log.str("");
-		log << "TextureManager: Try to load the Texture now...";
-		l->logMessage( log );
+		LOG_DEBUG( TEXTURE, "TextureManager: Try to load the Texture now..." );
 	}
 	
-	// create a new ILImage
-	ILuint imageID;				// index for DevIL texture
-	ilGenImages(1,&imageID);	// generate IL-ID for texture
-	ilBindImage(imageID);		// bind ID as current Texture
-	// get the Data from IL
-	ILboolean ret = ilLoadImage ( tex.c_str() );
-
-	if( !ret ) {
-		ilDeleteImages(1,&imageID);
-		log.str("");
-		log << "TextureManager Error: Could not load Imagefile '" << tex << "'.";
-		l->logMessage( log );
+	// create a new Texture
+	Texture unit;
+	unit.texType = texType;
+	unit.minFilter = minFilter;
+	unit.magFilter = magFilter;
+	unit.mipMaps = generateMipMaps;
+	unit.name = getPoolName( tex, texType );
+	unit.refCnt = 1;
+	unit.isPrivate = forceReload;
+
+	// try the compressed cache first
+	bool uploaded = false;
+	std::string error;
+	if( mCompression_ && dstFormat == true && entry.archive == NULL && texType != GL_TEXTURE_CUBE_MAP && TextureCache::isValid( tex ) ) {
+		CompressedImage compressed;
+		if( TextureCache::read( tex, getCacheSettings( generateMipMaps ), compressed, error ) )
+			uploaded = uploadCompressed( compressed, unit );
+	}
+	if( !uploaded ) {
+		// get the Data from IL
+		ImageData image;
+		bool decoded = ( entry.archive != NULL ) ? mDecoder_.decodeEntry( entry, tex, image, error )
+												 : mDecoder_.decodeFile( tex, image, error );
+		if( !decoded ) {
+			LOG_ERROR( TEXTURE, "TextureManager: " << error << " (" << tex << ")" );
+			return NULL;
+		}
+		if( texType == GL_TEXTURE_CUBE_MAP ) {
+			std::vector< ImageData > faces;
+			ImageFilter::equirectToCube( image, mMaxCubeMapSize_, faces );
+			std::vector< std::vector< ImageData > > mipLevels;
+			if( generateMipMaps && mCPUMipMaps_ ) {
+				mipLevels.resize( faces.size() );
+				for( unsigned i = 0; i < faces.size(); ++i )
+					ImageFilter::buildMipChain( faces[i], mipLevels[i], mGammaMipMaps_ );
+			}
+			if( !uploadCubeMap( faces, &mipLevels, unit, dstFormat ) )
+				return NULL;
+			LOG_INFO( TEXTURE, "TextureManager: Cube map successfully loaded" );
+			return addTexture( unit );
+		}
+		// scale the image down if it is bigger than the machine supports
+		unsigned sourceWidth = image.width;
+		unsigned sourceHeight = image.height;
+		if( ImageFilter::fitToSize( image, mMaxTextureSize_ ) ) {
+			LOG_INFO( TEXTURE, "TextureManager: Scaled Texture '" << tex << "' down from " << sourceWidth << "x" << sourceHeight << " to " << image.width << "x" << image.height << " Pixels." );
+		}
+		std::vector< ImageData > mipLevels;
+		if( generateMipMaps && mCPUMipMaps_ ) {
+			Uint32 start = SDL_GetTicks();
+			ImageFilter::buildMipChain( image, mipLevels, mGammaMipMaps_ );
+			LOG_INFO( TEXTURE, "TextureManager: Built " << mipLevels.size() << " mip levels in " << ( SDL_GetTicks() - start ) << " ms." );
+		}
+		if( !uploadTexture( image, &mipLevels, unit, dstFormat, entry.archive == NULL ) )
+			return NULL;
+	}
+
+	LOG_INFO( TEXTURE, "TextureManager: Texture successfully loaded" );
+	// save the loaded texture in the texture pool
+	return addTexture( unit );
+}
+
+Texture*
+TextureManager::loadTextureAsync( std::string tex, GLuint texType, 
+								  GLuint minFilter, GLuint magFilter, bool dstFormat ) {
+	// get the full path of the texture
+	AssetEntry entry;
+	std::string path = resolvePath( tex, entry );
+	if( path.empty() ) {
+		LOG_ERROR( TEXTURE, "TextureManager: Could not load Imagefile '" << tex << "'." );
+		return NULL;
+	}
+	tex = path;
+	// check the parameters
+	bool generateMipMaps = checkParamState( texType, minFilter, magFilter );
+
+	Texture* t = findTexture( getPoolName( tex, texType ) );
+	if( t != NULL ) {
+		LOG_DEBUG( TEXTURE, "TextureManager: Texture '" << tex << "' is previousely loaded. No load required." );
+		t->refCnt += 1;
+		return t;
+	}
+
+	// the placeholder is bound until the pixels are uploaded
+	Texture unit;
+	unit.texID = getPlaceholder( texType );
+	unit.texType = texType;
+	unit.minFilter = minFilter;
+	unit.magFilter = magFilter;
+	unit.mipMaps = generateMipMaps;
+	unit.name = getPoolName( tex, texType );
+	unit.refCnt = 1;
+	unit.isPrivate = false;
+	unit.width = 1;
+	unit.height = 1;
+	unit.loaded = false;
+	DecodeJob* job = new DecodeJob();
+	job->target = addTexture( unit );
+	job->path = tex;
+	job->entry = entry;
+	job->texType = texType;
+	job->layer = 0;
+	job->layerWidth = 0;
+	job->layerHeight = 0;
+	job->minFilter = minFilter;
+	job->magFilter = magFilter;
+	job->dstFormat = dstFormat;
+	job->generateMipMaps = generateMipMaps;
+	bool cubeMap = ( texType == GL_TEXTURE_CUBE_MAP );
+	job->useCache = mCompression_ && dstFormat == true && entry.archive == NULL && !cubeMap;
+	job->maxSize = (unsigned)( cubeMap ? mMaxCubeMapSize_ : mMaxTextureSize_ );
+	job->buildMipMaps = generateMipMaps && mCPUMipMaps_;
+	job->gammaCorrect = mGammaMipMaps_;
+	job->mipTime = 0;
+	job->sourceWidth = 0;
+	job->sourceHeight = 0;
+	job->success = false;
+	job->fromCache = false;
+	mDecoder_.enqueue( job );
+
+	LOG_DEBUG( TEXTURE, "TextureManager: Texture '" << tex << "' queued for decoding in the background." );
+	return job->target;
+}
+
+Texture*
+TextureManager::loadTextureArray( std::vector< std::string > const& textures, unsigned width, unsigned height,
+								  GLuint minFilter, GLuint magFilter ) {
+	if( !isTextureArraySupported() ) {
+		LOG_WARNING( TEXTURE, "TextureManager: Array textures are not supported by this machine." );
+		return NULL;
+	}
+	unsigned layers = (unsigned)textures.size();
+	if( layers == 0 || layers > (unsigned)mMaxArrayLayers_ || width == 0 || height == 0 ) {
+		LOG_WARNING( TEXTURE, "TextureManager: An array texture needs 1 to " << mMaxArrayLayers_ << " layers, " << layers << " were requested." );
 		return NULL;
 	}
-	unsigned char * texData = ilGetData();
+	GLuint texType = GL_TEXTURE_2D;
+	bool generateMipMaps = checkParamState( texType, minFilter, magFilter );
+	if( width > (unsigned)mMaxTextureSize_ || height > (unsigned)mMaxTextureSize_ ) {
+		double scale = (double)mMaxTextureSize_ / (double)std::max( width, height );
+		width = std::max( 1u, (unsigned)( width * scale ) );
+		height = std::max( 1u, (unsigned)( height * scale ) );
+	}
 
-	// check if something is wrong
-	if( texData == NULL ) {
-		ilDeleteImages(1,&imageID);
-		log.str("");
-		log << "TextureManager Error: Could not retrieve Texture Data of ImageFile '" << tex << "'. Maybe the file is corrupted.";
-		l->logMessage( log );
+	// find all images before anything is created
+	std::vector< std::string > paths( layers );
+	std::vector< AssetEntry > entries( layers );
+	unsigned found = 0;
+	for( unsigned i = 0; i < layers; ++i ) {
+		paths[i] = resolvePath( textures[i], entries[i] );
+		if( paths[i].empty() )
+			LOG_ERROR( TEXTURE, "TextureManager: Could not load Imagefile '" << textures[i] << "'." );
+		else
+			++found;
+	}
+	if( found == 0 )
 		return NULL;
+
+	// the storage of all layers and mip levels, grey until the images are uploaded
+	GLuint GLtexture;
+	glGenTextures(1, &GLtexture);
+	GLStateCache::getSingletonPtr()->bindTexture( GL_TEXTURE_2D_ARRAY_EXT, GLtexture );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, minFilter );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, magFilter );
+	glTexParameterf( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_S, GL_REPEAT );
+	glTexParameterf( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	std::vector< unsigned char > grey( width * height * 3, 128 );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	unsigned levelWidth = width, levelHeight = height;
+	for( GLint level = 0; ; ++level ) {
+		// the layers may have different formats, RGBA takes all of them
+		glTexImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, GL_RGBA8, levelWidth, levelHeight, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL );
+		for( unsigned i = 0; i < layers; ++i )
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, 0, 0, i, levelWidth, levelHeight, 1, GL_RGB, GL_UNSIGNED_BYTE, &grey[0] );
+		// the levels shrink like the ones of ImageFilter::buildMipChain()
+		if( !generateMipMaps || ( levelWidth == 1 && levelHeight == 1 ) )
+			break;
+		levelWidth = std::max( 1u, levelWidth / 2 );
+		levelHeight = std::max( 1u, levelHeight / 2 );
 	}
-	else {
-		// get the texture properties
-		unsigned width		= ilGetInteger( IL_IMAGE_WIDTH );
-		unsigned height		= ilGetInteger( IL_IMAGE_HEIGHT );	
-		unsigned components = ilGetInteger( IL_IMAGE_BYTES_PER_PIXEL );
-		unsigned format		= ilGetInteger( IL_IMAGE_FORMAT );	
-		log.str("");
-		log << "TextureManager: Properties:" << 
-				" width = " << width <<  
-				" height = " << height <<  
-				" components = " << components <<  
-				" format = " << format;
-		l->logMessage( log );	
-
-		// now we check if the width and height of the image is too big for the current machine
-		GLint texSize; 
-		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &texSize);
-		if( width > (unsigned)texSize ||
-			height > (unsigned)texSize ) {
-			log.str("");
-			log << "TextureManager Warning: The dimensions of the Texture '" << tex << "' are bigger than the maximum supported dimension of " << texSize << "Pixels.\n";
-			l->logMessage( log );	
-			return NULL;
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	Texture unit;
+	unit.texID = GLtexture;
+	unit.texType = GL_TEXTURE_2D_ARRAY_EXT;
+	unit.minFilter = minFilter;
+	unit.magFilter = magFilter;
+	unit.mipMaps = generateMipMaps;
+	unit.name = "array:" + textures[0];
+	unit.refCnt = 1;
+	unit.isPrivate = true;
+	unit.width = width;
+	unit.height = height;
+	unit.depth = layers;
+	unit.loaded = false;
+	Texture* t = addTexture( unit );
+	for( unsigned i = 0; i < layers; ++i ) {
+		if( paths[i].empty() )
+			continue;
+		DecodeJob* job = new DecodeJob();
+		job->target = t;
+		job->path = paths[i];
+		job->entry = entries[i];
+		job->texType = GL_TEXTURE_2D_ARRAY_EXT;
+		job->layer = i;
+		job->layerWidth = width;
+		job->layerHeight = height;
+		job->minFilter = minFilter;
+		job->magFilter = magFilter;
+		job->dstFormat = true;
+		job->generateMipMaps = generateMipMaps;
+		job->useCache = false;
+		job->maxSize = 0;
+		job->buildMipMaps = generateMipMaps;
+		job->gammaCorrect = mGammaMipMaps_;
+		job->mipTime = 0;
+		job->sourceWidth = 0;
+		job->sourceHeight = 0;
+		job->success = false;
+		job->fromCache = false;
+		mDecoder_.enqueue( job );
+	}
+	mPendingLayers_[t] = found;
+	LOG_INFO( TEXTURE, "TextureManager: Packing " << found << " textures into an array texture of " << layers << " layers with " << width << "x" << height << " Pixels." );
+	return t;
+}
+
+bool
+TextureManager::isTextureArraySupported() const {
+	return mMaxArrayLayers_ > 0;
+}
+
+unsigned
+TextureManager::processPendingUploads( unsigned maxUploads ) {
+	PROFILE_ZONE( "TextureManager::processPendingUploads" );
+	unsigned uploads = 0;
+	while( maxUploads == 0 || uploads < maxUploads ) {
+		DecodeJob* job = mDecoder_.popFinished();
+		if( job == NULL )
+			break;
+		if( job->target == NULL ) {
+			// the texture was deleted while it was decoded
+			delete job;
+			continue;
+		}
+		if( job->fromCache && !uploadCompressed( job->compressed, *job->target ) ) {
+			// the cache can't be used - decode the image instead
+			job->useCache = false;
+			job->fromCache = false;
+			job->compressed.levels.clear();
+			mDecoder_.enqueue( job );
+			continue;
+		}
+		if( !job->success ) {
+			LOG_ERROR( TEXTURE, "TextureManager: " << job->error << " (" << job->path << ")" );
+		}
+		else if( job->texType == GL_TEXTURE_2D_ARRAY_EXT ) {
+			uploadLayer( *job );
+			LOG_INFO( TEXTURE, "TextureManager: Texture '" << job->path << "' successfully packed into layer " << job->layer << " in the background" );
+		}
+		else if( job->texType == GL_TEXTURE_CUBE_MAP ) {
+			if( uploadCubeMap( job->faces, &job->faceMipLevels, *job->target, job->dstFormat ) ) {
+				job->target->loaded = true;
+				if( !job->faceMipLevels.empty() ) {
+					LOG_INFO( TEXTURE, "TextureManager: Built " << job->faceMipLevels[0].size() << " mip levels of the faces of cube map '" << job->path << "' in " << job->mipTime << " ms." );
+				}
+				LOG_INFO( TEXTURE, "TextureManager: Cube map '" << job->path << "' successfully loaded in the background" );
+			}
 		}
+		else if( job->fromCache || uploadTexture( job->image, &job->mipLevels, *job->target, job->dstFormat, job->entry.archive == NULL ) ) {
+			job->target->loaded = true;
+			if( !job->fromCache && ( job->sourceWidth != job->image.width || job->sourceHeight != job->image.height ) ) {
+				LOG_INFO( TEXTURE, "TextureManager: Scaled Texture '" << job->path << "' down from " << job->sourceWidth << "x" << job->sourceHeight << " to " << job->image.width << "x" << job->image.height << " Pixels." );
+			}
+			if( !job->mipLevels.empty() ) {
+				LOG_INFO( TEXTURE, "TextureManager: Built " << job->mipLevels.size() << " mip levels of Texture '" << job->path << "' in " << job->mipTime << " ms." );
+			}
+			LOG_INFO( TEXTURE, "TextureManager: Texture '" << job->path << "' successfully loaded in the background" );
+		}
+		if( job->texType == GL_TEXTURE_2D_ARRAY_EXT ) {
+			// the array is complete when the last of its layers arrived, a failed one stays grey
+			LayerCountMap::iterator it = mPendingLayers_.find( job->target );
+			if( it != mPendingLayers_.end() && --it->second == 0 ) {
+				job->target->loaded = true;
+				mPendingLayers_.erase( it );
+			}
+		}
+		++uploads;
+		delete job;
+	}
+	return mDecoder_.getPendingCount();
+}
+
+bool
+TextureManager::uploadTexture( ImageData const& image, std::vector< ImageData > const* mipLevels, Texture& unit, bool dstFormat, bool storeCache ) {
+	PROFILE_ZONE( "TextureManager::uploadTexture" );
+	LOG_DEBUG( TEXTURE, "TextureManager: Properties:" << 
+			" width = " << image.width <<  
+			" height = " << image.height <<  
+			" components = " << image.components <<  
+			" format = " << image.format );
+
+	// now we check if the width and height of the image is too big for the current machine
+	if( image.width > (unsigned)mMaxTextureSize_ ||
+		image.height > (unsigned)mMaxTextureSize_ ) {
+		LOG_WARNING( TEXTURE, "TextureManager: The dimensions of the Texture '" << unit.name << "' are bigger than the maximum supported dimension of " << mMaxTextureSize_ << "Pixels.\n" );
+		return false;
+	}
+
+	// create OpenGL texture
+	GLuint GLtexture;
+	glGenTextures(1, &GLtexture);
+	// bind the texture to the next action we make. It stays bound afterwards, the GLStateCache knows about it
+	GLStateCache::getSingletonPtr()->bindTexture( unit.texType, GLtexture );
+	glTexParameteri( unit.texType, GL_TEXTURE_MIN_FILTER, unit.minFilter );
+	glTexParameteri( unit.texType, GL_TEXTURE_MAG_FILTER, unit.magFilter );
+	glTexParameterf( unit.texType, GL_TEXTURE_WRAP_S, GL_REPEAT );
+	glTexParameterf( unit.texType, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	// let OpenGL create the mipmaps only if they were not built by the TextureManager
+	bool ownMipMaps = unit.mipMaps && mipLevels != NULL && !mipLevels->empty();
+	if( unit.mipMaps && !ownMipMaps )
+		glTexParameteri(unit.texType, GL_GENERATE_MIPMAP, GL_TRUE);	
+	// the rows of the decoded images are tightly packed
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	bool compress = mCompression_ && dstFormat == true && ( image.components == 3 || image.components == 4 );
+	GLint internalFormat = image.components;
+	if( compress ) // let the driver compress the image and its mip levels
+		internalFormat = ( image.components == 4 ) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if( dstFormat != true )
+		internalFormat = dstFormat;
+	glTexImage2D(unit.texType, 0, internalFormat, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE, &image.pixels[0]);
+	if( ownMipMaps ) {
+		for( unsigned i = 0; i < mipLevels->size(); ++i ) {
+			ImageData const& level = (*mipLevels)[i];
+			glTexImage2D(unit.texType, i + 1, internalFormat, level.width, level.height, 0, level.format, GL_UNSIGNED_BYTE, &level.pixels[0]);
+		}
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 
-		// create OpenGL texture
-		GLuint GLtexture;
-		glGenTextures(1, &GLtexture);
-		// bind the texture to the next action we make
-		glBindTexture(   texType, GLtexture );
-		glTexParameteri( texType, GL_TEXTURE_MIN_FILTER, minFilter );
-		glTexParameteri( texType, GL_TEXTURE_MAG_FILTER, magFilter );
-		glTexParameterf( texType, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( texType, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		if( generateMipMaps )
-			glTexParameteri(texType, GL_GENERATE_MIPMAP, GL_TRUE);	
-		// 
-		if( dstFormat == true ) 
-			glTexImage2D(texType, 0, components, width, height, 0, format, GL_UNSIGNED_BYTE, texData);
+	if( compress && storeCache ) {
+		// store the compressed mip chain, so the next run can skip the decoding
+		CompressedImage compressed;
+		std::string error;
+		if( !TextureCache::readBack( unit.texType, compressed ) )
+			LOG_WARNING( TEXTURE, "TextureManager: The driver did not compress the Texture '" << unit.name << "'." );
+		else if( !TextureCache::write( unit.name, getCacheSettings( unit.mipMaps ), compressed, error ) )
+			LOG_WARNING( TEXTURE, "TextureManager: " << error );
 		else
-			glTexImage2D(texType, 0, dstFormat, width, height, 0, format, GL_UNSIGNED_BYTE, texData);
-		// create a new Texture
-		Texture unit;
-		unit.texID = GLtexture;
-		unit.texType = texType;
-		unit.minFilter = minFilter;
-		unit.magFilter = magFilter;
-		unit.mipMaps = generateMipMaps;
-		unit.name = tex;
-		unit.refCnt = 1;
-		unit.isPrivate = forceReload;
-		unit.width = width;
-		unit.height = height;
-
-		log.str("");
-		log << "TextureManager: Texture successfully loaded";
-		l->logMessage( log );		
-		// save the loaded texture in the texture pool
-		mTexturePool_.push_back( unit );
-		// free memory of DevIL
-		ilDeleteImages(1,&imageID);
-		glBindTexture( texType, NULL );
-		return &(mTexturePool_.back());
+			LOG_INFO( TEXTURE, "TextureManager: Stored compressed Texture in '" << TextureCache::getCachePath( unit.name ) << "'." );
 	}
+	unit.texID = GLtexture;
+	unit.width = image.width;
+	unit.height = image.height;
+	return true;
+}
+
+void
+TextureManager::uploadLayer( DecodeJob const& job ) {
+	PROFILE_ZONE( "TextureManager::uploadLayer" );
+	Texture const& unit = *job.target;
+	GLStateCache::getSingletonPtr()->bindTexture( GL_TEXTURE_2D_ARRAY_EXT, unit.texID );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	ImageData const& image = job.image;
+	glTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, 0, 0, 0, job.layer, image.width, image.height, 1, image.format, GL_UNSIGNED_BYTE, &image.pixels[0] );
+	for( unsigned i = 0; i < job.mipLevels.size(); ++i ) {
+		ImageData const& level = job.mipLevels[i];
+		glTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, i + 1, 0, 0, job.layer, level.width, level.height, 1, level.format, GL_UNSIGNED_BYTE, &level.pixels[0] );
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+}
+
+bool
+TextureManager::uploadCubeMap( std::vector< ImageData > const& faces, std::vector< std::vector< ImageData > > const* mipLevels,
+							   Texture& unit, bool dstFormat ) {
+	PROFILE_ZONE( "TextureManager::uploadCubeMap" );
+	if( faces.size() != 6 || faces[0].width == 0 ) {
+		LOG_WARNING( TEXTURE, "TextureManager: The panorama of the cube map '" << unit.name << "' is too small." );
+		return false;
+	}
+	GLuint GLtexture;
+	glGenTextures(1, &GLtexture);
+	GLStateCache::getSingletonPtr()->bindTexture( GL_TEXTURE_CUBE_MAP, GLtexture );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, unit.minFilter );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, unit.magFilter );
+	// the faces must not be filtered across their edges
+	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+	// let OpenGL create the mipmaps only if they were not built by the decoder, like uploadTexture()
+	bool ownMipMaps = unit.mipMaps && mipLevels != NULL && mipLevels->size() == faces.size();
+	if( unit.mipMaps && !ownMipMaps )
+		glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_GENERATE_MIPMAP, GL_TRUE );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	unsigned components = faces[0].components;
+	GLint internalFormat = components;
+	// the compressed faces are not cached, the cache holds a single 2D mip chain
+	if( mCompression_ && dstFormat == true && ( components == 3 || components == 4 ) )
+		internalFormat = ( components == 4 ) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if( dstFormat != true )
+		internalFormat = dstFormat;
+	for( unsigned i = 0; i < 6; ++i ) {
+		ImageData const& face = faces[i];
+		glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, face.width, face.height, 0, face.format, GL_UNSIGNED_BYTE, &face.pixels[0] );
+		if( ownMipMaps ) {
+			std::vector< ImageData > const& levels = (*mipLevels)[i];
+			for( unsigned j = 0; j < levels.size(); ++j ) {
+				ImageData const& level = levels[j];
+				glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, j + 1, internalFormat, level.width, level.height, 0, level.format, GL_UNSIGNED_BYTE, &level.pixels[0] );
+			}
+		}
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+	unit.texID = GLtexture;
+	unit.width = faces[0].width;
+	unit.height = faces[0].height;
+	return true;
+}
+
+CacheSettings
+TextureManager::getCacheSettings( bool mipMaps ) const {
+	return CacheSettings( (unsigned)mMaxTextureSize_, mipMaps, mCPUMipMaps_, mGammaMipMaps_ );
+}
+
+bool
+TextureManager::uploadCompressed( CompressedImage const& image, Texture& unit ) {
+	PROFILE_ZONE( "TextureManager::uploadCompressed" );
+	if( image.levels.empty() )
+		return false;
+	// the cache was written without mipmaps, but the texture needs them
+	if( unit.mipMaps && image.levels.size() == 1 && ( image.levels[0].width > 1 || image.levels[0].height > 1 ) )
+		return false;
+	if( image.levels[0].width > (unsigned)mMaxTextureSize_ ||
+		image.levels[0].height > (unsigned)mMaxTextureSize_ )
+		return false;
+
+	GLuint GLtexture;
+	glGenTextures(1, &GLtexture);
+	GLStateCache::getSingletonPtr()->bindTexture( unit.texType, GLtexture );
+	glTexParameteri( unit.texType, GL_TEXTURE_MIN_FILTER, unit.minFilter );
+	glTexParameteri( unit.texType, GL_TEXTURE_MAG_FILTER, unit.magFilter );
+	glTexParameterf( unit.texType, GL_TEXTURE_WRAP_S, GL_REPEAT );
+	glTexParameterf( unit.texType, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	for( unsigned i = 0; i < image.levels.size(); ++i ) {
+		CompressedLevel const& level = image.levels[i];
+		glCompressedTexImage2D( unit.texType, i, image.internalFormat, level.width, level.height, 0, (GLsizei)level.data.size(), &level.data[0] );
+	}
+	unit.texID = GLtexture;
+	unit.width = image.levels[0].width;
+	unit.height = image.levels[0].height;
+
+	LOG_INFO( TEXTURE, "TextureManager: Texture '" << unit.name << "' loaded from the compressed cache (" << image.levels.size() << " levels)." );
+	return true;
+}
+
+bool
+TextureManager::setTextureCompression( bool enable ) {
+	if( enable && !( GLEW_VERSION_1_3 && GLEW_EXT_texture_compression_s3tc ) ) {
+		LOG_WARNING( TEXTURE, "TextureManager: S3TC texture compression is not supported by this machine." );
+		mCompression_ = false;
+		return false;
+	}
+	mCompression_ = enable;
+	LOG_INFO( TEXTURE, "TextureManager: S3TC texture compression " << ( enable ? "enabled." : "disabled." ) );
+	return mCompression_;
+}
+
+bool
+TextureManager::getTextureCompression() const {
+	return mCompression_;
+}
+
+GLuint
+TextureManager::getPlaceholder( GLuint texType ) {
+	if( texType == GL_TEXTURE_CUBE_MAP ) {
+		if( mPlaceholderCube_ == 0 ) {
+			unsigned char grey[3] = { 128, 128, 128 };
+			glGenTextures(1, &mPlaceholderCube_);
+			GLStateCache::getSingletonPtr()->bindTexture( GL_TEXTURE_CUBE_MAP, mPlaceholderCube_ );
+			glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+			glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+			glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+			for( unsigned i = 0; i < 6; ++i )
+				glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey );
+			glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+		}
+		return mPlaceholderCube_;
+	}
+	if( mPlaceholder_ == 0 ) {
+		// a single grey texel
+		unsigned char grey[3] = { 128, 128, 128 };
+		glGenTextures(1, &mPlaceholder_);
+		GLStateCache::getSingletonPtr()->bindTexture( GL_TEXTURE_2D, mPlaceholder_ );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+	}
+	return mPlaceholder_;
+}
+
+void
+TextureManager::setMipMapGeneration( bool onCPU, bool gammaCorrect ) {
+	mCPUMipMaps_ = onCPU;
+	mGammaMipMaps_ = gammaCorrect;
+}
+
+GLint
+TextureManager::getMaxTextureSize() const {
+	return mMaxTextureSize_;
+}
+
+bool
+TextureManager::saveImage( std::string const& path, ImageData const& image ) {
+	std::string error;
+	if( !mDecoder_.encodeFile( path, image, error ) ) {
+		LOG_ERROR( TEXTURE, "TextureManager: " << error );
+		return false;
+	}
+	return true;
 }
 
 bool
 TextureManager::checkParamState( GLuint& texType, 
 								 GLuint& minFilter, 
 								 GLuint& magFilter ) {
-	LogManager* l = LogManager::getSingletonPtr();
-	std::stringstream log;
 	// check the texture type 
-	if( texType != GL_TEXTURE_2D && texType != GL_TEXTURE_2D ) {
-		log << "TextureManager: Warning: unknown texturetype - setting texturetype to GL_TEXTURE_2D.";
-		l->logMessage( log );
+	if( texType == GL_TEXTURE_CUBE_MAP && mMaxCubeMapSize_ == 0 ) {
+		LOG_WARNING( TEXTURE, "TextureManager: cube maps are not supported - setting texturetype to GL_TEXTURE_2D." );
+		texType = GL_TEXTURE_2D;
+	}
+	if( texType != GL_TEXTURE_2D && texType != GL_TEXTURE_CUBE_MAP ) {
+		LOG_WARNING( TEXTURE, "TextureManager: unknown texturetype - setting texturetype to GL_TEXTURE_2D." );
 		texType = GL_TEXTURE_2D;
 	}
 	// check the minFilter
@@ -163,8 +656,7 @@ TextureManager::checkParamState( GLuint& texType,
 		minFilter != GL_NEAREST_MIPMAP_LINEAR  && 
 		minFilter != GL_LINEAR_MIPMAP_NEAREST  && 
 		minFilter != GL_LINEAR_MIPMAP_LINEAR ) {
-		log << "TextureManager: Warning: unknown Min-Filter - setting Min-Filter to GL_NEAREST_MIPMAP_LINEAR.";
-		l->logMessage( log );
+		LOG_WARNING( TEXTURE, "TextureManager: unknown Min-Filter - setting Min-Filter to GL_NEAREST_MIPMAP_LINEAR." );
 		minFilter = GL_NEAREST_MIPMAP_LINEAR;
 	}
 	// check the magFilter
@@ -173,8 +665,7 @@ TextureManager::checkParamState( GLuint& texType,
 		minFilter != GL_NEAREST_MIPMAP_LINEAR  && 
 		minFilter != GL_LINEAR_MIPMAP_NEAREST  && 
 		minFilter != GL_LINEAR_MIPMAP_LINEAR  ) {
-		log << "TextureManager: Warning: unknown Mag-Filter - setting Mag-Filter to GL_LINEAR.";
-		l->logMessage( log );
+		LOG_WARNING( TEXTURE, "TextureManager: unknown Mag-Filter - setting Mag-Filter to GL_LINEAR." );
 		magFilter = GL_LINEAR;
 	}	
 	bool hasMipMapFilter = false;
@@ -191,14 +682,27 @@ TextureManager::checkParamState( GLuint& texType,
 void
 TextureManager::deleteTexture( Texture* t ) {
 	if( t != NULL ) {
-		if( t->isPrivate )
-			glDeleteTextures(1, &t->texID);
+		if( t->isPrivate ) {
+			// the layers of an array texture may still be decoded
+			if( mPendingLayers_.erase( t ) > 0 )
+				mDecoder_.cancel( t );
+			GLStateCache::getSingletonPtr()->deleteTextures( 1, &t->texID );
+			if( mPrivateTextures_.erase( t ) > 0 )
+				delete t;
+		}
 		else if(t->refCnt > 1)
 			t->refCnt -= 1;
 		else {
-			glDeleteTextures(1, &t->texID);
-			// delete it from the list if it is in
-			mTexturePool_.remove( *t );
+			if( t->loaded )
+				GLStateCache::getSingletonPtr()->deleteTextures( 1, &t->texID );
+			else // still decoding - the placeholder stays alive
+				mDecoder_.cancel( t );
+			// delete it from the pool if it is in
+			TexturePool::iterator it = mTexturePool_.find( t->pathID );
+			if( it != mTexturePool_.end() && it->second == t ) {
+				mTexturePool_.erase( it );
+				delete t;
+			}
 		}
 
 	}
@@ -212,5 +716,20 @@ TextureManager::destroy() {
 }
 
 TextureManager::~TextureManager() {
-	
+	// free the textures which were not deleted by their users
+	for( TexturePool::iterator it = mTexturePool_.begin(); it != mTexturePool_.end(); ++it ) {
+		if( it->second->loaded )
+			GLStateCache::getSingletonPtr()->deleteTextures( 1, &it->second->texID );
+		delete it->second;
+	}
+	for( TextureSet::iterator it = mPrivateTextures_.begin(); it != mPrivateTextures_.end(); ++it ) {
+		GLStateCache::getSingletonPtr()->deleteTextures( 1, &(*it)->texID );
+		delete *it;
+	}
+	mTexturePool_.clear();
+	mPrivateTextures_.clear();
+	if( mPlaceholder_ != 0 )
+		GLStateCache::getSingletonPtr()->deleteTextures( 1, &mPlaceholder_ );
+	if( mPlaceholderCube_ != 0 )
+		GLStateCache::getSingletonPtr()->deleteTextures( 1, &mPlaceholderCube_ );
 }
@@ -7,11 +7,13 @@
 #include <IL/il.h>
 
 #include <Texture.h>
+#include <TextureDecoder.h>
 #include <LogManager.h>
 #include <RessourceManager.h>
+#include <HashMap.h>
 
-#include <list>
 #include <string>
+#include <vector>
 
 /** This class provides an interface for loading textures.
  * It also takes care of not double loading any texture since it will safe all previously 
@@ -29,13 +31,14 @@ class TextureManager {
 		static TextureManager* getSingletonPtr( );
         /** This function simply loads a texture from a file and returns the ID of this texture.
 		 * @param tex The name of the Texture.
-		 * @param texType The type of Texture (currently only GLTEXTURE_2D is possible).
+		 * @param texType The type of Texture: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP. For cube maps the image has to be an equirectangular panorama, which is converted into the six faces.
 		 * @param minFilter The type of Min Filter to use. Possible Min Filters are: GL_NEAREST, GL_LINEAR, GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST, GL_NEAREST_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR.
 		 * @param magFilter The type of Mag Filter to use. Possible Mag Filters are: GL_NEAREST, GL_LINEAR, GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST, GL_NEAREST_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR.
 		 * @param dstFormat The destination Format of the Texture. If this value is set to true, the loading routine will try to auto detect the format of the texture. 
 		 * If not, valid formats are GL_RGB, GL_RGB4, GL_RGB8, GL_RGB12, GL_RGB16, GL_RGBA, GL_RGBA4, GL_RGBA8, GL_RGBA12, GL_RGBA16, GL_LUMINANCE, GL_LUMINANCE4, GL_LUMINANCE8, GL_LUMINANCE12, GL_LUMINANCE16, GL_DEPTH16, GL_DEPTH24, GL_DEPTH32.
 		 * @param forceReload If true, the Texture will be reloaded even if it is already loaded in a previouse step.
 		 * @note The name of the Texture has to be available in any of the Registered RessourceLogations of the RessourceManager
+		 * @note Images bigger than GL_MAX_TEXTURE_SIZE are scaled down to the largest supported power of two size.
 		 */
 		Texture* loadTexture( std::string tex, 
 							GLuint texType = GL_TEXTURE_2D, 
@@ -43,6 +46,80 @@ class TextureManager {
 							GLuint magFilter = GL_NEAREST_MIPMAP_LINEAR,
 							bool dstFormat = true,
 							bool forceReload = false );		
+		/** This function loads a texture in the background and returns immediately.
+		 * The file is decoded by a pool of worker threads. Until the pixels are uploaded by processPendingUploads(), 
+		 * the returned Texture binds a small grey placeholder, so it can be used for rendering right away.
+		 * @param tex The name of the Texture.
+		 * @param texType The type of Texture: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP (see loadTexture()).
+		 * @param minFilter The type of Min Filter to use (see loadTexture()).
+		 * @param magFilter The type of Mag Filter to use (see loadTexture()).
+		 * @param dstFormat The destination Format of the Texture (see loadTexture()).
+		 * @return The Texture or NULL if the file was not found in any RessourceLocation.
+		 * @note The Texture is shared like the ones of loadTexture(). Texture::isLoaded() tells whether the image is available.
+		 */
+		Texture* loadTextureAsync( std::string tex, 
+								GLuint texType = GL_TEXTURE_2D, 
+								GLuint minFilter = GL_NEAREST_MIPMAP_LINEAR, 
+								GLuint magFilter = GL_NEAREST_MIPMAP_LINEAR,
+								bool dstFormat = true );
+		/** This function packs several images into one array texture (GL_EXT_texture_array), so a shader can sample all of them
+		 * with a single bind. Every image becomes a layer, in the order of the names, and is resampled to the size of the layers.
+		 * The images are decoded in the background like the ones of loadTextureAsync(), a layer is grey until its image is uploaded
+		 * by processPendingUploads(). The mipmaps are built on the CPU and the layers are not compressed.
+		 * @param textures The names of the images.
+		 * @param width The width of the layers.
+		 * @param height The height of the layers. Layers bigger than the machine supports are scaled down, keeping the aspect ratio.
+		 * @param minFilter The type of Min Filter to use (see loadTexture()).
+		 * @param magFilter The type of Mag Filter to use (see loadTexture()).
+		 * @return The private array texture, which has to be deleted with deleteTexture(). NULL if array textures are not supported,
+		 * none of the images was found or there are more images than layers. The layers of missing images stay grey.
+		 * @note Texture::isLoaded() tells whether all layers are available.
+		 */
+		Texture* loadTextureArray( std::vector< std::string > const& textures,
+								   unsigned width,
+								   unsigned height,
+								   GLuint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+								   GLuint magFilter = GL_LINEAR );
+		/** This function tells whether the machine supports array textures.
+		 * @return true if loadTextureArray() can be used.
+		 */
+		bool isTextureArraySupported() const;
+		/** This function uploads the textures which were decoded in the background since the last call.
+		 * It has to be called by the thread owning the OpenGL context, usually once per frame.
+		 * @param maxUploads The maximum number of textures to upload in this call. 0 uploads all available ones.
+		 * @return The number of textures which are still being decoded.
+		 */
+		unsigned processPendingUploads( unsigned maxUploads = 0 );
+		/** This function enables the compression of the loaded textures with S3TC (DXT1 for RGB, DXT5 for RGBA images).
+		 * The compressed mip chain of every texture is stored next to the image in a cache file ('.s3tc' appended), so later
+		 * runs upload the compressed blocks directly and skip the decoding of the image. 
+		 * Only textures loaded afterwards with dstFormat == true are compressed.
+		 * @param enable If true, textures are compressed.
+		 * @return true if the compression is enabled, false if the machine does not support S3TC.
+		 */
+		bool setTextureCompression( bool enable );
+		/** This function tells whether the textures are compressed.
+		 * @return true if the textures are compressed with S3TC.
+		 */
+		bool getTextureCompression() const;
+		/** This function selects how the mipmaps of the textures are created.
+		 * By default they are built on the CPU (by the decode workers for loadTextureAsync()) with a SIMD box filter and every
+		 * level is uploaded explicitly. Otherwise GL_GENERATE_MIPMAP is used, which some drivers execute synchronously inside glTexImage2D.
+		 * @param onCPU If true, the mipmaps are built by the TextureManager, else by OpenGL.
+		 * @param gammaCorrect If true, the CPU averages the texels in linear space instead of the sRGB values.
+		 */
+		void setMipMapGeneration( bool onCPU, bool gammaCorrect = false );
+		/** This function returns the maximum texture size supported by the machine.
+		 * @return The value of GL_MAX_TEXTURE_SIZE.
+		 */
+		GLint getMaxTextureSize() const;
+		/** This function writes an image into a file, e.g. a frame read back with glReadPixels().
+		 * The encoding shares the DevIL lock with the decode workers.
+		 * @param path The path of the file. '.ppm' is written directly, other extensions (like '.png') are encoded by DevIL.
+		 * @param image The image to write, row 0 is the bottom.
+		 * @return true if the file was written, else an error is logged.
+		 */
+		bool saveImage( std::string const& path, ImageData const& image );
 		/** This will delete a Texture if no reference exists anymore (refCnt) or the Texture itself is private.
 		 * @param t A Pointer to the Texture to delete.
 		 */
@@ -56,9 +133,92 @@ class TextureManager {
 		bool checkParamState( GLuint& texType, 
 							  GLuint& minFilter, 
 							  GLuint& magFilter);
+		/** This internal function creates the OpenGL texture of a decoded image.
+		 * @param image The decoded image.
+		 * @param mipLevels The levels 1 to n of the mip chain. If NULL or empty, OpenGL generates the mipmaps.
+		 * @param unit The Texture to set up. The GL-ID and the size will be set.
+		 * @param dstFormat The destination format flag of loadTexture().
+		 * @param storeCache If true, a compressed texture is stored in the on-disk cache (only possible for plain files).
+		 * @return true if the texture was created, false if the image is too big for the machine.
+		 */
+		bool uploadTexture( ImageData const& image, std::vector< ImageData > const* mipLevels, Texture& unit, bool dstFormat, bool storeCache );
+		/** This internal function creates an OpenGL cube map.
+		 * @param faces The six faces in the order of the OpenGL targets (+X, -X, +Y, -Y, +Z, -Z).
+		 * @param mipLevels The levels 1 to n of the mip chain of every face. If NULL or empty, OpenGL generates the mipmaps.
+		 * @param unit The Texture to set up. The GL-ID and the size of a face will be set.
+		 * @param dstFormat The destination format flag of loadTexture().
+		 * @return true if the cube map was created.
+		 */
+		bool uploadCubeMap( std::vector< ImageData > const& faces, std::vector< std::vector< ImageData > > const* mipLevels,
+							Texture& unit, bool dstFormat );
+		/** This internal function creates the OpenGL texture of a compressed image read from the cache.
+		 * @param image The compressed image.
+		 * @param unit The Texture to set up. The GL-ID and the size will be set.
+		 * @return true if the texture was created, false if the image is too big or is missing the needed mip levels.
+		 */
+		bool uploadCompressed( CompressedImage const& image, Texture& unit );
+		/** This internal function returns the settings a 2D texture is built with, which the cache has to match.
+		 * @param mipMaps If true, the texture gets a mip chain.
+		 * @return The settings of the cache file.
+		 */
+		CacheSettings getCacheSettings( bool mipMaps ) const;
+		/** This internal function copies a decoded image and its mip chain into a layer of an array texture.
+		 * @param job The finished job of the layer, the image already has the size of the layers.
+		 */
+		void uploadLayer( DecodeJob const& job );
+		/** This internal function finds a Texture in the registered archives and ressource locations.
+		 * @param tex The filename of the Texture.
+		 * @param entry Is set to the archive entry, if the Texture is packed.
+		 * @return The full path of the Texture (archive path and filename for packed ones) or an empty string if it was not found.
+		 */
+		std::string resolvePath( std::string const& tex, AssetEntry& entry );
+		/** This internal function searches a shared Texture in the texture pool.
+		 * @param tex The full path of the Texture.
+		 * @return The Texture or NULL if it was not loaded before.
+		 */
+		Texture* findTexture( std::string const& tex );
+		/** This internal function stores a copy of a Texture in the texture pool.
+		 * The Texture is allocated on the heap, so the returned pointer stays valid until deleteTexture() removes it.
+		 * @param unit The Texture to store.
+		 * @return A pointer to the pooled Texture.
+		 */
+		Texture* addTexture( Texture const& unit );
+		/** This internal function maps the full path of a Texture to a unique ID.
+		 * @param tex The full path of the Texture.
+		 * @return The ID of the path. Equal paths always get the same ID.
+		 */
+		unsigned internPath( std::string const& tex );
+		/** This internal function returns the name of a Texture in the texture pool.
+		 * @param tex The full path of the Texture.
+		 * @param texType The type of the Texture.
+		 * @return The path, with a suffix for cube maps.
+		 */
+		std::string getPoolName( std::string const& tex, GLuint texType );
+		/** This internal function returns the placeholder texture, which is bound while a texture is decoded.
+		 * @param texType The type of the Texture which is decoded.
+		 * @return The GL-ID of the placeholder.
+		 */
+		GLuint getPlaceholder( GLuint texType );
 
 		TextureManager();	//!< constructor
 		~TextureManager();	//!< destructor
 
-		std::list< Texture > mTexturePool_; //!< List of previously loaded textures to avoid float load
+		typedef std::tr1::unordered_map< std::string, unsigned > PathIDMap;
+		typedef std::tr1::unordered_map< unsigned, Texture* > TexturePool;
+		typedef std::tr1::unordered_set< Texture* > TextureSet;
+		typedef std::tr1::unordered_map< Texture*, unsigned > LayerCountMap;
+
+		PathIDMap	mPathIDs_;		//!< The IDs of all paths ever loaded
+		TexturePool mTexturePool_;	//!< The shared textures by the ID of their path, to avoid double load
+		TextureSet	mPrivateTextures_;	//!< The private textures, which are not shared
+		LayerCountMap mPendingLayers_;	//!< The number of layers of every array texture which are still decoded
+		TextureDecoder mDecoder_;	//!< The worker threads decoding the textures of loadTextureAsync()
+		GLint  mMaxTextureSize_;	//!< The value of GL_MAX_TEXTURE_SIZE
+		GLint  mMaxCubeMapSize_;	//!< The value of GL_MAX_CUBE_MAP_TEXTURE_SIZE (0 if cube maps are not supported)
+		GLint  mMaxArrayLayers_;	//!< The value of GL_MAX_ARRAY_TEXTURE_LAYERS_EXT (0 if array textures are not supported)
+		GLuint mPlaceholder_;		//!< The texture bound while a texture is decoded in the background
+		GLuint mPlaceholderCube_;	//!< The cube map bound while a cube map is decoded in the background
+		bool   mCompression_;		//!< If true, the textures are compressed with S3TC and cached on disk
+		bool   mCPUMipMaps_;		//!< If true, the mipmaps are built on the CPU instead of GL_GENERATE_MIPMAP
+		bool   mGammaMipMaps_;		//!< If true, the mipmaps are built in linear space
 };
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <assetpacker.h>
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/types.h>
+	#include <sys/stat.h>
+#endif
+
+/** This function reads a whole file into memory.
+ */
+static bool
+readFile( std::string const& path, std::vector< unsigned char >& data ) {
+	std::ifstream file( path.c_str(), std::ios::in | std::ios::binary );
+	if( !file )
+		return false;
+	file.seekg( 0, std::ios::end );
+	std::streamoff size = file.tellg();
+	file.seekg( 0, std::ios::beg );
+	data.resize( (size_t)size );
+	if( size > 0 )
+		file.read( (char*)&data[0], size );
+	return !file.fail();
+}
+
+/** This function lists the regular files of a directory (not recursive).
+ * @return false if path is no directory.
+ */
+static bool
+listDirectory( std::string path, std::vector< std::string >& files ) {
+	if( path[path.length() - 1] != '/' && path[path.length() - 1] != '\\' )
+		path.append( "/" );
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE h = FindFirstFileA( ( path + "*" ).c_str(), &data );
+	if( h == INVALID_HANDLE_VALUE )
+		return false;
+	do {
+		if( !( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) )
+			files.push_back( path + data.cFileName );
+	} while( FindNextFileA( h, &data ) );
+	FindClose( h );
+#else
+	DIR* dir = opendir( path.c_str() );
+	if( dir == NULL )
+		return false;
+	struct dirent* entry;
+	while( ( entry = readdir( dir ) ) != NULL ) {
+		std::string name = path + entry->d_name;
+		struct stat st;
+		if( stat( name.c_str(), &st ) == 0 && S_ISREG( st.st_mode ) )
+			files.push_back( name );
+	}
+	closedir( dir );
+#endif
+	return true;
+}
+
+/** This function strips the directories of a path, since the RessourceManager looks files up by their plain names.
+ */
+static std::string
+baseName( std::string const& path ) {
+	std::string::size_type slash = path.find_last_of( "/\\" );
+	return slash == std::string::npos ? path : path.substr( slash + 1 );
+}
+
+// Packs files into an archive which can be registered with RessourceManager::addArchiveLocation().
+// usage: assetpacker [-c] <archive> <files or directories>...
+int main( int argc, char** argv ) {
+	bool compress = false;
+	int arg = 1;
+	if( arg < argc && std::strcmp( argv[arg], "-c" ) == 0 ) {
+		compress = true;
+		++arg;
+	}
+	if( argc - arg < 2 ) {
+		std::cerr << "usage: " << argv[0] << " [-c] <archive> <files or directories>..." << std::endl;
+		std::cerr << "  -c  compress the files which get at least 5 percent smaller" << std::endl;
+		return 1;
+	}
+	std::string archive = argv[arg++];
+
+	std::vector< std::string > paths;
+	for( ; arg < argc; ++arg ) {
+		if( !listDirectory( argv[arg], paths ) )
+			paths.push_back( argv[arg] );
+	}
+
+	std::vector< std::string > names;
+	std::vector< std::vector< unsigned char > > files;
+	for( unsigned i = 0; i < paths.size(); ++i ) {
+		std::string name = baseName( paths[i] );
+		// don't pack the archive into itself or the caches of the TextureManager
+		if( baseName( archive ) == name || ( name.length() > 5 && name.substr( name.length() - 5 ) == ".s3tc" ) )
+			continue;
+		bool duplicate = false;
+		for( unsigned j = 0; j < names.size() && !duplicate; ++j )
+			duplicate = names[j] == name;
+		if( duplicate ) {
+			std::cerr << "Skipping '" << paths[i] << "': a file named '" << name << "' is already packed." << std::endl;
+			continue;
+		}
+		files.push_back( std::vector< unsigned char >() );
+		if( !readFile( paths[i], files.back() ) ) {
+			std::cerr << "Could not read '" << paths[i] << "'." << std::endl;
+			return 1;
+		}
+		names.push_back( name );
+		std::cout << "Packing '" << paths[i] << "' as '" << name << "' (" << files.back().size() << " bytes)" << std::endl;
+	}
+
+	std::string error;
+	if( !AssetArchive::write( archive, names, files, compress, error ) ) {
+		std::cerr << error << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << names.size() << " files to '" << archive << "'." << std::endl;
+	return 0;
+}
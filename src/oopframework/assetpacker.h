@@ -0,0 +1,2 @@
+// note that this file is only needed for the Makefile - every *.cpp file needs a corresponding *.h file for simplicity
+#include <AssetArchive.h>
@@ -1,6 +1,10 @@
 #include <RenderEngine.h>
 #include <SDL/SDL.h>
 
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
 #ifdef _WIN32
 	// in SDLmain.lib is an SDL_main entypoint
 	// we have to disable it
@@ -24,8 +28,98 @@ int main( int argc, char** argv ) {
 	flags |= SDL_GL_DOUBLEBUFFER;
 #endif
 
+	// --headless renders without a window, --frames N stops after N frames,
+	// --dump-frame N writes frame N into the file given with --dump-path (frame.ppm by default),
+	// --benchmark N measures N frames with a fixed timestep and writes a JSON report to --benchmark-out (benchmark.json),
+	// --fps N limits the frame rate, --vsync 0|1|-1 sets the swap interval (-1 is adaptive),
+	// --idle renders nothing while the animation is paused (P) and the camera doesn't move,
+	// --profile file.json records the zones of the Profiler and writes them as a Chrome trace,
+	// --gpu-timing measures the GPU time of the render passes,
+	// --scene file renders the celestial bodies of a scene file (e.g. solarsystem.scene) instead of the Earth,
+	// --no-instancing draws the bodies of the scene one by one,
+	// --fixed-function lights the Earth by the fixed function pipeline instead of the shaders,
+	// --single-pass draws the Earth with its grid and clouds in one pass instead of blending them over it,
+	// --compress-textures compresses the textures with S3TC (lossy) and caches them next to the images
+	bool headless = false;
+	unsigned frames = 0;
+	unsigned benchmark = 0;
+	std::string benchmarkPath = "benchmark.json";
+	double fps = 0.0;
+	int vsync = -2; // leave the driver default
+	bool idle = false;
+	std::string profilePath;
+	bool gpuTiming = false;
+	std::string scene;
+	bool instancing = true;
+	bool shaders = true;
+	bool singlePass = false;
+	bool compressTextures = false;
+	int dumpFrame = -1;
+	std::string dumpPath = "frame.ppm";
+	for( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		if( arg == "--headless" )
+			headless = true;
+		else if( arg == "--frames" && i + 1 < argc )
+			frames = (unsigned)std::atoi( argv[++i] );
+		else if( arg == "--dump-frame" && i + 1 < argc )
+			dumpFrame = std::atoi( argv[++i] );
+		else if( arg == "--dump-path" && i + 1 < argc )
+			dumpPath = argv[++i];
+		else if( arg == "--benchmark" && i + 1 < argc )
+			benchmark = (unsigned)std::atoi( argv[++i] );
+		else if( arg == "--benchmark-out" && i + 1 < argc )
+			benchmarkPath = argv[++i];
+		else if( arg == "--fps" && i + 1 < argc )
+			fps = std::atof( argv[++i] );
+		else if( arg == "--vsync" && i + 1 < argc )
+			vsync = std::atoi( argv[++i] );
+		else if( arg == "--idle" )
+			idle = true;
+		else if( arg == "--profile" && i + 1 < argc )
+			profilePath = argv[++i];
+		else if( arg == "--gpu-timing" )
+			gpuTiming = true;
+		else if( arg == "--scene" && i + 1 < argc )
+			scene = argv[++i];
+		else if( arg == "--no-instancing" )
+			instancing = false;
+		else if( arg == "--fixed-function" )
+			shaders = false;
+		else if( arg == "--single-pass" )
+			singlePass = true;
+		else if( arg == "--compress-textures" )
+			compressTextures = true;
+		else {
+			std::cerr << "usage: " << argv[0] << " [--headless] [--frames N] [--dump-frame N] [--dump-path file.ppm|file.png]"
+					  << " [--benchmark N] [--benchmark-out file.json] [--fps N] [--vsync 0|1|-1] [--idle]"
+					  << " [--profile trace.json] [--gpu-timing] [--scene file] [--no-instancing] [--fixed-function] [--single-pass]"
+					  << " [--compress-textures]" << std::endl;
+			return 1;
+		}
+	}
+	// nothing stops a headless run, so it ends after the dumped frame if no limit was given
+	if( headless && frames == 0 && benchmark == 0 )
+		frames = ( dumpFrame >= 0 ) ? (unsigned)dumpFrame + 1 : 1;
+
 	RenderEngine e(1024, 768, 1, flags, 
-		"Beleg 1: Universe in a nut-shell");
+		"Beleg 1: Universe in a nut-shell", headless, compressTextures);
+	e.setFrameLimit( frames );
+	if( dumpFrame >= 0 )
+		e.setFrameDump( (unsigned)dumpFrame, dumpPath );
+	e.setTargetFPS( fps );
+	if( vsync >= -1 )
+		e.setSwapInterval( vsync );
+	e.setIdleMode( idle );
+	e.setProfileOutput( profilePath );
+	e.setGPUTiming( gpuTiming );
+	e.setShaders( shaders );
+	e.setCompositing( singlePass );
+	if( !scene.empty() )
+		e.setScene( scene, instancing );
+	// the benchmark renders its own number of frames
+	if( benchmark > 0 )
+		e.setBenchmark( benchmark, 1.0 / 60.0, benchmarkPath );
 	e.startRenderLoop();
 
 	return 0;